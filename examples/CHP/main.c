@@ -31,6 +31,20 @@ static struct {
 
 static bool s_running = true;
 
+static struct {
+  purrr_texture_t *texture;
+  purrr_image_t *image;
+  bool done;
+} s_loaded;
+
+// Written by the decoder on a loader thread, read once the load callback has run on this one.
+typedef struct {
+  stbi_uc *pixels;
+  int width, height;
+} icon_t;
+
+static icon_t s_icon;
+
 void initialize_mesh(purrr_renderer_t *);
 void cleanup_mesh();
 
@@ -43,12 +57,40 @@ void key_callback(purrr_window_t *window, int key, int scancode, int action, int
   }
 }
 
+// Runs on a loader thread. stb_image can't decode into memory it's handed, it always allocates its own output,
+// so the pixels get copied into the staging memory once. That buffer is kept as the window icon instead of decoding
+// the file a second time on the main thread, a decoder that writes into a given buffer would skip the copy entirely.
+static bool decode_image(const uint8_t *file, size_t file_size, purrr_image_decode_t *decode, void *user_ptr) {
+  int w, h, c;
+  stbi_uc *pixels = stbi_load_from_memory(file, (int)file_size, &w, &h, &c, STBI_rgb_alpha);
+  if (!pixels) return false;
+
+  uint8_t *dst = purrr_image_decode_alloc(decode, (uint32_t)w, (uint32_t)h);
+  if (!dst) {
+    stbi_image_free(pixels);
+    return false;
+  }
+  memcpy(dst, pixels, (size_t)w*h*4);
+
+  icon_t *icon = user_ptr;
+  icon->pixels = pixels;
+  icon->width = w;
+  icon->height = h;
+  return true;
+}
+
+static void image_loaded(purrr_texture_t *texture, purrr_image_t *image, void *user_ptr) {
+  (void)user_ptr;
+  s_loaded.texture = texture;
+  s_loaded.image = image;
+  s_loaded.done = true;
+}
+
 int main(void) {
   const char *image_filepath = "./assets/images/chp.png";
 
   int w, h, c;
-  stbi_uc *pixels = stbi_load(image_filepath, &w, &h, &c, STBI_rgb_alpha);
-  if (!pixels) {
+  if (!stbi_info(image_filepath, &w, &h, &c)) {
     fprintf(stderr, "Failed to load image \"%s\"!\n", image_filepath);
     return 1;
   }
@@ -59,6 +101,34 @@ int main(void) {
     return 1;
   }
 
+  purrr_sampler_info_t sampler_info = {
+    .mag_filter = PURRR_SAMPLER_FILTER_LINEAR,
+    .min_filter = PURRR_SAMPLER_FILTER_LINEAR,
+    .address_mode_u = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
+    .address_mode_v = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
+    .address_mode_w = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
+  };
+
+  purrr_sampler_t *sampler = purrr_sampler_create(&sampler_info, renderer.renderer);
+  assert(sampler);
+
+  // The texture decodes on the loader's threads while the rest gets set up, the loop below polls for it.
+  purrr_image_loader_info_t loader_info = {
+    .format = PURRR_FORMAT_RGBA8RGB,
+    .sampler = sampler,
+    .decoder = decode_image,
+    .user_ptr = &s_icon,
+  };
+
+  purrr_image_loader_t *loader = purrr_image_loader_create(&loader_info, renderer.renderer);
+  assert(loader);
+
+  bool queued = purrr_image_load_file_async(loader, image_filepath, image_loaded, NULL);
+  if (!queued) {
+    fprintf(stderr, "Failed to queue image \"%s\"!\n", image_filepath);
+    return 1;
+  }
+
   char *text = "It is good day to be not dead!";
   purrr_window_set_user_ptr(renderer.window, text);
 
@@ -69,14 +139,6 @@ int main(void) {
 
   purrr_window_set_cursor(renderer.window, cursor);
 
-  purrr_window_icon_info_t icon_info = {
-    .pixels = pixels,
-    .width = w,
-    .height = h,
-  };
-
-  purrr_window_set_icons(renderer.window, &icon_info, NULL);
-
   purrr_shader_info_t vertex_shader_info = {
     .filename = "./assets/shaders/vertex.spv",
     .type = PURRR_SHADER_TYPE_VERTEX,
@@ -125,50 +187,37 @@ int main(void) {
 
   initialize_mesh(renderer.renderer);
 
-  purrr_image_info_t image_info = {
-    .width  = (uint32_t)w,
-    .height = (uint32_t)h,
-    .format = PURRR_FORMAT_RGBA8RGB,
-  };
-
-  purrr_image_t *image = purrr_image_create(&image_info, renderer.renderer);
-  assert(image);
-
-  assert(purrr_image_load(image, pixels, (uint32_t)w, (uint32_t)h));
-
-  stbi_image_free(pixels);
-
-  purrr_sampler_info_t sampler_info = {
-    .mag_filter = PURRR_SAMPLER_FILTER_LINEAR,
-    .min_filter = PURRR_SAMPLER_FILTER_LINEAR,
-    .address_mode_u = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
-    .address_mode_v = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
-    .address_mode_w = PURRR_SAMPLER_ADDRESS_MODE_REPEAT,
-  };
+  while (!purrr_window_should_close(renderer.window) && s_running) {
+    if (!s_loaded.done) purrr_image_loader_poll(loader);
 
-  purrr_sampler_t *sampler = purrr_sampler_create(&sampler_info, renderer.renderer);
-  assert(sampler);
+    if (s_loaded.done && s_icon.pixels) {
+      purrr_window_icon_info_t icon_info = {
+        .pixels = s_icon.pixels,
+        .width = s_icon.width,
+        .height = s_icon.height,
+      };
 
-  purrr_texture_info_t texture_info = {
-    .image = image,
-    .sampler = sampler,
-  };
+      purrr_window_set_icons(renderer.window, &icon_info, NULL);
 
-  purrr_texture_t *texture = purrr_texture_create(&texture_info, renderer.renderer);
-  assert(texture);
+      stbi_image_free(s_icon.pixels);
+      s_icon.pixels = NULL;
+    }
 
-  while (!purrr_window_should_close(renderer.window) && s_running) {
     renderer_begin(&renderer);
 
-    purrr_renderer_begin_render_target(renderer.renderer, renderer.current_render_target);
-    purrr_renderer_bind_pipeline(renderer.renderer, pipeline);
+    purrr_clear_value_t clear_value = { .color = { 0.0f, 0.0f, 0.0f, 1.0f } };
+    purrr_renderer_begin_render_target(renderer.renderer, renderer.current_render_target, &clear_value, 1);
 
-    purrr_renderer_bind_buffer(renderer.renderer, s_mesh.vertex_buffer, 0);
-    purrr_renderer_bind_buffer(renderer.renderer, s_mesh.index_buffer, 0);
+    if (s_loaded.texture) {
+      purrr_renderer_bind_pipeline(renderer.renderer, pipeline);
 
-    purrr_renderer_bind_texture(renderer.renderer, texture, 0);
+      purrr_renderer_bind_buffer(renderer.renderer, s_mesh.vertex_buffer, 0);
+      purrr_renderer_bind_buffer(renderer.renderer, s_mesh.index_buffer, 0);
 
-    purrr_renderer_draw_indexed(renderer.renderer, 1, 0, s_mesh.index_count, 0, 0);
+      purrr_renderer_bind_texture(renderer.renderer, s_loaded.texture, 0);
+
+      purrr_renderer_draw_indexed(renderer.renderer, 1, 0, s_mesh.index_count, 0, 0);
+    }
 
     purrr_renderer_end_render_target(renderer.renderer);
 
@@ -177,10 +226,15 @@ int main(void) {
 
   purrr_renderer_wait(renderer.renderer);
 
+  purrr_image_loader_destroy(loader);
+
+  stbi_image_free(s_icon.pixels);
+
   cleanup_mesh();
 
+  purrr_texture_destroy(s_loaded.texture);
   purrr_sampler_destroy(sampler);
-  purrr_image_destroy(image);
+  purrr_image_destroy(s_loaded.image);
   purrr_pipeline_destroy(pipeline);
 
   free_renderer(&renderer);
@@ -40,6 +40,8 @@ bool create_swapchain(renderer_t *renderer) {
       .height = swapchain_height,
       .format = renderer->swapchain_format,
       .sample_count = renderer->sample_count,
+      .mip_levels = 1,
+      .usage = ((renderer->sample_count != PURRR_SAMPLE_COUNT_1)?(PURRR_IMAGE_USAGE_COLOR_TARGET | PURRR_IMAGE_USAGE_TRANSIENT):0),
     };
     renderer->color_images[i] = purrr_image_create(&info, renderer->renderer);
     assert(renderer->color_images[i]);
@@ -48,7 +50,7 @@ bool create_swapchain(renderer_t *renderer) {
   purrr_pipeline_descriptor_attachment_info_t color_attachment = {
     .format = renderer->swapchain_format,
     .load = false,
-    .store = true,
+    .store = !renderer->sample_count, // Resolved into the swapchain image otherwise
     .present_src = !renderer->sample_count,
     .sample_count = renderer->sample_count,
   };
@@ -56,6 +58,7 @@ bool create_swapchain(renderer_t *renderer) {
   purrr_pipeline_descriptor_attachment_info_t resolve_attachment = {
     .format = renderer->swapchain_format,
     .load = false,
+    .discard = true,
     .store = true,
     .present_src = true,
   };
@@ -19,6 +19,7 @@ typedef void *handle_t;
 #define PURRR_WINDOW_POS_CENTER UINT32_MAX
 #define PURRR_WINDOW_SIZE_DONT_MIND -1
 #define PURRR_WINDOW_SIZE_MAX INT32_MAX
+#define PURRR_LOD_CLAMP_NONE 1000.0f // As max_lod, samples every mip level there is
 
 // Structures
 
@@ -30,9 +31,15 @@ typedef struct purrr_image_s purrr_image_t;
 typedef struct purrr_texture_s purrr_texture_t;
 typedef struct purrr_pipeline_descriptor_s purrr_pipeline_descriptor_t;
 typedef struct purrr_render_target_s purrr_render_target_t;
+typedef struct purrr_render_target_pool_s purrr_render_target_pool_t;
 typedef struct purrr_shader_s purrr_shader_t;
 typedef struct purrr_pipeline_s purrr_pipeline_t;
+typedef struct purrr_descriptor_set_s purrr_descriptor_set_t;
 typedef struct purrr_buffer_s purrr_buffer_t;
+typedef struct purrr_upload_s purrr_upload_t;
+typedef struct purrr_image_loader_s purrr_image_loader_t;
+typedef struct purrr_image_decode_s purrr_image_decode_t;
+typedef struct purrr_readback_s purrr_readback_t;
 
 // Options
 
@@ -76,6 +83,25 @@ typedef enum {
   PURRR_FORMAT_RGBA32F,
   PURRR_FORMAT_RGBA64F,
 
+  // Block compressed formats, not every GPU supports every family (see purrr_renderer_pick_format)
+  PURRR_FORMAT_BC1U,
+  PURRR_FORMAT_BC1RGB,
+  PURRR_FORMAT_BC2U,
+  PURRR_FORMAT_BC2RGB,
+  PURRR_FORMAT_BC3U,
+  PURRR_FORMAT_BC3RGB,
+  PURRR_FORMAT_BC4U,
+  PURRR_FORMAT_BC5U,
+  PURRR_FORMAT_BC6HF,
+  PURRR_FORMAT_BC7U,
+  PURRR_FORMAT_BC7RGB,
+  PURRR_FORMAT_ETC2RGB8U,
+  PURRR_FORMAT_ETC2RGB8RGB,
+  PURRR_FORMAT_ETC2RGBA8U,
+  PURRR_FORMAT_ETC2RGBA8RGB,
+  PURRR_FORMAT_ASTC4x4U,
+  PURRR_FORMAT_ASTC4x4RGB,
+
   // Depth formats
   PURRR_FORMAT_DEPTH,
 
@@ -109,10 +135,17 @@ typedef enum {
   COUNT_PURRR_SAMPLER_ADDRESS_MODES
 } purrr_sampler_address_mode_t;
 
+typedef enum {
+  PURRR_SAMPLER_MIPMAP_MODE_LINEAR = 0,
+  PURRR_SAMPLER_MIPMAP_MODE_NEAREST,
+  COUNT_PURRR_SAMPLER_MIPMAP_MODES
+} purrr_sampler_mipmap_mode_t;
+
 typedef enum {
   PURRR_DESCRIPTOR_TYPE_TEXTURE = 0,
   PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
   PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+  PURRR_DESCRIPTOR_TYPE_TEXTURE_ARRAY, // The renderer's bindless texture array, bound along with the pipeline
   COUNT_PURRR_DESCRIPTOR_TYPES
 } purrr_descriptor_type_t;
 
@@ -123,6 +156,18 @@ typedef enum {
   COUNT_PURRR_SHADER_TYPES
 } purrr_shader_type_t;
 
+// CPU_TO_GPU - mapped, written by the CPU once in a while (the default)
+// GPU_ONLY   - written with purrr_buffer_copy, can't be mapped (unless the memory happens to be host visible)
+// GPU_TO_CPU - mapped, read back by the CPU
+// STREAM     - mapped, rewritten every frame, placed in device local memory when it's host visible
+typedef enum {
+  PURRR_MEMORY_USAGE_CPU_TO_GPU = 0,
+  PURRR_MEMORY_USAGE_GPU_ONLY,
+  PURRR_MEMORY_USAGE_GPU_TO_CPU,
+  PURRR_MEMORY_USAGE_STREAM,
+  COUNT_PURRR_MEMORY_USAGES
+} purrr_memory_usage_t;
+
 typedef enum {
   PURRR_BUFFER_TYPE_UNIFORM = 0,
   PURRR_BUFFER_TYPE_STORAGE,
@@ -131,6 +176,102 @@ typedef enum {
   COUNT_PURRR_BUFFER_TYPES
 } purrr_buffer_type_t;
 
+typedef enum {
+  PURRR_CULL_MODE_BACK = 0,
+  PURRR_CULL_MODE_FRONT,
+  PURRR_CULL_MODE_NONE,
+  PURRR_CULL_MODE_FRONT_AND_BACK,
+  COUNT_PURRR_CULL_MODES
+} purrr_cull_mode_t;
+
+typedef enum {
+  PURRR_FRONT_FACE_CLOCKWISE = 0,
+  PURRR_FRONT_FACE_COUNTER_CLOCKWISE,
+  COUNT_PURRR_FRONT_FACES
+} purrr_front_face_t;
+
+// LINE and POINT need the device to support them, creating the pipeline fails otherwise.
+typedef enum {
+  PURRR_POLYGON_MODE_FILL = 0,
+  PURRR_POLYGON_MODE_LINE,
+  PURRR_POLYGON_MODE_POINT,
+  COUNT_PURRR_POLYGON_MODES
+} purrr_polygon_mode_t;
+
+typedef enum {
+  PURRR_COMPARE_OP_LESS = 0,
+  PURRR_COMPARE_OP_LESS_OR_EQUAL,
+  PURRR_COMPARE_OP_GREATER,
+  PURRR_COMPARE_OP_GREATER_OR_EQUAL,
+  PURRR_COMPARE_OP_EQUAL,
+  PURRR_COMPARE_OP_NOT_EQUAL,
+  PURRR_COMPARE_OP_ALWAYS,
+  PURRR_COMPARE_OP_NEVER,
+  COUNT_PURRR_COMPARE_OPS
+} purrr_compare_op_t;
+
+typedef enum {
+  PURRR_BLEND_FACTOR_ZERO = 0,
+  PURRR_BLEND_FACTOR_ONE,
+  PURRR_BLEND_FACTOR_SRC_COLOR,
+  PURRR_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,
+  PURRR_BLEND_FACTOR_DST_COLOR,
+  PURRR_BLEND_FACTOR_ONE_MINUS_DST_COLOR,
+  PURRR_BLEND_FACTOR_SRC_ALPHA,
+  PURRR_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+  PURRR_BLEND_FACTOR_DST_ALPHA,
+  PURRR_BLEND_FACTOR_ONE_MINUS_DST_ALPHA,
+  COUNT_PURRR_BLEND_FACTORS
+} purrr_blend_factor_t;
+
+typedef enum {
+  PURRR_BLEND_OP_ADD = 0,
+  PURRR_BLEND_OP_SUBTRACT,
+  PURRR_BLEND_OP_REVERSE_SUBTRACT,
+  PURRR_BLEND_OP_MIN,
+  PURRR_BLEND_OP_MAX,
+  COUNT_PURRR_BLEND_OPS
+} purrr_blend_op_t;
+
+typedef enum {
+  PURRR_STENCIL_OP_KEEP = 0,
+  PURRR_STENCIL_OP_ZERO,
+  PURRR_STENCIL_OP_REPLACE,
+  PURRR_STENCIL_OP_INCREMENT_AND_CLAMP,
+  PURRR_STENCIL_OP_DECREMENT_AND_CLAMP,
+  PURRR_STENCIL_OP_INVERT,
+  PURRR_STENCIL_OP_INCREMENT_AND_WRAP,
+  PURRR_STENCIL_OP_DECREMENT_AND_WRAP,
+  COUNT_PURRR_STENCIL_OPS
+} purrr_stencil_op_t;
+
+typedef enum {
+  PURRR_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST = 0,
+  PURRR_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+  PURRR_PRIMITIVE_TOPOLOGY_LINE_LIST,
+  PURRR_PRIMITIVE_TOPOLOGY_LINE_STRIP,
+  PURRR_PRIMITIVE_TOPOLOGY_POINT_LIST,
+  COUNT_PURRR_PRIMITIVE_TOPOLOGIES
+} purrr_primitive_topology_t;
+
+// State a pipeline lets the purrr_renderer_set_* commands change. Set with VK_EXT_extended_dynamic_state(2/3) where
+// the device has it, otherwise every combination that gets drawn with is baked into a pipeline of its own on first use.
+// Those are compiled in the background like purrr_pipeline_create_async, draws with a combination are skipped until it's ready.
+typedef uint32_t purrr_dynamic_state_t;
+
+enum purrr_dynamic_state_e {
+  PURRR_DYNAMIC_STATE_CULL_MODE        = (1 << 0),
+  PURRR_DYNAMIC_STATE_FRONT_FACE       = (1 << 1),
+  PURRR_DYNAMIC_STATE_TOPOLOGY         = (1 << 2),
+  PURRR_DYNAMIC_STATE_POLYGON_MODE     = (1 << 3),
+  PURRR_DYNAMIC_STATE_DEPTH_TEST       = (1 << 4),
+  PURRR_DYNAMIC_STATE_DEPTH_WRITE      = (1 << 5),
+  PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP = (1 << 6),
+  PURRR_DYNAMIC_STATE_DEPTH_BIAS       = (1 << 7),
+  PURRR_DYNAMIC_STATE_STENCIL_TEST     = (1 << 8),
+  PURRR_DYNAMIC_STATE_BLEND            = (1 << 9), // Only whether it's enabled, the factors and ops stay in the state block
+};
+
 // Callbacks
 
 typedef void (*purrr_key_callback_t)(purrr_window_t* window, int key, int scancode, int action, int mods);
@@ -184,27 +325,111 @@ typedef struct {
   purrr_sampler_address_mode_t address_mode_u;
   purrr_sampler_address_mode_t address_mode_v;
   purrr_sampler_address_mode_t address_mode_w;
+  purrr_sampler_mipmap_mode_t mipmap_mode;
+  float min_lod;
+  float max_lod; // 0 only samples the base level, PURRR_LOD_CLAMP_NONE doesn't clamp
 } purrr_sampler_info_t;
 
+typedef uint32_t purrr_image_usage_t;
+
+enum purrr_image_usage_e {
+  PURRR_IMAGE_USAGE_SAMPLED      = (1 << 0),
+  PURRR_IMAGE_USAGE_COLOR_TARGET = (1 << 1),
+  PURRR_IMAGE_USAGE_DEPTH_TARGET = (1 << 2),
+  PURRR_IMAGE_USAGE_STORAGE      = (1 << 3),
+  PURRR_IMAGE_USAGE_TRANSFER_SRC = (1 << 4), // Copies/blits from it and readbacks
+  PURRR_IMAGE_USAGE_TRANSFER_DST = (1 << 5), // Loads and copies/blits into it, mips are only generated with it (TRANSFER_SRC is added for that)
+  // Only used as a render target attachment that is neither loaded nor stored (e.g. a multisampled image that gets resolved),
+  // backed by lazily allocated memory where the device has it. Can only be combined with the target usages.
+  PURRR_IMAGE_USAGE_TRANSIENT    = (1 << 6),
+};
+
+typedef enum {
+  PURRR_IMAGE_TILING_OPTIMAL = 0,
+  // Host visible and written in place by purrr_image_load (no staging copy). Falls back to optimal tiling
+  // if the device can't create a linear image of that format and usage. A write waits for the frame in flight that
+  // last used the image, or for every frame in flight if it's read through a descriptor set or the bindless array.
+  PURRR_IMAGE_TILING_LINEAR,
+  COUNT_PURRR_IMAGE_TILINGS
+} purrr_image_tiling_t;
+
 typedef struct {
   uint32_t width, height;
   purrr_format_t format;
   purrr_sample_count_t sample_count;
+  uint32_t mip_levels; // 0 for the full chain, depth, multisampled and linear images always get 1
+  purrr_image_usage_t usage; // 0 for everything the format allows except storage and transient
+  purrr_image_tiling_t tiling;
 } purrr_image_info_t;
 
+typedef struct {
+  purrr_image_t *image;
+  uint8_t *pixels;
+  uint32_t width, height;
+} purrr_image_load_info_t;
+
+typedef enum {
+  PURRR_IMAGE_OP_COPY = 0, // Same extent on both sides, the formats need the same texel (or block) size
+  PURRR_IMAGE_OP_BLIT,     // Scaled and filtered, no compressed or multisampled images
+  PURRR_IMAGE_OP_RESOLVE,  // Multisampled source, single sampled destination of the same format
+  COUNT_PURRR_IMAGE_OPS
+} purrr_image_op_t;
+
+typedef struct {
+  uint32_t x, y;
+  uint32_t width, height; // 0 for the rest of the level
+  uint32_t mip_level;
+} purrr_image_region_t;
+
+// The source has to be loaded or rendered to, so does the destination unless the op overwrites all of it.
+typedef struct {
+  purrr_image_op_t op;
+  purrr_image_t *dst;
+  purrr_image_region_t dst_region; // Only the offset and level are used unless blitting
+  purrr_image_t *src;
+  purrr_image_region_t src_region;
+  purrr_sampler_filter_t filter; // Blits only
+} purrr_image_transfer_info_t;
+
 typedef struct {
   purrr_image_t *image;
   purrr_sampler_t *sampler;
+  // Makes the texture streamed: the pixels (tightly packed, image sized, no compressed formats) are loaded into
+  // the image, which may get evicted once the renderer's texture budget runs out. Eviction drops the whole image,
+  // not single mip levels, and until it's back a placeholder of at most 64 texels a side is bound instead.
+  // The pixels aren't copied, they're read again every time the image comes back, so they have to stay valid
+  // for as long as the texture does. The image can't be used anywhere else and has to outlive the texture.
+  // Ignored with bindless textures, the renderer can't tell which textures a frame samples from the array.
+  const uint8_t *stream_pixels;
 } purrr_texture_info_t;
 
+// Runs on a loader thread. Read the header, get memory for the texels with purrr_image_decode_alloc
+// and decode straight into it (tightly packed rows in the loader's format).
+typedef bool (*purrr_image_decoder_t)(const uint8_t *file, size_t file_size, purrr_image_decode_t *decode, void *user_ptr);
+// Runs inside purrr_image_loader_poll, the texture and the image are owned by the callee (both NULL on failure).
+typedef void (*purrr_image_loaded_cb)(purrr_texture_t *texture, purrr_image_t *image, void *user_ptr);
+
+typedef struct {
+  uint32_t thread_count; // 0 for one per core
+  uint32_t staging_size; // 0 for 64MiB, every decoded image has to fit
+  purrr_format_t format;
+  uint32_t mip_levels;
+  purrr_sampler_t *sampler;
+  purrr_image_decoder_t decoder;
+  void *user_ptr; // Passed to the decoder
+} purrr_image_loader_info_t;
+
 typedef struct {
   purrr_format_t format;
-  bool load;
-  bool store;
+  bool load;    // Otherwise it's cleared
+  bool discard; // Neither loaded nor cleared, for attachments that get overwritten anyway (e.g. resolves)
+  bool store;   // Leave it off for multisampled attachments that are resolved, so they can be transient
   bool present_src; // Set to true if it's a swapchain image.
   purrr_sample_count_t sample_count;
 } purrr_pipeline_descriptor_attachment_info_t;
 
+#define PURRR_MAX_COLOR_ATTACHMENTS 8
+
 typedef struct {
   purrr_pipeline_descriptor_attachment_info_t *color_attachments;
   purrr_pipeline_descriptor_attachment_info_t *resolve_attachments;
@@ -242,6 +467,68 @@ typedef struct {
   size_t buffer_size;
 } purrr_shader_info_t;
 
+// Binding i of the set takes bindings[i], the bindless texture array can't be part of a set.
+typedef struct {
+  purrr_descriptor_type_t *bindings;
+  uint32_t binding_count;
+} purrr_descriptor_set_info_t;
+
+// What goes into one binding of a descriptor set, `texture` for texture bindings, `buffer` for the rest.
+typedef struct {
+  purrr_texture_t *texture; // Streamed textures can't be written into sets, bind them on their own
+  purrr_buffer_t *buffer;
+  uint32_t offset; // Aligned like purrr_renderer_bind_buffer_range offsets
+  uint32_t size; // 0 for the rest of the buffer
+} purrr_descriptor_write_t;
+
+// color = src_color*src + dst_color*dst (with color_op), same goes for alpha.
+typedef struct {
+  bool enable;
+  purrr_blend_factor_t src_color;
+  purrr_blend_factor_t dst_color;
+  purrr_blend_op_t color_op;
+  purrr_blend_factor_t src_alpha;
+  purrr_blend_factor_t dst_alpha;
+  purrr_blend_op_t alpha_op;
+} purrr_pipeline_blend_t;
+
+typedef struct {
+  purrr_stencil_op_t fail_op;
+  purrr_stencil_op_t pass_op;
+  purrr_stencil_op_t depth_fail_op;
+  purrr_compare_op_t compare_op;
+  uint32_t compare_mask;
+  uint32_t write_mask;
+  uint32_t reference;
+} purrr_pipeline_stencil_t;
+
+// A zeroed one culls back faces, doesn't blend and doesn't touch the depth attachment.
+typedef struct {
+  purrr_primitive_topology_t topology;
+  purrr_cull_mode_t cull_mode;
+  purrr_front_face_t front_face;
+  purrr_polygon_mode_t polygon_mode;
+
+  // One per color attachment, NULL doesn't blend any of them. They can only differ if the device supports it.
+  // With PURRR_DYNAMIC_STATE_BLEND, fill in the factors and ops of attachments that start out disabled as well.
+  purrr_pipeline_blend_t *blends;
+
+  // Only with a depth attachment
+  bool depth_test;
+  bool depth_write;
+  purrr_compare_op_t depth_compare_op;
+
+  bool depth_bias;
+  float depth_bias_constant;
+  float depth_bias_slope;
+  float depth_bias_clamp; // 0 doesn't clamp, anything else needs the device to support it
+
+  // Only with a depth attachment that has a stencil aspect
+  bool stencil_test;
+  purrr_pipeline_stencil_t stencil_front;
+  purrr_pipeline_stencil_t stencil_back;
+} purrr_pipeline_state_t;
+
 typedef struct {
   purrr_shader_t **shaders;
   uint32_t shader_count;
@@ -252,28 +539,77 @@ typedef struct {
   // bool depth;
   purrr_descriptor_type_t *descriptor_slots;
   uint32_t descriptor_slot_count;
+  // Bit per descriptor slot (of the first 32) whose resource changes every draw, those are written with
+  // purrr_renderer_push_texture/purrr_renderer_push_buffer instead of being bound. Only textures and buffers.
+  uint32_t push_descriptor_slots;
+  // Sets with several bindings, numbered after the descriptor slots and bound with purrr_renderer_bind_descriptor_set.
+  purrr_descriptor_set_info_t *descriptor_sets;
+  uint32_t descriptor_set_count;
 
   purrr_pipeline_push_constant_t *push_constants;
   uint32_t push_constant_count;
 
   purrr_sample_count_t sample_count;
+
+  // NULL keeps the defaults: back-face culling, alpha blending, and depth test and write if there's a depth attachment.
+  purrr_pipeline_state_t *state;
+  // Binding the pipeline resets these to the state block, the pipeline descriptor has to outlive the pipeline if the
+  // device can't set all of them (pipelines for other combinations may still be baked later).
+  purrr_dynamic_state_t dynamic_states;
+
+  // Bound instead while this pipeline is still compiling (see purrr_pipeline_create_async), draws are skipped without one.
+  // It should take the same descriptors and push constants.
+  purrr_pipeline_t *fallback;
 } purrr_pipeline_info_t;
 
+// How long creating a pipeline took, only filled in if VK_EXT_pipeline_creation_feedback is supported.
+typedef struct {
+  bool valid;
+  bool cache_hit; // Nothing had to be compiled, everything came out of the pipeline cache
+  uint64_t duration; // In nanoseconds
+} purrr_pipeline_stats_t;
+
 typedef struct {
   purrr_buffer_type_t type;
   uint32_t size;
+  purrr_memory_usage_t usage;
 } purrr_buffer_info_t;
 
 typedef struct {
   purrr_window_t *window;
   bool vsync;
   uint32_t image_count;
+  uint32_t transient_size; // Bytes per frame in flight for purrr_renderer_alloc_transient, 0 for the default (4MiB)
+  uint32_t readback_size; // Bytes per frame in flight for purrr_image_read_async/purrr_buffer_read_async, 0 for the default (16MiB)
+  uint64_t texture_budget; // Bytes streamed textures may keep resident, 0 to follow the driver's memory budget (or half of the device local memory)
+  // Size of the bindless texture array (PURRR_DESCRIPTOR_TYPE_TEXTURE_ARRAY), 0 disables it. Clamped to the device's limits,
+  // left disabled if VK_EXT_descriptor_indexing isn't supported.
+  uint32_t bindless_texture_count;
+  // Pipelines compiled by earlier runs are loaded from this file and the cache is written back when the renderer is
+  // destroyed, NULL keeps it in memory. Has to stay valid until then, a file from another device or driver is ignored.
+  const char *pipeline_cache_path;
 
   // Can be null I think
   purrr_format_t *swapchain_format;
   purrr_image_t ***swapchain_images;
 } purrr_renderer_info_t;
 
+// Used by attachments that aren't loaded, in the render target's image order (colors, resolves, depth).
+typedef union {
+  float color[4];
+  struct {
+    float depth;
+    uint32_t stencil;
+  } depth_stencil;
+} purrr_clear_value_t;
+
+// Returned by purrr_renderer_alloc_transient, only valid until the end of the frame it was allocated in.
+typedef struct {
+  handle_t buffer; // Owned by the renderer
+  uint32_t offset;
+  uint32_t size;
+} purrr_transient_binding_t;
+
 // Functions
 
 purrr_window_t *purrr_window_create(purrr_window_info_t *info);
@@ -294,24 +630,64 @@ void purrr_sampler_destroy(purrr_sampler_t *sampler);
 
 purrr_image_t *purrr_image_create(purrr_image_info_t *info, purrr_renderer_t *renderer);
 void purrr_image_destroy(purrr_image_t *image);
+// Fills the first mip level, the rest of the chain is generated from it (except for compressed formats).
 bool purrr_image_load(purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint32_t src_height);
+// Uploads every image in one submission, all of them have to belong to the same renderer.
+bool purrr_image_load_many(purrr_image_load_info_t *infos, uint32_t count);
 bool purrr_image_copy(purrr_image_t *dst, purrr_image_t *src, uint32_t src_width, uint32_t src_height);
+// Submits every transfer on its own right away, frames recorded afterwards see the results.
+bool purrr_image_transfer(const purrr_image_transfer_info_t *infos, uint32_t count);
+// Creates an image from a KTX2 file in memory and uploads every mip level it contains.
+// Supercompressed files, arrays, cubemaps and 3D textures aren't supported.
+purrr_image_t *purrr_image_load_ktx2(const uint8_t *data, size_t size, purrr_renderer_t *renderer);
 
 purrr_texture_t *purrr_texture_create(purrr_texture_info_t *info, purrr_renderer_t *renderer);
 void purrr_texture_destroy(purrr_texture_t *texture);
+#define PURRR_NO_TEXTURE_INDEX UINT32_MAX
+// Where the texture sits in the bindless texture array for its whole life, PURRR_NO_TEXTURE_INDEX if bindless textures are off.
+uint32_t purrr_texture_get_index(purrr_texture_t *texture);
 
 purrr_pipeline_descriptor_t *purrr_pipeline_descriptor_create(purrr_pipeline_descriptor_info_t *info, purrr_renderer_t *renderer);
 void purrr_pipeline_descriptor_destroy(purrr_pipeline_descriptor_t *pipeline_descriptor);
 
+// A set is empty until it's written, every write replaces all of its bindings (writes[i] goes to binding i).
+// Sets a frame in flight may still use get a new descriptor set instead of being updated, so they can be written any time.
+purrr_descriptor_set_t *purrr_descriptor_set_create(purrr_descriptor_set_info_t *info, purrr_renderer_t *renderer);
+bool purrr_descriptor_set_write(purrr_descriptor_set_t *set, const purrr_descriptor_write_t *writes);
+void purrr_descriptor_set_destroy(purrr_descriptor_set_t *set);
+
 purrr_render_target_t *purrr_render_target_create(purrr_render_target_info_t *info, purrr_renderer_t *renderer);
 purrr_image_t *purrr_render_target_get_image(purrr_render_target_t *render_target, uint32_t image_index);
 void purrr_render_target_destroy(purrr_render_target_t *render_target);
 
+// Hands out images that only live for (part of) the frame being recorded. Images that aren't acquired at the same
+// time share memory, so a chain of passes only costs as much as the most any point of it needs. The same requests
+// get the same images back every frame, ones that weren't requested for a few frames are destroyed.
+// Transient images don't share memory, each gets lazily allocated memory of its own where the device has it.
+purrr_render_target_pool_t *purrr_render_target_pool_create(purrr_renderer_t *renderer);
+// Has to be called between begin_frame and end_frame, outside of a render target. Mip levels and tiling are ignored,
+// the contents are undefined until the image is rendered to. Don't destroy the image, it belongs to the pool.
+purrr_image_t *purrr_render_target_pool_acquire(purrr_render_target_pool_t *pool, purrr_image_info_t *info);
+// Call once the last command using the image is recorded, its memory can then be handed out again. Images that are
+// still acquired at the end of the frame are released then.
+void purrr_render_target_pool_release(purrr_render_target_pool_t *pool, purrr_image_t *image);
+// A render target for the current frame, all images have to be acquired from this pool. Don't destroy it either.
+purrr_render_target_t *purrr_render_target_pool_get_render_target(purrr_render_target_pool_t *pool, purrr_render_target_info_t *info);
+void purrr_render_target_pool_destroy(purrr_render_target_pool_t *pool);
+
 purrr_shader_t *purrr_shader_create(purrr_shader_info_t *info, purrr_renderer_t *renderer);
 void purrr_shader_destroy(purrr_shader_t *shader);
 
+// Pipelines created from an identical description share one backend pipeline, which lives until all of them are destroyed.
 purrr_pipeline_t *purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_renderer_t *renderer);
 void purrr_pipeline_destroy(purrr_pipeline_t *pipeline);
+// Returns right away and compiles the pipeline on a worker thread, it can be bound before that's done (see fallback).
+// Destroying a shader or pipeline descriptor waits for the compiles still using it.
+purrr_pipeline_t *purrr_pipeline_create_async(purrr_pipeline_info_t *info, purrr_renderer_t *renderer);
+// False until the pipeline is compiled, and for good if compiling it failed.
+bool purrr_pipeline_is_ready(purrr_pipeline_t *pipeline);
+// Returns false if there are no stats for the pipeline. Shared pipelines report the stats of their first creation.
+bool purrr_pipeline_get_stats(purrr_pipeline_t *pipeline, purrr_pipeline_stats_t *stats);
 
 purrr_buffer_t *purrr_buffer_create(purrr_buffer_info_t *info, purrr_renderer_t *renderer);
 void purrr_buffer_destroy(purrr_buffer_t *buffer);
@@ -319,6 +695,36 @@ bool purrr_buffer_copy(purrr_buffer_t *buffer, void *data, uint32_t size, uint32
 bool purrr_buffer_map(purrr_buffer_t *buffer, void **data);
 void purrr_buffer_unmap(purrr_buffer_t *buffer);
 
+// Uploads are recorded into a batch and executed on a transfer queue (if the device has one) without blocking
+// the render loop. Destination resources must not be in use while the batch runs, and must not be used by
+// the renderer before purrr_upload_is_done returns true (or purrr_upload_wait returns).
+purrr_upload_t *purrr_upload_begin(purrr_renderer_t *renderer);
+bool purrr_upload_buffer(purrr_upload_t *upload, purrr_buffer_t *buffer, void *data, uint32_t size, uint32_t offset);
+bool purrr_upload_image(purrr_upload_t *upload, purrr_image_t *image, uint8_t *src, uint32_t src_width, uint32_t src_height);
+bool purrr_upload_submit(purrr_upload_t *upload);
+bool purrr_upload_is_done(purrr_upload_t *upload);
+void purrr_upload_wait(purrr_upload_t *upload);
+void purrr_upload_destroy(purrr_upload_t *upload); // Waits for the upload if it was submitted
+
+// Reads and decodes files on a pool of threads, uploads happen on the thread calling purrr_image_loader_poll.
+purrr_image_loader_t *purrr_image_loader_create(purrr_image_loader_info_t *info, purrr_renderer_t *renderer);
+void purrr_image_loader_destroy(purrr_image_loader_t *loader); // Finishes every pending load first
+bool purrr_image_load_file_async(purrr_image_loader_t *loader, const char *filename, purrr_image_loaded_cb callback, void *user_ptr);
+// Submits decoded images and calls back for the ones the GPU is done with, returns how many loads are still pending.
+uint32_t purrr_image_loader_poll(purrr_image_loader_t *loader);
+// Blocks until the loader has enough staging memory, NULL if the image can never fit.
+uint8_t *purrr_image_decode_alloc(purrr_image_decode_t *decode, uint32_t width, uint32_t height);
+
+// Readbacks are recorded into the current frame (between purrr_renderer_begin_frame and purrr_renderer_end_frame, outside
+// of a render target) and are done once the GPU finished that frame. Only the first mip level of single sampled color images
+// can be read, the data is tightly packed like purrr_image_load expects it.
+purrr_readback_t *purrr_image_read_async(purrr_image_t *image);
+purrr_readback_t *purrr_buffer_read_async(purrr_buffer_t *buffer, uint32_t size, uint32_t offset);
+bool purrr_readback_is_done(purrr_readback_t *readback);
+bool purrr_readback_wait(purrr_readback_t *readback); // Fails if the frame it was recorded in wasn't submitted yet
+const void *purrr_readback_get_data(purrr_readback_t *readback, uint32_t *size); // NULL until it's done, or if it failed
+void purrr_readback_destroy(purrr_readback_t *readback);
+
 // Callbacks
 
 typedef void (*purrr_renderer_resize_cb)(purrr_renderer_t *);
@@ -332,13 +738,48 @@ void  purrr_renderer_set_user_pointer(purrr_renderer_t *renderer, void *ptr);
 void purrr_renderer_set_resize_callback(purrr_renderer_t *renderer, purrr_renderer_resize_cb cb);
 
 uint32_t purrr_renderer_get_sample_counts(purrr_renderer_t *renderer, purrr_sample_count_t **array);
+bool purrr_renderer_is_format_supported(purrr_renderer_t *renderer, purrr_format_t format);
+// Returns the first supported candidate or PURRR_FORMAT_UNDEFINED, e.g. { BC7U, ASTC4x4U, ETC2RGBA8U, RGBA8U }.
+purrr_format_t purrr_renderer_pick_format(purrr_renderer_t *renderer, const purrr_format_t *candidates, uint32_t count);
 
 void purrr_renderer_begin_frame(purrr_renderer_t *renderer, uint32_t *image_index);
-void purrr_renderer_begin_render_target(purrr_renderer_t *renderer, purrr_render_target_t *render_target);
+// Attachments without a clear value get black (depth 1.0), clear_values can be NULL.
+void purrr_renderer_begin_render_target(purrr_renderer_t *renderer, purrr_render_target_t *render_target, const purrr_clear_value_t *clear_values, uint32_t clear_value_count);
 void purrr_renderer_bind_pipeline(purrr_renderer_t *renderer, purrr_pipeline_t *pipeline);
 void purrr_renderer_bind_texture(purrr_renderer_t *renderer, purrr_texture_t *texture, uint32_t slot_index);
 void purrr_renderer_bind_buffer(purrr_renderer_t *renderer, purrr_buffer_t *buffer, uint32_t slot_index);
+// Uniform/storage offsets have to be aligned to the device's min*BufferOffsetAlignment (256 is always safe), index offsets to 4.
+// Uniform/storage sizes can't go over the device's max*BufferRange (16384 for uniforms is always safe).
+void purrr_renderer_bind_buffer_range(purrr_renderer_t *renderer, purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size);
+// `slot_index` is the set number, descriptor slots come first. Only sets with the same bindings as the pipeline's set fit.
+void purrr_renderer_bind_descriptor_set(purrr_renderer_t *renderer, purrr_descriptor_set_t *set, uint32_t slot_index);
 void purrr_renderer_push_constant(purrr_renderer_t *renderer, uint32_t offset, uint32_t size, const void *value);
+// Write the descriptor of a push descriptor slot straight into the frame, the pipeline has to be bound first.
+// Uses VK_KHR_push_descriptor for one slot of the pipeline if it's supported, sets that only live for the frame otherwise.
+void purrr_renderer_push_texture(purrr_renderer_t *renderer, purrr_texture_t *texture, uint32_t slot_index);
+// `size` 0 pushes the rest of the buffer, offsets are aligned like purrr_renderer_bind_buffer_range ones.
+void purrr_renderer_push_buffer(purrr_renderer_t *renderer, purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size);
+
+// Change the state the bound pipeline has in its dynamic_states, until the next pipeline is bound.
+void purrr_renderer_set_cull_mode(purrr_renderer_t *renderer, purrr_cull_mode_t cull_mode);
+void purrr_renderer_set_front_face(purrr_renderer_t *renderer, purrr_front_face_t front_face);
+void purrr_renderer_set_topology(purrr_renderer_t *renderer, purrr_primitive_topology_t topology);
+void purrr_renderer_set_polygon_mode(purrr_renderer_t *renderer, purrr_polygon_mode_t polygon_mode);
+void purrr_renderer_set_depth_test(purrr_renderer_t *renderer, bool enable);
+void purrr_renderer_set_depth_write(purrr_renderer_t *renderer, bool enable);
+void purrr_renderer_set_depth_compare_op(purrr_renderer_t *renderer, purrr_compare_op_t compare_op);
+void purrr_renderer_set_depth_bias(purrr_renderer_t *renderer, bool enable);
+void purrr_renderer_set_stencil_test(purrr_renderer_t *renderer, bool enable);
+// Only for attachments the pipeline's state block has a blend for (or without a state block).
+void purrr_renderer_set_blend(purrr_renderer_t *renderer, uint32_t attachment_index, bool enable);
+
+// Bump allocates from a per frame in flight buffer, which is reset once the GPU is done with that frame.
+// Must be called between purrr_renderer_begin_frame and purrr_renderer_end_frame.
+bool purrr_renderer_alloc_transient(purrr_renderer_t *renderer, uint32_t size, uint32_t align, void **ptr, purrr_transient_binding_t *binding);
+// Binds transient memory as `type`, uniform and storage bindings use dynamic offsets into one descriptor set.
+void purrr_renderer_bind_transient(purrr_renderer_t *renderer, const purrr_transient_binding_t *binding, purrr_buffer_type_t type, uint32_t slot_index);
+// Records a copy/blit/resolve into the current frame, between render targets.
+bool purrr_renderer_transfer_image(purrr_renderer_t *renderer, const purrr_image_transfer_info_t *info);
 
 void purrr_renderer_draw(purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t vertex_count, uint32_t first_vertex);
 void purrr_renderer_draw_indexed(purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t index_count, uint32_t first_index, int32_t vertex_offset);
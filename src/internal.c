@@ -13,6 +13,11 @@ FREE_FUNC(_purrr_texture_t, texture)
 FREE_FUNC(_purrr_pipeline_descriptor_t, pipeline_descriptor)
 FREE_FUNC(_purrr_shader_t, shader)
 FREE_FUNC(_purrr_pipeline_t, pipeline)
+FREE_FUNC(_purrr_descriptor_set_t, descriptor_set)
 FREE_FUNC(_purrr_render_target_t, render_target)
+FREE_FUNC(_purrr_render_target_pool_t, render_target_pool)
 FREE_FUNC(_purrr_buffer_t, buffer)
+FREE_FUNC(_purrr_upload_t, upload)
+FREE_FUNC(_purrr_image_loader_t, image_loader)
+FREE_FUNC(_purrr_readback_t, readback)
 FREE_FUNC(_purrr_renderer_t, renderer)
\ No newline at end of file
@@ -33,10 +33,18 @@ typedef bool (*_purrr_image_init_t)(_purrr_image_t *);
 typedef void (*_purrr_image_cleanup_t)(_purrr_image_t *);
 typedef bool (*_purrr_image_load_t)(_purrr_image_t *, uint8_t *, uint32_t, uint32_t);
 typedef bool (*_purrr_image_copy_t)(_purrr_image_t *, _purrr_image_t *, uint32_t, uint32_t);
+typedef bool (*_purrr_image_load_many_t)(purrr_image_load_info_t *, uint32_t);
+typedef bool (*_purrr_image_transfer_t)(const purrr_image_transfer_info_t *, uint32_t);
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+} _purrr_image_level_t;
+typedef bool (*_purrr_image_load_levels_t)(_purrr_image_t *, const _purrr_image_level_t *, uint32_t);
 
 typedef struct _purrr_texture_s _purrr_texture_t;
 typedef bool (*_purrr_texture_init_t)(_purrr_texture_t *);
 typedef void (*_purrr_texture_cleanup_t)(_purrr_texture_t *);
+typedef uint32_t (*_purrr_texture_get_index_t)(_purrr_texture_t *);
 
 typedef struct _purrr_pipeline_descriptor_s _purrr_pipeline_descriptor_t;
 typedef bool (*_purrr_pipeline_descriptor_init_t)(_purrr_pipeline_descriptor_t *);
@@ -49,12 +57,26 @@ typedef void (*_purrr_shader_cleanup_t)(_purrr_shader_t *);
 typedef struct _purrr_pipeline_s _purrr_pipeline_t;
 typedef bool (*_purrr_pipeline_init_t)(_purrr_pipeline_t *);
 typedef void (*_purrr_pipeline_cleanup_t)(_purrr_pipeline_t *);
+typedef bool (*_purrr_pipeline_get_stats_t)(_purrr_pipeline_t *, purrr_pipeline_stats_t *);
+typedef bool (*_purrr_pipeline_is_ready_t)(_purrr_pipeline_t *);
+
+typedef struct _purrr_descriptor_set_s _purrr_descriptor_set_t;
+typedef bool (*_purrr_descriptor_set_init_t)(_purrr_descriptor_set_t *);
+typedef void (*_purrr_descriptor_set_cleanup_t)(_purrr_descriptor_set_t *);
+typedef bool (*_purrr_descriptor_set_write_t)(_purrr_descriptor_set_t *, const purrr_descriptor_write_t *);
 
 typedef struct _purrr_render_target_s _purrr_render_target_t;
 typedef bool (*_purrr_render_target_init_t)(_purrr_render_target_t *);
 typedef void (*_purrr_render_target_cleanup_t)(_purrr_render_target_t *);
 typedef _purrr_image_t *(*_purrr_render_target_get_image_t)(_purrr_render_target_t *, uint32_t);
 
+typedef struct _purrr_render_target_pool_s _purrr_render_target_pool_t;
+typedef bool (*_purrr_render_target_pool_init_t)(_purrr_render_target_pool_t *);
+typedef void (*_purrr_render_target_pool_cleanup_t)(_purrr_render_target_pool_t *);
+typedef _purrr_image_t *(*_purrr_render_target_pool_acquire_t)(_purrr_render_target_pool_t *, purrr_image_info_t *);
+typedef void (*_purrr_render_target_pool_release_t)(_purrr_render_target_pool_t *, _purrr_image_t *);
+typedef _purrr_render_target_t *(*_purrr_render_target_pool_get_render_target_t)(_purrr_render_target_pool_t *, purrr_render_target_info_t *);
+
 typedef struct _purrr_buffer_s _purrr_buffer_t;
 typedef bool (*_purrr_buffer_init_t)(_purrr_buffer_t *);
 typedef void (*_purrr_buffer_cleanup_t)(_purrr_buffer_t *);
@@ -62,16 +84,47 @@ typedef bool (*_purrr_buffer_copy_t)(_purrr_buffer_t *, void *, uint32_t, uint32
 typedef bool (*_purrr_buffer_map_t)(_purrr_buffer_t *, void **);
 typedef bool (*_purrr_buffer_unmap_t)(_purrr_buffer_t *);
 
+typedef struct _purrr_upload_s _purrr_upload_t;
+typedef bool (*_purrr_upload_init_t)(_purrr_upload_t *);
+typedef void (*_purrr_upload_cleanup_t)(_purrr_upload_t *);
+typedef bool (*_purrr_upload_buffer_t)(_purrr_upload_t *, _purrr_buffer_t *, void *, uint32_t, uint32_t);
+typedef bool (*_purrr_upload_image_t)(_purrr_upload_t *, _purrr_image_t *, uint8_t *, uint32_t, uint32_t);
+typedef bool (*_purrr_upload_submit_t)(_purrr_upload_t *);
+typedef bool (*_purrr_upload_is_done_t)(_purrr_upload_t *);
+typedef bool (*_purrr_upload_wait_t)(_purrr_upload_t *);
+
+typedef struct _purrr_readback_s _purrr_readback_t;
+typedef bool (*_purrr_readback_init_t)(_purrr_readback_t *);
+typedef void (*_purrr_readback_cleanup_t)(_purrr_readback_t *);
+typedef bool (*_purrr_readback_is_done_t)(_purrr_readback_t *);
+typedef bool (*_purrr_readback_wait_t)(_purrr_readback_t *);
+
+typedef struct _purrr_image_loader_s _purrr_image_loader_t;
+typedef bool (*_purrr_image_loader_init_t)(_purrr_image_loader_t *);
+typedef void (*_purrr_image_loader_cleanup_t)(_purrr_image_loader_t *);
+typedef bool (*_purrr_image_loader_load_file_t)(_purrr_image_loader_t *, const char *, purrr_image_loaded_cb, void *);
+typedef uint32_t (*_purrr_image_loader_poll_t)(_purrr_image_loader_t *);
+typedef uint8_t *(*_purrr_image_loader_alloc_t)(_purrr_image_loader_t *, void *, uint32_t, uint32_t);
+
 typedef struct _purrr_renderer_s _purrr_renderer_t;
 typedef bool (*_purrr_renderer_init_t)(_purrr_renderer_t *);
 typedef void (*_purrr_renderer_cleanup_t)(_purrr_renderer_t *);
 typedef uint32_t (*_purrr_renderer_get_sample_counts_t)(_purrr_renderer_t *, purrr_sample_count_t **);
+typedef bool (*_purrr_renderer_is_format_supported_t)(_purrr_renderer_t *, purrr_format_t);
 typedef bool (*_purrr_renderer_begin_frame_t)(_purrr_renderer_t *, uint32_t *);
-typedef bool (*_purrr_renderer_begin_render_target_t)(_purrr_renderer_t *, _purrr_render_target_t *);
+typedef bool (*_purrr_renderer_begin_render_target_t)(_purrr_renderer_t *, _purrr_render_target_t *, const purrr_clear_value_t *, uint32_t);
 typedef bool (*_purrr_renderer_bind_pipeline_t)(_purrr_renderer_t *, _purrr_pipeline_t *);
 typedef bool (*_purrr_renderer_bind_texture_t)(_purrr_renderer_t *, _purrr_texture_t *, uint32_t);
 typedef bool (*_purrr_renderer_bind_buffer_t)(_purrr_renderer_t *, _purrr_buffer_t *, uint32_t);
+typedef bool (*_purrr_renderer_bind_buffer_range_t)(_purrr_renderer_t *, _purrr_buffer_t *, uint32_t, uint32_t, uint32_t);
+typedef bool (*_purrr_renderer_bind_descriptor_set_t)(_purrr_renderer_t *, _purrr_descriptor_set_t *, uint32_t);
 typedef bool (*_purrr_renderer_push_constant_t)(_purrr_renderer_t *, uint32_t, uint32_t, const void *);
+typedef bool (*_purrr_renderer_push_texture_t)(_purrr_renderer_t *, _purrr_texture_t *, uint32_t);
+typedef bool (*_purrr_renderer_push_buffer_t)(_purrr_renderer_t *, _purrr_buffer_t *, uint32_t, uint32_t, uint32_t);
+typedef bool (*_purrr_renderer_set_dynamic_state_t)(_purrr_renderer_t *, purrr_dynamic_state_t, uint32_t, uint32_t);
+typedef bool (*_purrr_renderer_alloc_transient_t)(_purrr_renderer_t *, uint32_t, uint32_t, void **, purrr_transient_binding_t *);
+typedef bool (*_purrr_renderer_transfer_image_t)(_purrr_renderer_t *, const purrr_image_transfer_info_t *);
+typedef bool (*_purrr_renderer_bind_transient_t)(_purrr_renderer_t *, const purrr_transient_binding_t *, purrr_buffer_type_t, uint32_t);
 typedef bool (*_purrr_renderer_draw_t)(_purrr_renderer_t *, uint32_t, uint32_t, uint32_t, uint32_t);
 typedef bool (*_purrr_renderer_draw_indexed_t)(_purrr_renderer_t *, uint32_t, uint32_t, uint32_t, uint32_t, int32_t);
 typedef bool (*_purrr_renderer_end_render_target_t)(_purrr_renderer_t *);
@@ -102,21 +155,29 @@ struct _purrr_image_s {
   bool initialized;
   _purrr_renderer_t *renderer;
   purrr_image_info_t info;
+  _purrr_render_target_pool_t *pool; // Owns the image (and its memory) if set
 
   _purrr_image_init_t init;
   _purrr_image_cleanup_t cleanup;
   _purrr_image_load_t load;
   _purrr_image_copy_t copy;
+  _purrr_image_load_many_t load_many;
+  _purrr_image_load_levels_t load_levels;
+  _purrr_image_transfer_t transfer;
 
   void *data_ptr;
 };
 
 void _purrr_image_free(_purrr_image_t *image);
+_purrr_image_t *_purrr_image_create(purrr_image_info_t *info, _purrr_renderer_t *renderer, _purrr_render_target_pool_t *pool);
 
 bool _purrr_image_vulkan_init(_purrr_image_t *image);
 void _purrr_image_vulkan_cleanup(_purrr_image_t *image);
 bool _purrr_image_vulkan_load(_purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint32_t src_height);
 bool _purrr_image_vulkan_copy(_purrr_image_t *dst, _purrr_image_t *src, uint32_t src_width, uint32_t src_height);
+bool _purrr_image_vulkan_load_many(purrr_image_load_info_t *infos, uint32_t count);
+bool _purrr_image_vulkan_load_levels(_purrr_image_t *dst, const _purrr_image_level_t *levels, uint32_t level_count);
+bool _purrr_image_vulkan_transfer(const purrr_image_transfer_info_t *infos, uint32_t count);
 
 // texture
 
@@ -127,6 +188,7 @@ struct _purrr_texture_s {
 
   _purrr_texture_init_t init;
   _purrr_texture_cleanup_t cleanup;
+  _purrr_texture_get_index_t get_index;
 
   void *data_ptr;
 };
@@ -135,6 +197,7 @@ void _purrr_texture_free(_purrr_texture_t *texture);
 
 bool _purrr_texture_vulkan_init(_purrr_texture_t *texture);
 void _purrr_texture_vulkan_cleanup(_purrr_texture_t *texture);
+uint32_t _purrr_texture_vulkan_get_index(_purrr_texture_t *texture);
 
 // pipeline descriptor (render pass)
 
@@ -183,6 +246,8 @@ struct _purrr_pipeline_s {
 
   _purrr_pipeline_init_t init;
   _purrr_pipeline_cleanup_t cleanup;
+  _purrr_pipeline_get_stats_t get_stats;
+  _purrr_pipeline_is_ready_t is_ready;
 
   void *data_ptr;
 };
@@ -190,7 +255,30 @@ struct _purrr_pipeline_s {
 void _purrr_pipeline_free(_purrr_pipeline_t *pipeline);
 
 bool _purrr_pipeline_vulkan_init(_purrr_pipeline_t *pipeline);
+bool _purrr_pipeline_vulkan_init_async(_purrr_pipeline_t *pipeline);
 void _purrr_pipeline_vulkan_cleanup(_purrr_pipeline_t *pipeline);
+bool _purrr_pipeline_vulkan_get_stats(_purrr_pipeline_t *pipeline, purrr_pipeline_stats_t *stats);
+bool _purrr_pipeline_vulkan_is_ready(_purrr_pipeline_t *pipeline);
+
+// descriptor set
+
+struct _purrr_descriptor_set_s {
+  bool initialized;
+  _purrr_renderer_t *renderer;
+  purrr_descriptor_set_info_t info; // Only valid during init
+
+  _purrr_descriptor_set_init_t init;
+  _purrr_descriptor_set_cleanup_t cleanup;
+  _purrr_descriptor_set_write_t write;
+
+  void *data_ptr;
+};
+
+void _purrr_descriptor_set_free(_purrr_descriptor_set_t *set);
+
+bool _purrr_descriptor_set_vulkan_init(_purrr_descriptor_set_t *set);
+void _purrr_descriptor_set_vulkan_cleanup(_purrr_descriptor_set_t *set);
+bool _purrr_descriptor_set_vulkan_write(_purrr_descriptor_set_t *set, const purrr_descriptor_write_t *writes);
 
 // render target (frame buffer)
 
@@ -218,6 +306,29 @@ bool _purrr_render_target_vulkan_init(_purrr_render_target_t *render_target);
 void _purrr_render_target_vulkan_cleanup(_purrr_render_target_t *render_target);
 _purrr_image_t *_purrr_render_target_vulkan_get_image(_purrr_render_target_t *render_target, uint32_t image_index);
 
+// render target pool
+
+struct _purrr_render_target_pool_s {
+  bool initialized;
+  _purrr_renderer_t *renderer;
+
+  _purrr_render_target_pool_init_t init;
+  _purrr_render_target_pool_cleanup_t cleanup;
+  _purrr_render_target_pool_acquire_t acquire;
+  _purrr_render_target_pool_release_t release;
+  _purrr_render_target_pool_get_render_target_t get_render_target;
+
+  void *data_ptr;
+};
+
+void _purrr_render_target_pool_free(_purrr_render_target_pool_t *pool);
+
+bool _purrr_render_target_pool_vulkan_init(_purrr_render_target_pool_t *pool);
+void _purrr_render_target_pool_vulkan_cleanup(_purrr_render_target_pool_t *pool);
+_purrr_image_t *_purrr_render_target_pool_vulkan_acquire(_purrr_render_target_pool_t *pool, purrr_image_info_t *info);
+void _purrr_render_target_pool_vulkan_release(_purrr_render_target_pool_t *pool, _purrr_image_t *image);
+_purrr_render_target_t *_purrr_render_target_pool_vulkan_get_render_target(_purrr_render_target_pool_t *pool, purrr_render_target_info_t *info);
+
 // buffer
 
 struct _purrr_buffer_s {
@@ -242,6 +353,93 @@ bool _purrr_buffer_vulkan_copy(_purrr_buffer_t *buffer, void *data, uint32_t siz
 bool _purrr_buffer_vulkan_map(_purrr_buffer_t *buffer, void **data);
 bool _purrr_buffer_vulkan_unmap(_purrr_buffer_t *buffer);
 
+// upload
+
+struct _purrr_upload_s {
+  bool initialized;
+  _purrr_renderer_t *renderer;
+  bool submitted;
+
+  _purrr_upload_init_t init;
+  _purrr_upload_cleanup_t cleanup;
+  _purrr_upload_buffer_t buffer;
+  _purrr_upload_image_t image;
+  _purrr_upload_submit_t submit;
+  _purrr_upload_is_done_t is_done;
+  _purrr_upload_wait_t wait;
+
+  void *data_ptr;
+};
+
+void _purrr_upload_free(_purrr_upload_t *upload);
+
+bool _purrr_upload_vulkan_init(_purrr_upload_t *upload);
+void _purrr_upload_vulkan_cleanup(_purrr_upload_t *upload);
+bool _purrr_upload_vulkan_buffer(_purrr_upload_t *upload, _purrr_buffer_t *buffer, void *data, uint32_t size, uint32_t offset);
+bool _purrr_upload_vulkan_image(_purrr_upload_t *upload, _purrr_image_t *image, uint8_t *src, uint32_t src_width, uint32_t src_height);
+bool _purrr_upload_vulkan_submit(_purrr_upload_t *upload);
+bool _purrr_upload_vulkan_is_done(_purrr_upload_t *upload);
+bool _purrr_upload_vulkan_wait(_purrr_upload_t *upload);
+
+// readback
+
+struct _purrr_readback_s {
+  bool initialized;
+  _purrr_renderer_t *renderer;
+  // Either the image or the buffer range
+  _purrr_image_t *image;
+  _purrr_buffer_t *buffer;
+  uint32_t offset;
+  uint32_t size;
+
+  bool done;
+  bool failed; // Done, but the data couldn't be copied out
+  void *data; // Copied out of the readback ring once the frame is done
+
+  _purrr_readback_init_t init;
+  _purrr_readback_cleanup_t cleanup;
+  _purrr_readback_is_done_t is_done;
+  _purrr_readback_wait_t wait;
+
+  void *data_ptr;
+};
+
+void _purrr_readback_free(_purrr_readback_t *readback);
+
+bool _purrr_readback_vulkan_init(_purrr_readback_t *readback);
+void _purrr_readback_vulkan_cleanup(_purrr_readback_t *readback);
+bool _purrr_readback_vulkan_is_done(_purrr_readback_t *readback);
+bool _purrr_readback_vulkan_wait(_purrr_readback_t *readback);
+
+// image loader
+
+struct _purrr_image_loader_s {
+  bool initialized;
+  _purrr_renderer_t *renderer;
+  purrr_image_loader_info_t info;
+
+  _purrr_image_loader_init_t init;
+  _purrr_image_loader_cleanup_t cleanup;
+  _purrr_image_loader_load_file_t load_file;
+  _purrr_image_loader_poll_t poll;
+  _purrr_image_loader_alloc_t alloc;
+
+  void *data_ptr;
+};
+
+struct purrr_image_decode_s {
+  _purrr_image_loader_t *loader;
+  void *job;
+};
+
+void _purrr_image_loader_free(_purrr_image_loader_t *loader);
+
+bool _purrr_image_loader_vulkan_init(_purrr_image_loader_t *loader);
+void _purrr_image_loader_vulkan_cleanup(_purrr_image_loader_t *loader);
+bool _purrr_image_loader_vulkan_load_file(_purrr_image_loader_t *loader, const char *filename, purrr_image_loaded_cb callback, void *user_ptr);
+uint32_t _purrr_image_loader_vulkan_poll(_purrr_image_loader_t *loader);
+uint8_t *_purrr_image_loader_vulkan_alloc(_purrr_image_loader_t *loader, void *job, uint32_t width, uint32_t height);
+
 // renderer
 
 struct _purrr_renderer_s {
@@ -252,12 +450,21 @@ struct _purrr_renderer_s {
   _purrr_renderer_init_t init;
   _purrr_renderer_cleanup_t cleanup;
   _purrr_renderer_get_sample_counts_t get_sample_counts;
+  _purrr_renderer_is_format_supported_t is_format_supported;
   _purrr_renderer_begin_frame_t begin_frame;
   _purrr_renderer_begin_render_target_t begin_render_target;
   _purrr_renderer_bind_pipeline_t bind_pipeline;
   _purrr_renderer_bind_texture_t bind_texture;
   _purrr_renderer_bind_buffer_t bind_buffer;
+  _purrr_renderer_bind_buffer_range_t bind_buffer_range;
+  _purrr_renderer_bind_descriptor_set_t bind_descriptor_set;
   _purrr_renderer_push_constant_t push_constant;
+  _purrr_renderer_push_texture_t push_texture;
+  _purrr_renderer_push_buffer_t push_buffer;
+  _purrr_renderer_set_dynamic_state_t set_dynamic_state;
+  _purrr_renderer_alloc_transient_t alloc_transient;
+  _purrr_renderer_bind_transient_t bind_transient;
+  _purrr_renderer_transfer_image_t transfer_image;
   _purrr_renderer_draw_t draw;
   _purrr_renderer_draw_indexed_t draw_indexed;
   _purrr_renderer_end_render_target_t end_render_target;
@@ -277,12 +484,21 @@ void _purrr_renderer_free(_purrr_renderer_t *renderer);
 bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer);
 void _purrr_renderer_vulkan_cleanup(_purrr_renderer_t *renderer);
 uint32_t _purrr_renderer_vulkan_get_sample_counts(_purrr_renderer_t *renderer, purrr_sample_count_t **array);
+bool _purrr_renderer_vulkan_is_format_supported(_purrr_renderer_t *renderer, purrr_format_t format);
 bool _purrr_renderer_vulkan_begin_frame(_purrr_renderer_t *renderer, uint32_t *image_index);
-bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _purrr_render_target_t *render_target);
+bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _purrr_render_target_t *render_target, const purrr_clear_value_t *clear_values, uint32_t clear_value_count);
 bool _purrr_renderer_vulkan_bind_pipeline(_purrr_renderer_t *renderer, _purrr_pipeline_t *pipeline);
 bool _purrr_renderer_vulkan_bind_texture(_purrr_renderer_t *renderer, _purrr_texture_t *texture, uint32_t slot_index);
 bool _purrr_renderer_vulkan_bind_buffer(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index);
+bool _purrr_renderer_vulkan_bind_buffer_range(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size);
+bool _purrr_renderer_vulkan_bind_descriptor_set(_purrr_renderer_t *renderer, _purrr_descriptor_set_t *set, uint32_t slot_index);
+bool _purrr_renderer_vulkan_push_texture(_purrr_renderer_t *renderer, _purrr_texture_t *texture, uint32_t slot_index);
+bool _purrr_renderer_vulkan_push_buffer(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size);
+bool _purrr_renderer_vulkan_set_dynamic_state(_purrr_renderer_t *renderer, purrr_dynamic_state_t state, uint32_t index, uint32_t value);
 bool _purrr_renderer_vulkan_push_constant(_purrr_renderer_t *renderer, uint32_t offset, uint32_t size, const void *value);
+bool _purrr_renderer_vulkan_alloc_transient(_purrr_renderer_t *renderer, uint32_t size, uint32_t align, void **ptr, purrr_transient_binding_t *binding);
+bool _purrr_renderer_vulkan_transfer_image(_purrr_renderer_t *renderer, const purrr_image_transfer_info_t *info);
+bool _purrr_renderer_vulkan_bind_transient(_purrr_renderer_t *renderer, const purrr_transient_binding_t *binding, purrr_buffer_type_t type, uint32_t slot_index);
 bool _purrr_renderer_vulkan_draw(_purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t vertex_count, uint32_t first_vertex);
 bool _purrr_renderer_vulkan_draw_indexed(_purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t index_count, uint32_t first_index, int32_t vertex_offset);
 bool _purrr_renderer_vulkan_end_render_target(_purrr_renderer_t *renderer);
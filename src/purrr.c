@@ -237,6 +237,7 @@ purrr_sampler_t *purrr_sampler_create(purrr_sampler_info_t *info, purrr_renderer
   if (!info ||
       info->mag_filter >= COUNT_PURRR_SAMPLER_FILTERS || info->min_filter >= COUNT_PURRR_SAMPLER_FILTERS ||
       info->address_mode_u >= COUNT_PURRR_SAMPLER_ADDRESS_MODES || info->address_mode_v >= COUNT_PURRR_SAMPLER_ADDRESS_MODES || info->address_mode_w >= COUNT_PURRR_SAMPLER_ADDRESS_MODES ||
+      info->mipmap_mode >= COUNT_PURRR_SAMPLER_MIPMAP_MODES || info->min_lod < 0.0f || info->max_lod < info->min_lod ||
       !renderer) return NULL;
 
   _purrr_sampler_t *internal = (_purrr_sampler_t*)malloc(sizeof(*internal));
@@ -270,21 +271,25 @@ void purrr_sampler_destroy(purrr_sampler_t *sampler) {
 
 // image
 
-purrr_image_t *purrr_image_create(purrr_image_info_t *info, purrr_renderer_t *renderer) {
-  if (!info || info->format >= COUNT_PURRR_FORMATS || info->format == PURRR_FORMAT_UNDEFINED || !renderer) return NULL;
+_purrr_image_t *_purrr_image_create(purrr_image_info_t *info, _purrr_renderer_t *renderer, _purrr_render_target_pool_t *pool) {
+  if (!info || info->format >= COUNT_PURRR_FORMATS || info->format == PURRR_FORMAT_UNDEFINED || info->tiling >= COUNT_PURRR_IMAGE_TILINGS || !renderer) return NULL;
 
   _purrr_image_t *internal = (_purrr_image_t*)malloc(sizeof(*internal));
   if (!internal) return NULL;
   memset(internal, 0, sizeof(*internal));
   internal->info = *info;
-  internal->renderer = (_purrr_renderer_t*)renderer;
+  internal->renderer = renderer;
+  internal->pool = pool;
 
-  switch (((_purrr_renderer_t*)renderer)->api) {
+  switch (renderer->api) {
   case PURRR_API_VULKAN: {
     internal->init = _purrr_image_vulkan_init;
     internal->cleanup = _purrr_image_vulkan_cleanup;
     internal->load = _purrr_image_vulkan_load;
     internal->copy = _purrr_image_vulkan_copy;
+    internal->load_many = _purrr_image_vulkan_load_many;
+    internal->load_levels = _purrr_image_vulkan_load_levels;
+    internal->transfer = _purrr_image_vulkan_transfer;
   } break;
   default: {
     assert(0 && "Unreachable");
@@ -297,11 +302,15 @@ purrr_image_t *purrr_image_create(purrr_image_info_t *info, purrr_renderer_t *re
     return NULL;
   }
 
-  return (purrr_image_t*)internal;
+  return internal;
+}
+
+purrr_image_t *purrr_image_create(purrr_image_info_t *info, purrr_renderer_t *renderer) {
+  return (purrr_image_t*)_purrr_image_create(info, (_purrr_renderer_t*)renderer, NULL);
 }
 
 void purrr_image_destroy(purrr_image_t *image) {
-  if (image) _purrr_image_free((_purrr_image_t*)image);
+  if (image && !((_purrr_image_t*)image)->pool) _purrr_image_free((_purrr_image_t*)image);
 }
 
 bool purrr_image_load(purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint32_t src_height) {
@@ -310,12 +319,130 @@ bool purrr_image_load(purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint
   return internal->load(internal, src, src_width, src_height);
 }
 
+bool purrr_image_load_many(purrr_image_load_info_t *infos, uint32_t count) {
+  assert(infos);
+  if (count == 0) return true;
+  _purrr_image_t *internal = (_purrr_image_t*)infos[0].image;
+  assert(internal && internal->load_many);
+  return internal->load_many(infos, count);
+}
+
 bool purrr_image_copy(purrr_image_t *dst, purrr_image_t *src, uint32_t src_width, uint32_t src_height) {
   _purrr_image_t *internal = (_purrr_image_t*)dst;
   assert(internal && src && internal->copy);
   return internal->copy(internal, (_purrr_image_t*)src, src_width, src_height);
 }
 
+bool purrr_image_transfer(const purrr_image_transfer_info_t *infos, uint32_t count) {
+  assert(infos);
+  if (count == 0) return true;
+  _purrr_image_t *internal = (_purrr_image_t*)infos[0].dst;
+  assert(internal && internal->transfer);
+  return internal->transfer(infos, count);
+}
+
+static uint32_t _purrr_read_u32(const uint8_t *ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+static uint64_t _purrr_read_u64(const uint8_t *ptr) {
+  uint64_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+// KTX2 stores VkFormat values no matter the api, so they're spelled out as the plain numbers the
+// KTX2 specification uses rather than pulling a backend's headers into the front-end.
+static const struct {
+  uint32_t ktx2_format;
+  purrr_format_t format;
+} _purrr_ktx2_formats[] = {
+  {   9, PURRR_FORMAT_GRAYSCALE },    // R8_UNORM
+  {  16, PURRR_FORMAT_GRAY_ALPHA },   // R8G8_UNORM
+  {  37, PURRR_FORMAT_RGBA8U },       // R8G8B8A8_UNORM
+  {  43, PURRR_FORMAT_RGBA8RGB },     // R8G8B8A8_SRGB
+  {  44, PURRR_FORMAT_BGRA8U },       // B8G8R8A8_UNORM
+  {  50, PURRR_FORMAT_BGRA8RGB },     // B8G8R8A8_SRGB
+  {  97, PURRR_FORMAT_RGBA16F },      // R16G16B16A16_SFLOAT
+  { 103, PURRR_FORMAT_RG32F },        // R32G32_SFLOAT
+  { 106, PURRR_FORMAT_RGB32F },       // R32G32B32_SFLOAT
+  { 109, PURRR_FORMAT_RGBA32F },      // R32G32B32A32_SFLOAT
+  { 121, PURRR_FORMAT_RGBA64F },      // R64G64B64A64_SFLOAT
+  { 133, PURRR_FORMAT_BC1U },         // BC1_RGBA_UNORM_BLOCK
+  { 134, PURRR_FORMAT_BC1RGB },       // BC1_RGBA_SRGB_BLOCK
+  { 135, PURRR_FORMAT_BC2U },         // BC2_UNORM_BLOCK
+  { 136, PURRR_FORMAT_BC2RGB },       // BC2_SRGB_BLOCK
+  { 137, PURRR_FORMAT_BC3U },         // BC3_UNORM_BLOCK
+  { 138, PURRR_FORMAT_BC3RGB },       // BC3_SRGB_BLOCK
+  { 139, PURRR_FORMAT_BC4U },         // BC4_UNORM_BLOCK
+  { 141, PURRR_FORMAT_BC5U },         // BC5_UNORM_BLOCK
+  { 143, PURRR_FORMAT_BC6HF },        // BC6H_UFLOAT_BLOCK
+  { 145, PURRR_FORMAT_BC7U },         // BC7_UNORM_BLOCK
+  { 146, PURRR_FORMAT_BC7RGB },       // BC7_SRGB_BLOCK
+  { 147, PURRR_FORMAT_ETC2RGB8U },    // ETC2_R8G8B8_UNORM_BLOCK
+  { 148, PURRR_FORMAT_ETC2RGB8RGB },  // ETC2_R8G8B8_SRGB_BLOCK
+  { 151, PURRR_FORMAT_ETC2RGBA8U },   // ETC2_R8G8B8A8_UNORM_BLOCK
+  { 152, PURRR_FORMAT_ETC2RGBA8RGB }, // ETC2_R8G8B8A8_SRGB_BLOCK
+  { 157, PURRR_FORMAT_ASTC4x4U },     // ASTC_4x4_UNORM_BLOCK
+  { 158, PURRR_FORMAT_ASTC4x4RGB },   // ASTC_4x4_SRGB_BLOCK
+};
+
+static purrr_format_t _purrr_ktx2_format(uint32_t ktx2_format) {
+  for (size_t i = 0; i < sizeof(_purrr_ktx2_formats)/sizeof(*_purrr_ktx2_formats); ++i)
+    if (_purrr_ktx2_formats[i].ktx2_format == ktx2_format) return _purrr_ktx2_formats[i].format;
+  return PURRR_FORMAT_UNDEFINED;
+}
+
+purrr_image_t *purrr_image_load_ktx2(const uint8_t *data, size_t size, purrr_renderer_t *renderer) {
+  static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+  const size_t header_size = 80, level_size = 24;
+  if (!data || size < header_size || memcmp(data, identifier, sizeof(identifier)) != 0 || !renderer) return NULL;
+
+  purrr_format_t format = _purrr_ktx2_format(_purrr_read_u32(data+12));
+  uint32_t width = _purrr_read_u32(data+20);
+  uint32_t height = _purrr_read_u32(data+24);
+  uint32_t depth = _purrr_read_u32(data+28);
+  uint32_t layer_count = _purrr_read_u32(data+32);
+  uint32_t face_count = _purrr_read_u32(data+36);
+  uint32_t level_count = _purrr_read_u32(data+40);
+  uint32_t supercompression = _purrr_read_u32(data+44);
+  if (format == PURRR_FORMAT_UNDEFINED || width == 0 || height == 0 || depth > 1 || layer_count > 1 || face_count != 1 || supercompression != 0) return NULL;
+
+  // A level count of 0 asks for the chain to be generated from the first level.
+  uint32_t stored_levels = (level_count?level_count:1);
+  if (size < header_size + stored_levels*level_size) return NULL;
+
+  _purrr_image_level_t *levels = (_purrr_image_level_t*)malloc(sizeof(*levels)*stored_levels);
+  assert(levels);
+  for (uint32_t i = 0; i < stored_levels; ++i) {
+    uint64_t offset = _purrr_read_u64(data+header_size+i*level_size);
+    uint64_t length = _purrr_read_u64(data+header_size+i*level_size+8);
+    if (offset > size || length > size-offset) {
+      free(levels);
+      return NULL;
+    }
+    levels[i] = (_purrr_image_level_t){ data+offset, (size_t)length };
+  }
+
+  purrr_image_info_t info = {
+    .width = width,
+    .height = height,
+    .format = format,
+    .mip_levels = level_count,
+  };
+
+  _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, renderer);
+  if (image && !image->load_levels(image, levels, stored_levels)) {
+    _purrr_image_free(image);
+    image = NULL;
+  }
+
+  free(levels);
+  return (purrr_image_t*)image;
+}
+
 // texture
 
 purrr_texture_t *purrr_texture_create(purrr_texture_info_t *info, purrr_renderer_t *renderer) {
@@ -331,6 +458,7 @@ purrr_texture_t *purrr_texture_create(purrr_texture_info_t *info, purrr_renderer
   case PURRR_API_VULKAN: {
     internal->init = _purrr_texture_vulkan_init;
     internal->cleanup = _purrr_texture_vulkan_cleanup;
+    internal->get_index = _purrr_texture_vulkan_get_index;
   } break;
   default: {
     assert(0 && "Unreachable");
@@ -350,10 +478,16 @@ void purrr_texture_destroy(purrr_texture_t *texture) {
   if (texture) _purrr_texture_free((_purrr_texture_t*)texture);
 }
 
+uint32_t purrr_texture_get_index(purrr_texture_t *texture) {
+  _purrr_texture_t *internal = (_purrr_texture_t*)texture;
+  assert(internal && internal->get_index);
+  return internal->get_index(internal);
+}
+
 // pipeline descriptor
 
 purrr_pipeline_descriptor_t *purrr_pipeline_descriptor_create(purrr_pipeline_descriptor_info_t *info, purrr_renderer_t *renderer) {
-  if (!info || info->color_attachment_count == 0 || !info->color_attachments || !renderer) return NULL;
+  if (!info || info->color_attachment_count == 0 || info->color_attachment_count > PURRR_MAX_COLOR_ATTACHMENTS || !info->color_attachments || !renderer) return NULL;
 
   _purrr_pipeline_descriptor_t *internal = (_purrr_pipeline_descriptor_t*)malloc(sizeof(*internal));
   if (!internal) return NULL;
@@ -424,11 +558,13 @@ void purrr_shader_destroy(purrr_shader_t *shader) {
 
 // pipeline
 
-purrr_pipeline_t *purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_renderer_t *renderer) {
+static purrr_pipeline_t *_purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_renderer_t *renderer, bool async) {
   if (!info || !renderer ||
       !info->pipeline_descriptor ||
       (info->descriptor_slot_count > 0 && !info->descriptor_slots) ||
-      (info->shader_count > 0 && !info->shaders))
+      (info->descriptor_set_count > 0 && !info->descriptor_sets) ||
+      (info->shader_count > 0 && !info->shaders) ||
+      (info->fallback && ((_purrr_pipeline_t*)info->fallback)->renderer != (_purrr_renderer_t*)renderer))
     return NULL;
 
   _purrr_pipeline_t *internal = (_purrr_pipeline_t*)malloc(sizeof(*internal));
@@ -439,8 +575,10 @@ purrr_pipeline_t *purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_rende
 
   switch (((_purrr_renderer_t*)renderer)->api) {
   case PURRR_API_VULKAN: {
-    internal->init = _purrr_pipeline_vulkan_init;
+    internal->init = (async?_purrr_pipeline_vulkan_init_async:_purrr_pipeline_vulkan_init);
     internal->cleanup = _purrr_pipeline_vulkan_cleanup;
+    internal->get_stats = _purrr_pipeline_vulkan_get_stats;
+    internal->is_ready = _purrr_pipeline_vulkan_is_ready;
   } break;
   default: {
     assert(0 && "Unreachable");
@@ -458,10 +596,75 @@ purrr_pipeline_t *purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_rende
   return (purrr_pipeline_t*)internal;
 }
 
+purrr_pipeline_t *purrr_pipeline_create(purrr_pipeline_info_t *info, purrr_renderer_t *renderer) {
+  return _purrr_pipeline_create(info, renderer, false);
+}
+
+purrr_pipeline_t *purrr_pipeline_create_async(purrr_pipeline_info_t *info, purrr_renderer_t *renderer) {
+  return _purrr_pipeline_create(info, renderer, true);
+}
+
 void purrr_pipeline_destroy(purrr_pipeline_t *pipeline) {
   if (pipeline) _purrr_pipeline_free((_purrr_pipeline_t*)pipeline);
 }
 
+bool purrr_pipeline_get_stats(purrr_pipeline_t *pipeline, purrr_pipeline_stats_t *stats) {
+  _purrr_pipeline_t *internal = (_purrr_pipeline_t*)pipeline;
+  assert(internal && internal->get_stats);
+  if (!stats) return false;
+  return internal->get_stats(internal, stats);
+}
+
+bool purrr_pipeline_is_ready(purrr_pipeline_t *pipeline) {
+  _purrr_pipeline_t *internal = (_purrr_pipeline_t*)pipeline;
+  assert(internal && internal->is_ready);
+  return internal->is_ready(internal);
+}
+
+// descriptor set
+
+purrr_descriptor_set_t *purrr_descriptor_set_create(purrr_descriptor_set_info_t *info, purrr_renderer_t *renderer) {
+  if (!info || !renderer || !info->binding_count || !info->bindings) return NULL;
+
+  _purrr_descriptor_set_t *internal = (_purrr_descriptor_set_t*)malloc(sizeof(*internal));
+  if (!internal) return NULL;
+  memset(internal, 0, sizeof(*internal));
+  internal->info = *info;
+  internal->renderer = (_purrr_renderer_t*)renderer;
+
+  switch (((_purrr_renderer_t*)renderer)->api) {
+  case PURRR_API_VULKAN: {
+    internal->init = _purrr_descriptor_set_vulkan_init;
+    internal->cleanup = _purrr_descriptor_set_vulkan_cleanup;
+    internal->write = _purrr_descriptor_set_vulkan_write;
+  } break;
+  default: {
+    assert(0 && "Unreachable");
+    return NULL;
+  }
+  }
+
+  if (!internal->init(internal)) {
+    _purrr_descriptor_set_free(internal);
+    return NULL;
+  }
+
+  internal->initialized = true;
+
+  return (purrr_descriptor_set_t*)internal;
+}
+
+bool purrr_descriptor_set_write(purrr_descriptor_set_t *set, const purrr_descriptor_write_t *writes) {
+  _purrr_descriptor_set_t *internal = (_purrr_descriptor_set_t*)set;
+  assert(internal && internal->write);
+  if (!writes) return false;
+  return internal->write(internal, writes);
+}
+
+void purrr_descriptor_set_destroy(purrr_descriptor_set_t *set) {
+  if (set) _purrr_descriptor_set_free((_purrr_descriptor_set_t*)set);
+}
+
 // render target
 
 purrr_render_target_t *purrr_render_target_create(purrr_render_target_info_t *info, purrr_renderer_t *renderer) {
@@ -512,10 +715,68 @@ void purrr_render_target_destroy(purrr_render_target_t *render_target) {
   if (render_target) _purrr_render_target_free((_purrr_render_target_t*)render_target);
 }
 
+// render target pool
+
+purrr_render_target_pool_t *purrr_render_target_pool_create(purrr_renderer_t *renderer) {
+  if (!renderer) return NULL;
+
+  _purrr_render_target_pool_t *internal = (_purrr_render_target_pool_t*)malloc(sizeof(*internal));
+  if (!internal) return NULL;
+  memset(internal, 0, sizeof(*internal));
+  internal->renderer = (_purrr_renderer_t*)renderer;
+
+  switch (((_purrr_renderer_t*)renderer)->api) {
+  case PURRR_API_VULKAN: {
+    internal->init = _purrr_render_target_pool_vulkan_init;
+    internal->cleanup = _purrr_render_target_pool_vulkan_cleanup;
+    internal->acquire = _purrr_render_target_pool_vulkan_acquire;
+    internal->release = _purrr_render_target_pool_vulkan_release;
+    internal->get_render_target = _purrr_render_target_pool_vulkan_get_render_target;
+  } break;
+  default: {
+    assert(0 && "Unreachable");
+    return NULL;
+  }
+  }
+
+  if (!internal->init(internal)) {
+    _purrr_render_target_pool_free(internal);
+    return NULL;
+  }
+
+  internal->initialized = true;
+
+  return (purrr_render_target_pool_t*)internal;
+}
+
+purrr_image_t *purrr_render_target_pool_acquire(purrr_render_target_pool_t *pool, purrr_image_info_t *info) {
+  _purrr_render_target_pool_t *internal = (_purrr_render_target_pool_t*)pool;
+  if (!internal || !internal->initialized || !info || info->format >= COUNT_PURRR_FORMATS || info->format == PURRR_FORMAT_UNDEFINED || !info->width || !info->height) return NULL;
+  assert(internal->acquire);
+  return (purrr_image_t*)internal->acquire(internal, info);
+}
+
+void purrr_render_target_pool_release(purrr_render_target_pool_t *pool, purrr_image_t *image) {
+  _purrr_render_target_pool_t *internal = (_purrr_render_target_pool_t*)pool;
+  assert(internal && internal->release && image && ((_purrr_image_t*)image)->pool == internal);
+  internal->release(internal, (_purrr_image_t*)image);
+}
+
+purrr_render_target_t *purrr_render_target_pool_get_render_target(purrr_render_target_pool_t *pool, purrr_render_target_info_t *info) {
+  _purrr_render_target_pool_t *internal = (_purrr_render_target_pool_t*)pool;
+  if (!internal || !internal->initialized || !info || !info->pipeline_descriptor || !info->images || !info->width || !info->height) return NULL;
+  assert(internal->get_render_target);
+  return (purrr_render_target_t*)internal->get_render_target(internal, info);
+}
+
+void purrr_render_target_pool_destroy(purrr_render_target_pool_t *pool) {
+  if (pool) _purrr_render_target_pool_free((_purrr_render_target_pool_t*)pool);
+}
+
 // buffer
 
 purrr_buffer_t *purrr_buffer_create(purrr_buffer_info_t *info, purrr_renderer_t *renderer) {
-  if (!info || info->type >= COUNT_PURRR_BUFFER_TYPES) return NULL;
+  if (!info || info->type >= COUNT_PURRR_BUFFER_TYPES || info->usage >= COUNT_PURRR_MEMORY_USAGES) return NULL;
 
   _purrr_buffer_t *internal = (_purrr_buffer_t*)malloc(sizeof(*internal));
   if (!internal) return NULL;
@@ -570,6 +831,207 @@ void purrr_buffer_unmap(purrr_buffer_t *buffer) {
   internal->unmap(internal);
 }
 
+// upload
+
+purrr_upload_t *purrr_upload_begin(purrr_renderer_t *renderer) {
+  if (!renderer) return NULL;
+
+  _purrr_upload_t *internal = (_purrr_upload_t*)malloc(sizeof(*internal));
+  if (!internal) return NULL;
+  memset(internal, 0, sizeof(*internal));
+  internal->renderer = (_purrr_renderer_t*)renderer;
+
+  switch (((_purrr_renderer_t*)renderer)->api) {
+  case PURRR_API_VULKAN: {
+    internal->init = _purrr_upload_vulkan_init;
+    internal->cleanup = _purrr_upload_vulkan_cleanup;
+    internal->buffer = _purrr_upload_vulkan_buffer;
+    internal->image = _purrr_upload_vulkan_image;
+    internal->submit = _purrr_upload_vulkan_submit;
+    internal->is_done = _purrr_upload_vulkan_is_done;
+    internal->wait = _purrr_upload_vulkan_wait;
+  } break;
+  default: {
+    assert(0 && "Unreachable");
+    return NULL;
+  }
+  }
+
+  if (!internal->init(internal)) {
+    _purrr_upload_free(internal);
+    return NULL;
+  }
+
+  return (purrr_upload_t*)internal;
+}
+
+bool purrr_upload_buffer(purrr_upload_t *upload, purrr_buffer_t *buffer, void *data, uint32_t size, uint32_t offset) {
+  _purrr_upload_t *internal = (_purrr_upload_t*)upload;
+  assert(internal && buffer && data && internal->buffer);
+  if (internal->submitted) return false;
+  return internal->buffer(internal, (_purrr_buffer_t*)buffer, data, size, offset);
+}
+
+bool purrr_upload_image(purrr_upload_t *upload, purrr_image_t *image, uint8_t *src, uint32_t src_width, uint32_t src_height) {
+  _purrr_upload_t *internal = (_purrr_upload_t*)upload;
+  assert(internal && image && src && internal->image);
+  if (internal->submitted) return false;
+  return internal->image(internal, (_purrr_image_t*)image, src, src_width, src_height);
+}
+
+bool purrr_upload_submit(purrr_upload_t *upload) {
+  _purrr_upload_t *internal = (_purrr_upload_t*)upload;
+  assert(internal && internal->submit);
+  if (internal->submitted) return false;
+  if (!internal->submit(internal)) return false;
+  internal->submitted = true;
+  return true;
+}
+
+bool purrr_upload_is_done(purrr_upload_t *upload) {
+  _purrr_upload_t *internal = (_purrr_upload_t*)upload;
+  assert(internal && internal->is_done);
+  return internal->submitted && internal->is_done(internal);
+}
+
+void purrr_upload_wait(purrr_upload_t *upload) {
+  _purrr_upload_t *internal = (_purrr_upload_t*)upload;
+  assert(internal && internal->wait);
+  if (internal->submitted) internal->wait(internal);
+}
+
+void purrr_upload_destroy(purrr_upload_t *upload) {
+  if (upload) _purrr_upload_free((_purrr_upload_t*)upload);
+}
+
+// readback
+
+static purrr_readback_t *_purrr_readback_create(_purrr_renderer_t *renderer, _purrr_image_t *image, _purrr_buffer_t *buffer, uint32_t size, uint32_t offset) {
+  _purrr_readback_t *internal = (_purrr_readback_t*)malloc(sizeof(*internal));
+  if (!internal) return NULL;
+  memset(internal, 0, sizeof(*internal));
+  internal->renderer = renderer;
+  internal->image = image;
+  internal->buffer = buffer;
+  internal->size = size;
+  internal->offset = offset;
+
+  switch (renderer->api) {
+  case PURRR_API_VULKAN: {
+    internal->init = _purrr_readback_vulkan_init;
+    internal->cleanup = _purrr_readback_vulkan_cleanup;
+    internal->is_done = _purrr_readback_vulkan_is_done;
+    internal->wait = _purrr_readback_vulkan_wait;
+  } break;
+  default: {
+    assert(0 && "Unreachable");
+    return NULL;
+  }
+  }
+
+  if (!internal->init(internal)) {
+    _purrr_readback_free(internal);
+    return NULL;
+  }
+
+  return (purrr_readback_t*)internal;
+}
+
+purrr_readback_t *purrr_image_read_async(purrr_image_t *image) {
+  _purrr_image_t *internal = (_purrr_image_t*)image;
+  if (!internal || !internal->initialized || !internal->renderer) return NULL;
+  if (internal->info.format == PURRR_FORMAT_UNDEFINED || internal->info.format == PURRR_FORMAT_DEPTH || internal->info.sample_count != PURRR_SAMPLE_COUNT_1) return NULL;
+  return _purrr_readback_create(internal->renderer, internal, NULL, 0, 0);
+}
+
+purrr_readback_t *purrr_buffer_read_async(purrr_buffer_t *buffer, uint32_t size, uint32_t offset) {
+  _purrr_buffer_t *internal = (_purrr_buffer_t*)buffer;
+  if (!internal || !internal->initialized || !internal->renderer || size == 0) return NULL;
+  if (offset > internal->info.size || size > internal->info.size - offset) return NULL;
+  return _purrr_readback_create(internal->renderer, NULL, internal, size, offset);
+}
+
+bool purrr_readback_is_done(purrr_readback_t *readback) {
+  _purrr_readback_t *internal = (_purrr_readback_t*)readback;
+  assert(internal && internal->is_done);
+  if (internal->done) return !internal->failed;
+  return internal->is_done(internal);
+}
+
+bool purrr_readback_wait(purrr_readback_t *readback) {
+  _purrr_readback_t *internal = (_purrr_readback_t*)readback;
+  assert(internal && internal->wait);
+  if (internal->done) return !internal->failed;
+  return internal->wait(internal);
+}
+
+const void *purrr_readback_get_data(purrr_readback_t *readback, uint32_t *size) {
+  _purrr_readback_t *internal = (_purrr_readback_t*)readback;
+  assert(internal);
+  if (!internal->done) return NULL;
+  if (size) *size = internal->size;
+  return internal->data;
+}
+
+void purrr_readback_destroy(purrr_readback_t *readback) {
+  if (readback) _purrr_readback_free((_purrr_readback_t*)readback);
+}
+
+// image loader
+
+purrr_image_loader_t *purrr_image_loader_create(purrr_image_loader_info_t *info, purrr_renderer_t *renderer) {
+  if (!info || info->format == PURRR_FORMAT_UNDEFINED || info->format >= COUNT_PURRR_FORMATS || info->format == PURRR_FORMAT_DEPTH ||
+      !info->sampler || !info->decoder || !renderer) return NULL;
+
+  _purrr_image_loader_t *internal = (_purrr_image_loader_t*)malloc(sizeof(*internal));
+  if (!internal) return NULL;
+  memset(internal, 0, sizeof(*internal));
+  internal->info = *info;
+  internal->renderer = (_purrr_renderer_t*)renderer;
+
+  switch (((_purrr_renderer_t*)renderer)->api) {
+  case PURRR_API_VULKAN: {
+    internal->init = _purrr_image_loader_vulkan_init;
+    internal->cleanup = _purrr_image_loader_vulkan_cleanup;
+    internal->load_file = _purrr_image_loader_vulkan_load_file;
+    internal->poll = _purrr_image_loader_vulkan_poll;
+    internal->alloc = _purrr_image_loader_vulkan_alloc;
+  } break;
+  default: {
+    assert(0 && "Unreachable");
+    return NULL;
+  }
+  }
+
+  if (!internal->init(internal)) {
+    _purrr_image_loader_free(internal);
+    return NULL;
+  }
+
+  return (purrr_image_loader_t*)internal;
+}
+
+void purrr_image_loader_destroy(purrr_image_loader_t *loader) {
+  if (loader) _purrr_image_loader_free((_purrr_image_loader_t*)loader);
+}
+
+bool purrr_image_load_file_async(purrr_image_loader_t *loader, const char *filename, purrr_image_loaded_cb callback, void *user_ptr) {
+  _purrr_image_loader_t *internal = (_purrr_image_loader_t*)loader;
+  assert(internal && filename && callback && internal->load_file);
+  return internal->load_file(internal, filename, callback, user_ptr);
+}
+
+uint32_t purrr_image_loader_poll(purrr_image_loader_t *loader) {
+  _purrr_image_loader_t *internal = (_purrr_image_loader_t*)loader;
+  assert(internal && internal->poll);
+  return internal->poll(internal);
+}
+
+uint8_t *purrr_image_decode_alloc(purrr_image_decode_t *decode, uint32_t width, uint32_t height) {
+  assert(decode && decode->loader && decode->loader->alloc);
+  return decode->loader->alloc(decode->loader, decode->job, width, height);
+}
+
 // renderer
 
 purrr_renderer_t *purrr_renderer_create(purrr_renderer_info_t *info) {
@@ -586,12 +1048,21 @@ purrr_renderer_t *purrr_renderer_create(purrr_renderer_info_t *info) {
     internal->init = _purrr_renderer_vulkan_init;
     internal->cleanup = _purrr_renderer_vulkan_cleanup;
     internal->get_sample_counts = _purrr_renderer_vulkan_get_sample_counts;
+    internal->is_format_supported = _purrr_renderer_vulkan_is_format_supported;
     internal->begin_frame = _purrr_renderer_vulkan_begin_frame;
     internal->begin_render_target = _purrr_renderer_vulkan_begin_render_target;
     internal->bind_pipeline = _purrr_renderer_vulkan_bind_pipeline;
     internal->bind_texture = _purrr_renderer_vulkan_bind_texture;
     internal->bind_buffer = _purrr_renderer_vulkan_bind_buffer;
+    internal->bind_buffer_range = _purrr_renderer_vulkan_bind_buffer_range;
+    internal->bind_descriptor_set = _purrr_renderer_vulkan_bind_descriptor_set;
     internal->push_constant = _purrr_renderer_vulkan_push_constant;
+    internal->push_texture = _purrr_renderer_vulkan_push_texture;
+    internal->push_buffer = _purrr_renderer_vulkan_push_buffer;
+    internal->set_dynamic_state = _purrr_renderer_vulkan_set_dynamic_state;
+    internal->alloc_transient = _purrr_renderer_vulkan_alloc_transient;
+    internal->bind_transient = _purrr_renderer_vulkan_bind_transient;
+    internal->transfer_image = _purrr_renderer_vulkan_transfer_image;
     internal->draw = _purrr_renderer_vulkan_draw;
     internal->draw_indexed = _purrr_renderer_vulkan_draw_indexed;
     internal->end_render_target = _purrr_renderer_vulkan_end_render_target;
@@ -643,16 +1114,30 @@ uint32_t purrr_renderer_get_sample_counts(purrr_renderer_t *renderer, purrr_samp
   assert(internal->get_sample_counts(internal, array));
 }
 
+bool purrr_renderer_is_format_supported(purrr_renderer_t *renderer, purrr_format_t format) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->is_format_supported);
+  if (format == PURRR_FORMAT_UNDEFINED || format >= COUNT_PURRR_FORMATS) return false;
+  return internal->is_format_supported(internal, format);
+}
+
+purrr_format_t purrr_renderer_pick_format(purrr_renderer_t *renderer, const purrr_format_t *candidates, uint32_t count) {
+  assert(candidates);
+  for (uint32_t i = 0; i < count; ++i)
+    if (purrr_renderer_is_format_supported(renderer, candidates[i])) return candidates[i];
+  return PURRR_FORMAT_UNDEFINED;
+}
+
 void purrr_renderer_begin_frame(purrr_renderer_t *renderer, uint32_t *image_index) {
   _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
   assert(internal && internal->begin_frame);
   assert(internal->begin_frame(internal, image_index));
 }
 
-void purrr_renderer_begin_render_target(purrr_renderer_t *renderer, purrr_render_target_t *render_target) {
+void purrr_renderer_begin_render_target(purrr_renderer_t *renderer, purrr_render_target_t *render_target, const purrr_clear_value_t *clear_values, uint32_t clear_value_count) {
   _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
   assert(internal && internal->begin_render_target && render_target);
-  assert(internal->begin_render_target(internal, (_purrr_render_target_t*)render_target));
+  assert(internal->begin_render_target(internal, (_purrr_render_target_t*)render_target, clear_values, (clear_values?clear_value_count:0)));
 }
 
 void purrr_renderer_bind_pipeline(purrr_renderer_t *renderer, purrr_pipeline_t *pipeline) {
@@ -673,12 +1158,114 @@ void purrr_renderer_bind_buffer(purrr_renderer_t *renderer, purrr_buffer_t *buff
   assert(internal->bind_buffer(internal, (_purrr_buffer_t*)buffer, slot_index));
 }
 
+bool purrr_renderer_alloc_transient(purrr_renderer_t *renderer, uint32_t size, uint32_t align, void **ptr, purrr_transient_binding_t *binding) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->alloc_transient && ptr && binding);
+  return internal->alloc_transient(internal, size, align, ptr, binding);
+}
+
+void purrr_renderer_bind_transient(purrr_renderer_t *renderer, const purrr_transient_binding_t *binding, purrr_buffer_type_t type, uint32_t slot_index) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->bind_transient && binding);
+  assert(internal->bind_transient(internal, binding, type, slot_index));
+}
+
+bool purrr_renderer_transfer_image(purrr_renderer_t *renderer, const purrr_image_transfer_info_t *info) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->transfer_image && info);
+  return internal->transfer_image(internal, info);
+}
+
+void purrr_renderer_bind_buffer_range(purrr_renderer_t *renderer, purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->bind_buffer_range && buffer);
+  assert(internal->bind_buffer_range(internal, (_purrr_buffer_t*)buffer, slot_index, offset, size));
+}
+
+void purrr_renderer_bind_descriptor_set(purrr_renderer_t *renderer, purrr_descriptor_set_t *set, uint32_t slot_index) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->bind_descriptor_set && set);
+  assert(internal->bind_descriptor_set(internal, (_purrr_descriptor_set_t*)set, slot_index));
+}
+
 void purrr_renderer_push_constant(purrr_renderer_t *renderer, uint32_t offset, uint32_t size, const void *value) {
   _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
   assert(internal && internal->push_constant && value && size);
   assert(internal->push_constant(internal, offset, size, value));
 }
 
+void purrr_renderer_push_texture(purrr_renderer_t *renderer, purrr_texture_t *texture, uint32_t slot_index) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->push_texture && texture);
+  assert(internal->push_texture(internal, (_purrr_texture_t*)texture, slot_index));
+}
+
+void purrr_renderer_push_buffer(purrr_renderer_t *renderer, purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->push_buffer && buffer);
+  assert(internal->push_buffer(internal, (_purrr_buffer_t*)buffer, slot_index, offset, size));
+}
+
+void purrr_renderer_set_cull_mode(purrr_renderer_t *renderer, purrr_cull_mode_t cull_mode) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_CULL_MODE, 0, cull_mode));
+}
+
+void purrr_renderer_set_front_face(purrr_renderer_t *renderer, purrr_front_face_t front_face) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_FRONT_FACE, 0, front_face));
+}
+
+void purrr_renderer_set_topology(purrr_renderer_t *renderer, purrr_primitive_topology_t topology) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_TOPOLOGY, 0, topology));
+}
+
+void purrr_renderer_set_polygon_mode(purrr_renderer_t *renderer, purrr_polygon_mode_t polygon_mode) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_POLYGON_MODE, 0, polygon_mode));
+}
+
+void purrr_renderer_set_depth_test(purrr_renderer_t *renderer, bool enable) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_DEPTH_TEST, 0, enable));
+}
+
+void purrr_renderer_set_depth_write(purrr_renderer_t *renderer, bool enable) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_DEPTH_WRITE, 0, enable));
+}
+
+void purrr_renderer_set_depth_compare_op(purrr_renderer_t *renderer, purrr_compare_op_t compare_op) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP, 0, compare_op));
+}
+
+void purrr_renderer_set_depth_bias(purrr_renderer_t *renderer, bool enable) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_DEPTH_BIAS, 0, enable));
+}
+
+void purrr_renderer_set_stencil_test(purrr_renderer_t *renderer, bool enable) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_STENCIL_TEST, 0, enable));
+}
+
+void purrr_renderer_set_blend(purrr_renderer_t *renderer, uint32_t attachment_index, bool enable) {
+  _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
+  assert(internal && internal->set_dynamic_state);
+  assert(internal->set_dynamic_state(internal, PURRR_DYNAMIC_STATE_BLEND, attachment_index, enable));
+}
+
 void purrr_renderer_draw(purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t vertex_count, uint32_t first_vertex) {
   _purrr_renderer_t *internal = (_purrr_renderer_t*)renderer;
   assert(internal && internal->draw);
@@ -2,6 +2,13 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <threads.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 #define min(a, b) (a<b?a:b)
 #define max(a, b) (a>b?a:b)
@@ -32,6 +39,11 @@ VkFilter vk_filter(purrr_sampler_filter_t filter) {
   }
 }
 
+VkAttachmentLoadOp vk_attachment_load_op(const purrr_pipeline_descriptor_attachment_info_t *info) {
+  if (info->load) return VK_ATTACHMENT_LOAD_OP_LOAD;
+  return (info->discard?VK_ATTACHMENT_LOAD_OP_DONT_CARE:VK_ATTACHMENT_LOAD_OP_CLEAR);
+}
+
 VkSamplerAddressMode vk_sampler_address_mode(purrr_sampler_address_mode_t address_mode) {
   switch (address_mode) {
   case PURRR_SAMPLER_ADDRESS_MODE_REPEAT:               return VK_SAMPLER_ADDRESS_MODE_REPEAT;
@@ -47,10 +59,22 @@ VkSamplerAddressMode vk_sampler_address_mode(purrr_sampler_address_mode_t addres
   }
 }
 
+VkSamplerMipmapMode vk_sampler_mipmap_mode(purrr_sampler_mipmap_mode_t mipmap_mode) {
+  switch (mipmap_mode) {
+  case PURRR_SAMPLER_MIPMAP_MODE_LINEAR:  return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  case PURRR_SAMPLER_MIPMAP_MODE_NEAREST: return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  case COUNT_PURRR_SAMPLER_MIPMAP_MODES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
 VkDescriptorType vk_descriptor_type(purrr_buffer_type_t type) {
   switch (type) {
-  case PURRR_BUFFER_TYPE_UNIFORM: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  case PURRR_BUFFER_TYPE_STORAGE: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  case PURRR_BUFFER_TYPE_UNIFORM: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+  case PURRR_BUFFER_TYPE_STORAGE: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
   case COUNT_PURRR_BUFFER_TYPES:
   default: {
     assert(0 && "Unreachable");
@@ -59,39 +83,611 @@ VkDescriptorType vk_descriptor_type(purrr_buffer_type_t type) {
   }
 }
 
+VkDescriptorType vk_set_descriptor_type(purrr_descriptor_type_t type) {
+  switch (type) {
+  case PURRR_DESCRIPTOR_TYPE_TEXTURE:        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  case PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  case PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  case PURRR_DESCRIPTOR_TYPE_TEXTURE_ARRAY:
+  case COUNT_PURRR_DESCRIPTOR_TYPES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkCullModeFlags vk_cull_mode(purrr_cull_mode_t cull_mode) {
+  switch (cull_mode) {
+  case PURRR_CULL_MODE_BACK:           return VK_CULL_MODE_BACK_BIT;
+  case PURRR_CULL_MODE_FRONT:          return VK_CULL_MODE_FRONT_BIT;
+  case PURRR_CULL_MODE_NONE:           return VK_CULL_MODE_NONE;
+  case PURRR_CULL_MODE_FRONT_AND_BACK: return VK_CULL_MODE_FRONT_AND_BACK;
+  case COUNT_PURRR_CULL_MODES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkPrimitiveTopology vk_primitive_topology(purrr_primitive_topology_t topology) {
+  switch (topology) {
+  case PURRR_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:  return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  case PURRR_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP: return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+  case PURRR_PRIMITIVE_TOPOLOGY_LINE_LIST:      return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+  case PURRR_PRIMITIVE_TOPOLOGY_LINE_STRIP:     return VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+  case PURRR_PRIMITIVE_TOPOLOGY_POINT_LIST:     return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+  case COUNT_PURRR_PRIMITIVE_TOPOLOGIES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkFrontFace vk_front_face(purrr_front_face_t front_face) {
+  switch (front_face) {
+  case PURRR_FRONT_FACE_CLOCKWISE:         return VK_FRONT_FACE_CLOCKWISE;
+  case PURRR_FRONT_FACE_COUNTER_CLOCKWISE: return VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  case COUNT_PURRR_FRONT_FACES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkPolygonMode vk_polygon_mode(purrr_polygon_mode_t polygon_mode) {
+  switch (polygon_mode) {
+  case PURRR_POLYGON_MODE_FILL:  return VK_POLYGON_MODE_FILL;
+  case PURRR_POLYGON_MODE_LINE:  return VK_POLYGON_MODE_LINE;
+  case PURRR_POLYGON_MODE_POINT: return VK_POLYGON_MODE_POINT;
+  case COUNT_PURRR_POLYGON_MODES:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkCompareOp vk_compare_op(purrr_compare_op_t compare_op) {
+  switch (compare_op) {
+  case PURRR_COMPARE_OP_LESS:             return VK_COMPARE_OP_LESS;
+  case PURRR_COMPARE_OP_LESS_OR_EQUAL:    return VK_COMPARE_OP_LESS_OR_EQUAL;
+  case PURRR_COMPARE_OP_GREATER:          return VK_COMPARE_OP_GREATER;
+  case PURRR_COMPARE_OP_GREATER_OR_EQUAL: return VK_COMPARE_OP_GREATER_OR_EQUAL;
+  case PURRR_COMPARE_OP_EQUAL:            return VK_COMPARE_OP_EQUAL;
+  case PURRR_COMPARE_OP_NOT_EQUAL:        return VK_COMPARE_OP_NOT_EQUAL;
+  case PURRR_COMPARE_OP_ALWAYS:           return VK_COMPARE_OP_ALWAYS;
+  case PURRR_COMPARE_OP_NEVER:            return VK_COMPARE_OP_NEVER;
+  case COUNT_PURRR_COMPARE_OPS:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkBlendFactor vk_blend_factor(purrr_blend_factor_t factor) {
+  switch (factor) {
+  case PURRR_BLEND_FACTOR_ZERO:                return VK_BLEND_FACTOR_ZERO;
+  case PURRR_BLEND_FACTOR_ONE:                 return VK_BLEND_FACTOR_ONE;
+  case PURRR_BLEND_FACTOR_SRC_COLOR:           return VK_BLEND_FACTOR_SRC_COLOR;
+  case PURRR_BLEND_FACTOR_ONE_MINUS_SRC_COLOR: return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+  case PURRR_BLEND_FACTOR_DST_COLOR:           return VK_BLEND_FACTOR_DST_COLOR;
+  case PURRR_BLEND_FACTOR_ONE_MINUS_DST_COLOR: return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+  case PURRR_BLEND_FACTOR_SRC_ALPHA:           return VK_BLEND_FACTOR_SRC_ALPHA;
+  case PURRR_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA: return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  case PURRR_BLEND_FACTOR_DST_ALPHA:           return VK_BLEND_FACTOR_DST_ALPHA;
+  case PURRR_BLEND_FACTOR_ONE_MINUS_DST_ALPHA: return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+  case COUNT_PURRR_BLEND_FACTORS:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkBlendOp vk_blend_op(purrr_blend_op_t op) {
+  switch (op) {
+  case PURRR_BLEND_OP_ADD:              return VK_BLEND_OP_ADD;
+  case PURRR_BLEND_OP_SUBTRACT:         return VK_BLEND_OP_SUBTRACT;
+  case PURRR_BLEND_OP_REVERSE_SUBTRACT: return VK_BLEND_OP_REVERSE_SUBTRACT;
+  case PURRR_BLEND_OP_MIN:              return VK_BLEND_OP_MIN;
+  case PURRR_BLEND_OP_MAX:              return VK_BLEND_OP_MAX;
+  case COUNT_PURRR_BLEND_OPS:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
+VkStencilOp vk_stencil_op(purrr_stencil_op_t op) {
+  switch (op) {
+  case PURRR_STENCIL_OP_KEEP:                return VK_STENCIL_OP_KEEP;
+  case PURRR_STENCIL_OP_ZERO:                return VK_STENCIL_OP_ZERO;
+  case PURRR_STENCIL_OP_REPLACE:             return VK_STENCIL_OP_REPLACE;
+  case PURRR_STENCIL_OP_INCREMENT_AND_CLAMP: return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
+  case PURRR_STENCIL_OP_DECREMENT_AND_CLAMP: return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
+  case PURRR_STENCIL_OP_INVERT:              return VK_STENCIL_OP_INVERT;
+  case PURRR_STENCIL_OP_INCREMENT_AND_WRAP:  return VK_STENCIL_OP_INCREMENT_AND_WRAP;
+  case PURRR_STENCIL_OP_DECREMENT_AND_WRAP:  return VK_STENCIL_OP_DECREMENT_AND_WRAP;
+  case COUNT_PURRR_STENCIL_OPS:
+  default: {
+    assert(0 && "Unreachable");
+    return 0;
+  }
+  }
+}
+
 // Data structs
 
+// Device memory is handed out from big blocks (one vkAllocateMemory each) using
+// a buddy allocator, chunks are always aligned to their own (power of two) size.
+#define PURRR_VULKAN_MIN_CHUNK_SHIFT 8 // 256 bytes
+#define PURRR_VULKAN_MAX_BLOCK_SIZE  (64ull*1024*1024)
+#define PURRR_VULKAN_MIN_BLOCK_SIZE  (1ull*1024*1024)
+
+typedef struct {
+  uint32_t *items; // offsets in chunks
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_free_list_t;
+
+typedef struct {
+  VkDeviceMemory memory;
+  VkDeviceSize size;
+  VkDeviceSize used;
+  uint32_t max_order;
+  _purrr_vulkan_free_list_t *free_lists; // max_order+1 lists
+  void *mapped;
+  struct _purrr_vulkan_memory_pool_s *pool;
+} _purrr_vulkan_memory_block_t;
+
+typedef struct _purrr_vulkan_memory_pool_s {
+  _purrr_vulkan_memory_block_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_memory_pool_t;
+
+typedef struct {
+  VkPhysicalDeviceMemoryProperties memory_properties;
+  VkDeviceSize block_sizes[VK_MAX_MEMORY_TYPES];
+  VkDeviceSize buffer_image_granularity;
+  uint32_t max_allocation_count;
+  uint32_t allocation_count;
+  bool rebar; // The whole (or most of the) device local heap is host visible
+  // [memory type][0 - linear, 1 - optimal], split only if bufferImageGranularity is bigger than a chunk
+  _purrr_vulkan_memory_pool_t pools[VK_MAX_MEMORY_TYPES][2];
+} _purrr_vulkan_allocator_t;
+
+typedef struct {
+  _purrr_vulkan_memory_block_t *block; // NULL if dedicated
+  VkDeviceMemory memory;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+  uint32_t memory_type;
+  uint32_t order;
+  void *mapped; // only used by dedicated allocations
+} _purrr_vulkan_allocation_t;
+
+// Uploads claim space in a persistently mapped ring buffer, every submission remembers
+// where the ring head was when it got submitted, so once its fence signals the tail can move there.
+#define PURRR_VULKAN_STAGING_SIZE    (32ull*1024*1024)
+#define PURRR_VULKAN_STAGING_SUBMITS 8
+
+typedef struct {
+  VkBuffer buffer;
+  _purrr_vulkan_allocation_t allocation;
+} _purrr_vulkan_staging_buffer_t;
+
+typedef struct {
+  _purrr_vulkan_staging_buffer_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_staging_buffers_t;
+
+typedef struct {
+  VkCommandBuffer cmd_buf;
+  VkFence fence;
+  VkDeviceSize end;
+  _purrr_vulkan_staging_buffers_t garbage; // Oversized uploads, destroyed once the fence signals
+} _purrr_vulkan_staging_submit_t;
+
+typedef struct {
+  VkBuffer buffer;
+  _purrr_vulkan_allocation_t allocation;
+  uint8_t *mapped;
+  VkDeviceSize size;
+  VkDeviceSize head;
+  VkDeviceSize tail;
+  _purrr_vulkan_staging_submit_t submits[PURRR_VULKAN_STAGING_SUBMITS];
+  uint32_t first; // Oldest in flight submission
+  uint32_t count; // In flight submissions
+  _purrr_vulkan_staging_buffers_t garbage;
+} _purrr_vulkan_staging_t;
+
+// Readbacks bump allocate from the frame in flight's half of the ring, begin_frame copies
+// everything read into that half out once the fence was waited on and resets it.
+#define PURRR_VULKAN_READBACK_SIZE (16ull*1024*1024)
+
+typedef struct {
+  _purrr_readback_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_readbacks_t;
+
+typedef struct {
+  VkBuffer buffer; // Created by the first readback
+  _purrr_vulkan_allocation_t allocation;
+  uint8_t *mapped;
+  VkDeviceSize size; // Per frame in flight
+  VkDeviceSize heads[2];
+  _purrr_vulkan_readbacks_t pending[2];
+} _purrr_vulkan_readback_ring_t;
+
+typedef struct {
+  uint32_t frame_index;
+  uint64_t frame; // Frame counter of the frame it was recorded in
+  VkDeviceSize offset; // Into the ring
+} _purrr_readback_data_t;
+
+// Descriptor sets come from a chain of pools that grows whenever all of them are full. Sets are cached by their layout
+// and what is written into them so identical ones are shared, the last release hands a set back to its pool two
+// frames later (until then a frame in flight might still use it).
+#define PURRR_VULKAN_DESCRIPTOR_POOL_SETS 256
+
+typedef struct {
+  VkDescriptorSetLayout layout;
+  VkDescriptorType type;
+  VkImageView image_view;
+  VkSampler sampler;
+  VkImageLayout image_layout;
+  VkBuffer buffer;
+  VkDeviceSize offset, range;
+} _purrr_vulkan_descriptor_key_t;
+
+typedef struct {
+  _purrr_vulkan_descriptor_key_t key;
+  uint64_t hash;
+  VkDescriptorSet set; // VK_NULL_HANDLE for empty slots
+  VkDescriptorPool pool;
+  uint32_t references;
+} _purrr_vulkan_descriptor_entry_t;
+
+typedef struct {
+  VkDescriptorSet set;
+  VkDescriptorPool pool;
+  uint64_t frame; // Frame counter when it was released
+} _purrr_vulkan_descriptor_garbage_t;
+
+typedef struct {
+  _purrr_vulkan_descriptor_garbage_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_descriptor_garbages_t;
+
+typedef struct {
+  VkDescriptorPool *pools;
+  size_t pool_capacity;
+  size_t pool_count;
+  size_t current; // The pool allocations are tried from first
+
+  _purrr_vulkan_descriptor_entry_t *entries; // Linear probing, the capacity is a power of two
+  size_t capacity;
+  size_t count;
+
+  _purrr_vulkan_descriptor_garbages_t garbage;
+} _purrr_vulkan_descriptors_t;
+
+// What resources keep to release their set again.
+typedef struct {
+  VkDescriptorSet set;
+  uint64_t hash;
+} _purrr_vulkan_descriptor_set_t;
+
+// Layouts of sets with several bindings are shared by everything with the same bindings. Each comes with an update
+// template that reads one _purrr_vulkan_descriptor_info_t per binding, so a whole set is written with a single call.
+typedef union {
+  VkDescriptorImageInfo image;
+  VkDescriptorBufferInfo buffer;
+} _purrr_vulkan_descriptor_info_t;
+
+typedef struct {
+  purrr_descriptor_type_t *bindings;
+  uint32_t binding_count;
+  VkDescriptorSetLayout layout;
+  VkDescriptorUpdateTemplate update_template; // VK_NULL_HANDLE without VK_KHR_descriptor_update_template
+  bool push; // Pushed with VK_KHR_push_descriptor, there's no template for those
+} _purrr_vulkan_set_layout_t;
+
+typedef struct {
+  _purrr_vulkan_set_layout_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_set_layouts_t;
+
+// Bindless textures share one partially bound array that is updated after being bound. A texture's slot is written
+// once when it's created and handed out again two frames after the texture is gone, released slots are never rewritten.
+typedef struct {
+  uint32_t index;
+  uint64_t frame; // Frame counter when it was released
+} _purrr_vulkan_bindless_slot_t;
+
+typedef struct {
+  _purrr_vulkan_bindless_slot_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_bindless_slots_t;
+
+typedef struct {
+  uint32_t count; // Size of the array, 0 if bindless textures are off
+  uint32_t used; // Slots below this were handed out at some point
+  VkDescriptorSetLayout layout;
+  VkDescriptorPool pool;
+  VkDescriptorSet set;
+  _purrr_vulkan_bindless_slots_t released; // Oldest first
+} _purrr_vulkan_bindless_t;
+
+// Per frame in flight bump allocator, uniform/storage bindings all go through one dynamic descriptor
+// with a fixed window, so the buffer is `range` bytes bigger than what can be allocated from it.
+#define PURRR_VULKAN_TRANSIENT_SIZE  (4ull*1024*1024)
+#define PURRR_VULKAN_TRANSIENT_RANGE (64ull*1024)
+
+typedef struct {
+  VkBuffer buffer;
+  _purrr_vulkan_allocation_t allocation;
+  uint8_t *mapped;
+  VkDeviceSize size;
+  VkDeviceSize head;
+  VkDescriptorSet uniform_set;
+  VkDescriptorSet storage_set;
+
+  // Sets of push descriptor slots that can't be pushed, all of them are reset when the frame begins.
+  VkDescriptorPool *descriptor_pools;
+  size_t descriptor_pool_capacity;
+  size_t descriptor_pool_count;
+  size_t descriptor_pool_current;
+} _purrr_vulkan_transient_t;
+
 typedef struct {
   VkSampler sampler;
 } _purrr_sampler_data_t;
 
 typedef struct {
   VkImage image;
-  VkDeviceMemory image_memory;
+  _purrr_vulkan_allocation_t allocation;
   VkImageView image_view;
+  VkImageView attachment_view; // Only the first mip level, same as image_view if there's just one
+  uint32_t mip_levels;
+  bool generate_mips; // false for compressed formats, their levels have to come from the source
+  VkFilter mip_filter;
+  VkImageUsageFlags usage;
+  VkImageLayout layout; // Where the image is kept between commands, GENERAL for linear ones so the host can write to them
+  uint8_t *mapped; // Linear images only
+  bool pooled; // The memory belongs to a render target pool
+  // Frame counter and frame index of the last frame that used the image, linear writes wait for that frame only.
+  // Images read through descriptor sets or bindless slots can be used by any frame.
+  uint64_t last_used;
+  uint32_t last_frame_index;
+  bool indirect;
 } _purrr_image_data_t;
 
 typedef struct {
-  VkDescriptorSet descriptor_set;
+  _purrr_image_data_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_image_list_t;
+
+// Largest side of a streamed texture's placeholder, smaller textures get one at half their size.
+#define PURRR_VULKAN_PLACEHOLDER_SIZE 64
+
+typedef struct {
+  _purrr_vulkan_descriptor_set_t descriptor_set;
+  uint32_t index; // Slot in the bindless array, PURRR_NO_TEXTURE_INDEX without one
+
+  // Streamed textures only
+  bool resident;
+  bool requested; // Bound while evicted, the image is brought back at the next begin_frame
+  uint64_t last_used; // Frame counter of the last bind
+  VkDeviceSize size;
+  purrr_image_t *placeholder;
+  _purrr_vulkan_descriptor_set_t placeholder_set;
 } _purrr_texture_data_t;
 
+typedef struct {
+  _purrr_texture_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_streamed_textures_t;
+
 typedef struct {
   VkRenderPass render_pass;
 } _purrr_pipeline_descriptor_data_t;
 
 typedef struct {
   VkShaderModule shader_module;
+  uint64_t code_hash; // Of the SPIR-V, pipelines are shared by code rather than by module
+  size_t code_size;
+  uint32_t *code; // Kept for pipelines that bake dynamic state variants, NULL if the device sets all of it
 } _purrr_shader_data_t;
 
+#define PURRR_VULKAN_DYNAMIC_STATES ((purrr_dynamic_state_t)((PURRR_DYNAMIC_STATE_BLEND << 1)-1))
+
+// Only 32 bit fields, so they can be compared with memcmp
 typedef struct {
+  VkCullModeFlags cull_mode;
+  VkFrontFace front_face;
+  VkPrimitiveTopology topology;
+  VkPolygonMode polygon_mode;
+  VkBool32 depth_test;
+  VkBool32 depth_write;
+  VkCompareOp depth_compare_op;
+  VkBool32 depth_bias;
+  VkBool32 stencil_test;
+  uint32_t blend_enables; // Bit per color attachment
+} _purrr_vulkan_dynamic_values_t;
+
+// Owns everything vkCreateGraphicsPipelines reads, so the pipeline can be compiled after purrr_pipeline_create_async returned.
+typedef struct _purrr_vulkan_pipeline_job_s {
+  struct _purrr_vulkan_pipeline_job_s *next;
+  bool done; // Guarded by the compiler mutex
+
+  VkPipelineShaderStageCreateInfo *stage_infos;
+  VkVertexInputAttributeDescription *vertex_attributes;
+  VkVertexInputBindingDescription binding_description;
+  VkDynamicState dynamic_states[12]; // Viewport, scissor and the ones the device sets of the pipeline's dynamic_states
+  VkPipelineDynamicStateCreateInfo dynamic_state;
+  VkPipelineVertexInputStateCreateInfo vertex_input_info;
+  VkPipelineInputAssemblyStateCreateInfo input_assembly;
+  VkPipelineViewportStateCreateInfo viewport_state;
+  VkPipelineRasterizationStateCreateInfo rasterizer;
+  VkPipelineMultisampleStateCreateInfo multisampling;
+  VkPipelineColorBlendAttachmentState *color_blend_attachments;
+  VkPipelineColorBlendStateCreateInfo color_blending;
+  VkPipelineDepthStencilStateCreateInfo depth_stencil;
+  VkPipelineCreationFeedbackEXT feedback;
+  VkPipelineCreationFeedbackEXT *stage_feedbacks;
+  VkPipelineCreationFeedbackCreateInfoEXT feedback_info;
+  VkGraphicsPipelineCreateInfo pipeline_info;
+
+  // Results, VK_NULL_HANDLE if it failed
   VkPipeline pipeline;
+  purrr_pipeline_stats_t stats;
+} _purrr_vulkan_pipeline_job_t;
+
+typedef struct {
+  _purrr_vulkan_dynamic_values_t values; // Only the baked states
+  VkPipeline pipeline; // VK_NULL_HANDLE while the job is compiling it
+  _purrr_vulkan_pipeline_job_t *job; // Until its results are picked up
+} _purrr_vulkan_pipeline_variant_t;
+
+typedef struct {
+  _purrr_vulkan_pipeline_variant_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pipeline_variants_t;
+
+typedef struct {
+  VkPipeline pipeline; // VK_NULL_HANDLE while the job is compiling it
   VkPipelineLayout pipeline_layout;
+  _purrr_vulkan_pipeline_job_t *job; // Until its results are picked up
+  purrr_dynamic_state_t dynamic_states;
+  purrr_dynamic_state_t baked_states; // The dynamic states the device can't set, variants of the pipeline are made for them
+  _purrr_vulkan_dynamic_values_t values; // What `pipeline` was created with
+  uint32_t color_attachment_count;
+  uint32_t blend_attachments; // Bit per color attachment with blend factors and ops, the others can't enable blending
+  _purrr_vulkan_pipeline_variants_t variants;
+  _purrr_vulkan_pipeline_job_t *variant_job; // Copied to create the variants from, with its own shader modules
+  VkShaderModule *modules;
+  uint32_t module_count;
+  uint32_t texture_array_slots; // Bit per descriptor slot that takes the bindless texture array
+  VkDescriptorSetLayout *set_layouts; // Per set number, descriptor slots first
+  uint32_t set_layout_count;
+  uint32_t push_slots; // Bit per descriptor slot written with push_texture/push_buffer
+  uint32_t push_set; // The one of them that uses VK_KHR_push_descriptor, UINT32_MAX if none does
+  purrr_pipeline_stats_t stats;
+  // Pipelines created from the same description share this data
+  uint64_t hash;
+  uint8_t *key;
+  size_t key_size;
+  uint32_t references;
 } _purrr_pipeline_data_t;
 
 typedef struct {
+  _purrr_pipeline_data_t **items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pipelines_t;
+
+typedef struct {
+  uint8_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pipeline_key_t;
+
+// Compiles the pipelines created with purrr_pipeline_create_async, the threads are started with the first one.
+typedef struct {
+  thrd_t *threads;
+  uint32_t thread_count;
+
+  mtx_t mutex;
+  cnd_t work_cond; // A job was queued or the compiler is stopping
+  cnd_t done_cond; // A job was compiled
+  bool stopping;
+  uint32_t pending; // Queued or compiling
+
+  _purrr_vulkan_pipeline_job_t *queue_first, *queue_last;
+} _purrr_vulkan_compiler_t;
+
+typedef struct {
+  const _purrr_vulkan_set_layout_t *layout;
+  VkDescriptorSet set; // VK_NULL_HANDLE until the first write
+  VkDescriptorPool pool;
+  bool bound; // Since the last write
+  uint64_t last_bound; // Frame counter of the last bind
+  _purrr_vulkan_descriptor_info_t *infos; // Scratch space for writes, one per binding
+} _purrr_descriptor_set_data_t;
+
+typedef struct {
+  VkRenderPass render_pass; // Compatible with the descriptor's, ends in the layouts the images rest in
   VkFramebuffer framebuffer;
 } _purrr_render_target_data_t;
 
+// Render target pools place their images into blocks of their own, one set per frame in flight so nothing the other
+// frame still uses gets overwritten. Images keep their place for as long as they live, two that are never acquired
+// at the same time within a frame can share memory.
+#define PURRR_VULKAN_POOL_BLOCK_SIZE (64*1024*1024)
+#define PURRR_VULKAN_POOL_NO_BLOCK SIZE_MAX // Transient images, they get lazily allocated memory of their own
+#define PURRR_VULKAN_POOL_MAX_IDLE 4 // Frames a pooled image or render target is kept around without being used
+
+typedef struct {
+  _purrr_vulkan_allocation_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pool_blocks_t;
+
+typedef struct {
+  _purrr_image_t *image;
+  size_t block;
+  VkDeviceSize offset, size; // Within the block
+  uint64_t last_used; // Frame counter of the last acquire
+  bool acquired;
+} _purrr_vulkan_pool_image_t;
+
+typedef struct {
+  _purrr_vulkan_pool_image_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pool_images_t;
+
+typedef struct {
+  _purrr_render_target_t *render_target;
+  purrr_image_t *images[PURRR_MAX_COLOR_ATTACHMENTS*2+1];
+  uint64_t last_used;
+} _purrr_vulkan_pool_render_target_t;
+
+typedef struct {
+  _purrr_vulkan_pool_render_target_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_vulkan_pool_render_targets_t;
+
+typedef struct {
+  _purrr_vulkan_pool_blocks_t blocks;
+  _purrr_vulkan_pool_images_t images;
+  _purrr_vulkan_pool_render_targets_t render_targets;
+} _purrr_vulkan_pool_frame_t;
+
+typedef struct {
+  _purrr_vulkan_pool_frame_t frames[2];
+  uint32_t frame_index;
+  uint64_t frame; // Frame counter the acquired images belong to
+  _purrr_vulkan_pool_image_t *placing; // The entry of the image being created
+} _purrr_render_target_pool_data_t;
+
 typedef struct {
   VkBuffer vertex_buffer;
   VkDeviceMemory vertex_buffer_memory;
@@ -99,10 +695,28 @@ typedef struct {
   VkDeviceMemory index_buffer_memory;
 } _purrr_mesh_data_t;
 
+// Dynamic descriptors have a fixed range, so every range size a buffer gets bound with needs its own set.
+// Sizes are rounded up to a power of two where that still fits the buffer, past this many sets a buffer
+// gets sets that only live for the frame instead.
+#define PURRR_VULKAN_RANGE_SET_MAX 16
+
+typedef struct {
+  VkDeviceSize range;
+  _purrr_vulkan_descriptor_set_t set;
+} _purrr_buffer_range_set_t;
+
+typedef struct {
+  _purrr_buffer_range_set_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_buffer_range_sets_t;
+
 typedef struct {
   VkBuffer buffer;
-  VkDeviceMemory buffer_memory;
-  VkDescriptorSet set;
+  _purrr_vulkan_allocation_t allocation;
+  void *mapped; // NULL unless the memory is host visible
+  _purrr_vulkan_descriptor_set_t set;
+  _purrr_buffer_range_sets_t range_sets;
 } _purrr_buffer_data_t;
 
 typedef struct {
@@ -111,11 +725,17 @@ typedef struct {
   VkPhysicalDevice gpu;
   uint32_t graphics_family;
   uint32_t present_family;
+  uint32_t transfer_family; // Same as graphics_family if the device has no dedicated transfer family
   VkDevice device;
   VkQueue graphics_queue;
   VkQueue present_queue;
+  VkQueue transfer_queue;
 
   VkCommandPool command_pool;
+  VkCommandPool transfer_command_pool;
+
+  _purrr_vulkan_allocator_t allocator;
+  _purrr_vulkan_staging_t staging;
 
   // Swapchain
   VkSurfaceFormatKHR swapchain_format;
@@ -136,11 +756,57 @@ typedef struct {
 
   _purrr_render_target_t *active_render_target;
   _purrr_pipeline_t *active_pipeline;
+  bool skip_draws; // The bound pipeline is still compiling and has no fallback
+  VkPipeline bound_pipeline; // The active pipeline or one of its variants
+  _purrr_vulkan_dynamic_values_t dynamic_values;
+  purrr_dynamic_state_t dynamic_dirty; // Changed since the last draw
 
-  VkDescriptorPool descriptor_pool;
+  _purrr_vulkan_descriptors_t descriptors;
   VkDescriptorSetLayout texture_descriptor_set_layout;
   VkDescriptorSetLayout uniform_descriptor_set_layout;
   VkDescriptorSetLayout storage_descriptor_set_layout;
+  _purrr_vulkan_bindless_t bindless;
+  _purrr_vulkan_set_layouts_t set_layouts;
+
+  _purrr_vulkan_transient_t transients[2];
+  _purrr_vulkan_readback_ring_t readback;
+  VkDeviceSize transient_range;
+  VkDeviceSize transient_alignment;
+  VkDeviceSize uniform_offset_alignment;
+  VkDeviceSize storage_offset_alignment;
+  VkDeviceSize uniform_max_range;
+  VkDeviceSize storage_max_range;
+
+  VkPhysicalDeviceFeatures features; // The enabled ones
+
+  _purrr_vulkan_streamed_textures_t streamed_textures;
+  _purrr_vulkan_image_list_t preinitialized; // Linear images still in PREINITIALIZED, moved to GENERAL by whatever uses them first
+  VkDeviceSize streamed_size; // Resident bytes of the streamed textures
+  uint64_t frame_counter;
+  bool memory_budget; // VK_EXT_memory_budget is enabled
+  PFN_vkGetPhysicalDeviceMemoryProperties2 get_memory_properties2; // NULL without VK_KHR_get_physical_device_properties2
+  // NULL without VK_KHR_descriptor_update_template
+  PFN_vkCreateDescriptorUpdateTemplateKHR create_update_template;
+  PFN_vkDestroyDescriptorUpdateTemplateKHR destroy_update_template;
+  PFN_vkUpdateDescriptorSetWithTemplateKHR update_with_template;
+  PFN_vkCmdPushDescriptorSetKHR cmd_push_descriptor_set; // NULL without VK_KHR_push_descriptor
+  // Set with the VK_EXT_extended_dynamic_state(2/3) commands below, the other states are baked into pipeline variants
+  purrr_dynamic_state_t native_dynamic_states;
+  PFN_vkCmdSetCullModeEXT cmd_set_cull_mode;
+  PFN_vkCmdSetFrontFaceEXT cmd_set_front_face;
+  PFN_vkCmdSetPrimitiveTopologyEXT cmd_set_primitive_topology;
+  PFN_vkCmdSetPolygonModeEXT cmd_set_polygon_mode;
+  PFN_vkCmdSetDepthTestEnableEXT cmd_set_depth_test_enable;
+  PFN_vkCmdSetDepthWriteEnableEXT cmd_set_depth_write_enable;
+  PFN_vkCmdSetDepthCompareOpEXT cmd_set_depth_compare_op;
+  PFN_vkCmdSetDepthBiasEnableEXT cmd_set_depth_bias_enable;
+  PFN_vkCmdSetStencilTestEnableEXT cmd_set_stencil_test_enable;
+  PFN_vkCmdSetColorBlendEnableEXT cmd_set_color_blend_enable;
+
+  VkPipelineCache pipeline_cache;
+  _purrr_vulkan_pipelines_t pipelines;
+  _purrr_vulkan_compiler_t compiler;
+  bool creation_feedback; // VK_EXT_pipeline_creation_feedback is enabled
 
   VkSampler sampler;
 } _purrr_renderer_data_t;
@@ -162,6 +828,24 @@ VkFormat vk_format(_purrr_renderer_data_t *data, purrr_format_t format) {
   case PURRR_FORMAT_RGBA32F:    return VK_FORMAT_R32G32B32A32_SFLOAT;
   case PURRR_FORMAT_RGBA64F:    return VK_FORMAT_R64G64B64A64_SFLOAT;
 
+  case PURRR_FORMAT_BC1U:         return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+  case PURRR_FORMAT_BC1RGB:       return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+  case PURRR_FORMAT_BC2U:         return VK_FORMAT_BC2_UNORM_BLOCK;
+  case PURRR_FORMAT_BC2RGB:       return VK_FORMAT_BC2_SRGB_BLOCK;
+  case PURRR_FORMAT_BC3U:         return VK_FORMAT_BC3_UNORM_BLOCK;
+  case PURRR_FORMAT_BC3RGB:       return VK_FORMAT_BC3_SRGB_BLOCK;
+  case PURRR_FORMAT_BC4U:         return VK_FORMAT_BC4_UNORM_BLOCK;
+  case PURRR_FORMAT_BC5U:         return VK_FORMAT_BC5_UNORM_BLOCK;
+  case PURRR_FORMAT_BC6HF:        return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+  case PURRR_FORMAT_BC7U:         return VK_FORMAT_BC7_UNORM_BLOCK;
+  case PURRR_FORMAT_BC7RGB:       return VK_FORMAT_BC7_SRGB_BLOCK;
+  case PURRR_FORMAT_ETC2RGB8U:    return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+  case PURRR_FORMAT_ETC2RGB8RGB:  return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+  case PURRR_FORMAT_ETC2RGBA8U:   return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+  case PURRR_FORMAT_ETC2RGBA8RGB: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+  case PURRR_FORMAT_ASTC4x4U:     return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+  case PURRR_FORMAT_ASTC4x4RGB:   return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+
   case PURRR_FORMAT_DEPTH: {
     VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
     for (uint32_t i = 0; i < sizeof(candidates)/sizeof(candidates[0]); ++i) {
@@ -192,11 +876,31 @@ VkDeviceSize format_size(purrr_format_t format) {
   case PURRR_FORMAT_RGBA8RGB:   return 4;
   case PURRR_FORMAT_BGRA8U:     return 4;
   case PURRR_FORMAT_BGRA8RGB:   return 4;
-  case PURRR_FORMAT_RGBA16F:    return 4;
-  case PURRR_FORMAT_RG32F:      return 2;
-  case PURRR_FORMAT_RGB32F:     return 3;
-  case PURRR_FORMAT_RGBA32F:    return 4;
-  case PURRR_FORMAT_RGBA64F:    return 4;
+  case PURRR_FORMAT_RGBA16F:    return 8;
+  case PURRR_FORMAT_RG32F:      return 8;
+  case PURRR_FORMAT_RGB32F:     return 12;
+  case PURRR_FORMAT_RGBA32F:    return 16;
+  case PURRR_FORMAT_RGBA64F:    return 32;
+
+  // Compressed formats return the size of a whole block
+  case PURRR_FORMAT_BC1U:         return 8;
+  case PURRR_FORMAT_BC1RGB:       return 8;
+  case PURRR_FORMAT_BC2U:         return 16;
+  case PURRR_FORMAT_BC2RGB:       return 16;
+  case PURRR_FORMAT_BC3U:         return 16;
+  case PURRR_FORMAT_BC3RGB:       return 16;
+  case PURRR_FORMAT_BC4U:         return 8;
+  case PURRR_FORMAT_BC5U:         return 16;
+  case PURRR_FORMAT_BC6HF:        return 16;
+  case PURRR_FORMAT_BC7U:         return 16;
+  case PURRR_FORMAT_BC7RGB:       return 16;
+  case PURRR_FORMAT_ETC2RGB8U:    return 8;
+  case PURRR_FORMAT_ETC2RGB8RGB:  return 8;
+  case PURRR_FORMAT_ETC2RGBA8U:   return 16;
+  case PURRR_FORMAT_ETC2RGBA8RGB: return 16;
+  case PURRR_FORMAT_ASTC4x4U:     return 16;
+  case PURRR_FORMAT_ASTC4x4RGB:   return 16;
+
   case PURRR_FORMAT_DEPTH:      return 0; // idc
 
   case COUNT_PURRR_FORMATS:
@@ -207,6 +911,20 @@ VkDeviceSize format_size(purrr_format_t format) {
   }
 }
 
+bool format_is_compressed(purrr_format_t format) {
+  return format >= PURRR_FORMAT_BC1U && format <= PURRR_FORMAT_ASTC4x4RGB;
+}
+
+// Width and height of a block in texels, every compressed format we have uses 4x4 blocks.
+uint32_t format_block_extent(purrr_format_t format) {
+  return format_is_compressed(format)?4:1;
+}
+
+VkDeviceSize format_image_size(purrr_format_t format, uint32_t width, uint32_t height) {
+  uint32_t block = format_block_extent(format);
+  return (VkDeviceSize)((width+block-1)/block)*((height+block-1)/block)*format_size(format);
+}
+
 purrr_format_t purrr_format(VkFormat format) {
   switch (format) {
   case VK_FORMAT_UNDEFINED:           return PURRR_FORMAT_UNDEFINED;
@@ -261,6 +979,36 @@ bool _purrr_renderer_vulkan_find_queue_families(VkSurfaceKHR surface, VkPhysical
       && p != UINT32_MAX;
 }
 
+// Prefers a transfer only family (those usually map to the DMA engines), then one without graphics.
+// Only families with a 1x1x1 image transfer granularity are considered, so partial image copies stay valid.
+uint32_t _purrr_renderer_vulkan_find_transfer_family(VkPhysicalDevice device, uint32_t graphics_family) {
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, VK_NULL_HANDLE);
+  VkQueueFamilyProperties *queueFamilies = (VkQueueFamilyProperties*)malloc(sizeof(*queueFamilies)*queueFamilyCount);
+  assert(queueFamilies);
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies);
+
+  uint32_t dedicated = UINT32_MAX;
+  uint32_t separate = UINT32_MAX;
+
+  for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+    VkQueueFlags flags = queueFamilies[i].queueFlags;
+    VkExtent3D granularity = queueFamilies[i].minImageTransferGranularity;
+    if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT)) continue;
+    if (granularity.width != 1 || granularity.height != 1 || granularity.depth != 1) continue;
+
+    if (!(flags & VK_QUEUE_COMPUTE_BIT)) {
+      if (dedicated == UINT32_MAX) dedicated = i;
+    } else if (separate == UINT32_MAX) separate = i;
+  }
+
+  free(queueFamilies);
+
+  if (dedicated != UINT32_MAX) return dedicated;
+  if (separate != UINT32_MAX) return separate;
+  return graphics_family;
+}
+
 typedef struct {
   VkSurfaceCapabilitiesKHR capabilities;
   uint32_t format_count;
@@ -297,6 +1045,30 @@ static _purrr_renderer_vulkan_swapchain_details_t _purrr_renderer_vulkan_request
 
 // Utils
 
+static bool _purrr_vulkan_has_extension(const VkExtensionProperties *properties, uint32_t count, const char *name) {
+  for (uint32_t i = 0; i < count; ++i)
+    if (strcmp(properties[i].extensionName, name) == 0) return true;
+  return false;
+}
+
+static uint32_t _purrr_vulkan_cpu_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (uint32_t)info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return (count > 0)?(uint32_t)count:1;
+#endif
+}
+
+static uint64_t _purrr_vulkan_hash(const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t*)data;
+  uint64_t hash = 14695981039346656037ull; // FNV-1a
+  for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+  return hash;
+}
+
 VkCommandBuffer _purrr_vulkan_begin_single_time(_purrr_renderer_data_t *data) {
   VkCommandBufferAllocateInfo allocInfo = {0};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -330,12 +1102,7 @@ void _purrr_vulkan_end_single_time(_purrr_renderer_data_t *data, VkCommandBuffer
   vkFreeCommandBuffers(data->device, data->command_pool, 1, &command_buf);
 }
 
-void _purrr_vulkan_transition_image_layout(_purrr_renderer_data_t *data, VkImage image,
-                                           VkImageLayout old_layout, VkImageLayout new_layout,
-                                           VkAccessFlags src_access, VkAccessFlags dst_access,
-                                           VkPipelineStageFlagBits src_stage, VkPipelineStageFlagBits dst_stage) {
-  VkCommandBuffer command_buf = _purrr_vulkan_begin_single_time(data);
-
+VkImageMemoryBarrier _purrr_vulkan_image_barrier(VkImage image, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
   VkImageMemoryBarrier barrier = {
     .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
     .oldLayout = old_layout,
@@ -345,7 +1112,7 @@ void _purrr_vulkan_transition_image_layout(_purrr_renderer_data_t *data, VkImage
     .image = image,
     .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
     .subresourceRange.baseMipLevel = 0,
-    .subresourceRange.levelCount = 1,
+    .subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS,
     .subresourceRange.baseArrayLayer = 0,
     .subresourceRange.layerCount = 1,
     .srcAccessMask = src_access,
@@ -353,6 +1120,14 @@ void _purrr_vulkan_transition_image_layout(_purrr_renderer_data_t *data, VkImage
   };
   if (new_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;// | VK_IMAGE_ASPECT_STENCIL_BIT;
+  return barrier;
+}
+
+void _purrr_vulkan_cmd_transition_image_layout(VkCommandBuffer command_buf, VkImage image,
+                                               VkImageLayout old_layout, VkImageLayout new_layout,
+                                               VkAccessFlags src_access, VkAccessFlags dst_access,
+                                               VkPipelineStageFlagBits src_stage, VkPipelineStageFlagBits dst_stage) {
+  VkImageMemoryBarrier barrier = _purrr_vulkan_image_barrier(image, old_layout, new_layout, src_access, dst_access);
 
   vkCmdPipelineBarrier(
     command_buf,
@@ -362,29 +1137,44 @@ void _purrr_vulkan_transition_image_layout(_purrr_renderer_data_t *data, VkImage
     0, VK_NULL_HANDLE,
     1, &barrier
   );
-
-  _purrr_vulkan_end_single_time(data, command_buf);
 }
 
-void _purrr_renderer_vulkan_copy_buffer(_purrr_renderer_data_t *data, VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize offset) {
-  VkCommandBuffer cmd_buf = _purrr_vulkan_begin_single_time(data);
-
-  VkBufferCopy copy_region = {
-    .size = size,
-    .srcOffset = 0,
+void _purrr_vulkan_transition_image_layout(_purrr_renderer_data_t *data, VkImage image,
+                                           VkImageLayout old_layout, VkImageLayout new_layout,
+                                           VkAccessFlags src_access, VkAccessFlags dst_access,
+                                           VkPipelineStageFlagBits src_stage, VkPipelineStageFlagBits dst_stage) {
+  VkCommandBuffer command_buf = _purrr_vulkan_begin_single_time(data);
+  _purrr_vulkan_cmd_transition_image_layout(command_buf, image, old_layout, new_layout, src_access, dst_access, src_stage, dst_stage);
+  _purrr_vulkan_end_single_time(data, command_buf);
+}
+
+void _purrr_renderer_vulkan_copy_buffer(VkCommandBuffer cmd_buf, VkBuffer src, VkDeviceSize src_offset, VkBuffer dst, VkDeviceSize size, VkDeviceSize offset) {
+  // Don't overwrite data that earlier submissions may still be reading.
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+
+  VkBufferCopy copy_region = {
+    .size = size,
+    .srcOffset = src_offset,
     .dstOffset = offset,
   };
   vkCmdCopyBuffer(cmd_buf, src, dst, 1, &copy_region);
 
-  _purrr_vulkan_end_single_time(data, cmd_buf);
+  VkMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
 }
 
-void _purrr_renderer_vulkan_copy_buffer_to_image(_purrr_renderer_data_t *data, VkBuffer src, VkImage dst, uint32_t width, uint32_t height) {
-  VkCommandBuffer cmd_buf = _purrr_vulkan_begin_single_time(data);
-
+// The source rows are tightly packed whole blocks, so the pitch is rounded up to the block extent.
+void _purrr_renderer_vulkan_copy_buffer_to_image(VkCommandBuffer cmd_buf, VkBuffer src, VkDeviceSize src_offset, VkImage dst, uint32_t mip_level, uint32_t block_extent, uint32_t width, uint32_t height) {
   VkBufferImageCopy region = {
+    .bufferOffset = src_offset,
+    .bufferRowLength = (width+block_extent-1)/block_extent*block_extent,
+    .bufferImageHeight = (height+block_extent-1)/block_extent*block_extent,
     .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-    .imageSubresource.mipLevel = 0,
+    .imageSubresource.mipLevel = mip_level,
     .imageSubresource.baseArrayLayer = 0,
     .imageSubresource.layerCount = 1,
     .imageExtent = {
@@ -394,945 +1184,4640 @@ void _purrr_renderer_vulkan_copy_buffer_to_image(_purrr_renderer_data_t *data, V
     },
   };
   vkCmdCopyBufferToImage(cmd_buf, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
 
-  _purrr_vulkan_end_single_time(data, cmd_buf);
+void _purrr_renderer_vulkan_copy_image_to_buffer(VkCommandBuffer cmd_buf, VkImage src, uint32_t mip_level, VkBuffer dst, VkDeviceSize dst_offset, uint32_t block_extent, uint32_t width, uint32_t height) {
+  VkBufferImageCopy region = {
+    .bufferOffset = dst_offset,
+    .bufferRowLength = (width+block_extent-1)/block_extent*block_extent,
+    .bufferImageHeight = (height+block_extent-1)/block_extent*block_extent,
+    .imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .imageSubresource.mipLevel = mip_level,
+    .imageSubresource.baseArrayLayer = 0,
+    .imageSubresource.layerCount = 1,
+    .imageExtent = {
+      width,
+      height,
+      1
+    },
+  };
+  vkCmdCopyImageToBuffer(cmd_buf, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst, 1, &region);
 }
 
-uint32_t _purrr_renderer_vulkan_find_memory_type(_purrr_renderer_data_t *data, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties = {0};
-  vkGetPhysicalDeviceMemoryProperties(data->gpu, &memProperties);
+// Expects every level in TRANSFER_DST_OPTIMAL with the first one filled, leaves all of them in TRANSFER_SRC_OPTIMAL.
+void _purrr_vulkan_cmd_generate_mips(VkCommandBuffer cmd_buf, VkImage image, uint32_t width, uint32_t height, uint32_t mip_levels, VkFilter filter) {
+  VkImageMemoryBarrier barrier = _purrr_vulkan_image_barrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+  barrier.subresourceRange.levelCount = 1;
+
+  int32_t mip_width = (int32_t)width, mip_height = (int32_t)height;
+  for (uint32_t i = 1; i < mip_levels; ++i) {
+    barrier.subresourceRange.baseMipLevel = i-1;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 1, &barrier);
+
+    int32_t next_width = (mip_width>1?mip_width/2:1), next_height = (mip_height>1?mip_height/2:1);
+    VkImageBlit blit = {
+      .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i-1, 0, 1 },
+      .srcOffsets = { { 0, 0, 0 }, { mip_width, mip_height, 1 } },
+      .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 },
+      .dstOffsets = { { 0, 0, 0 }, { next_width, next_height, 1 } },
+    };
+    vkCmdBlitImage(cmd_buf, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
 
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-      return i;
+    mip_width = next_width;
+    mip_height = next_height;
   }
 
-  return UINT32_MAX;
+  barrier.subresourceRange.baseMipLevel = mip_levels-1;
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 1, &barrier);
 }
 
-bool _purrr_renderer_vulkan_create_buffer(_purrr_renderer_data_t *data, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer *buffer, VkDeviceMemory *buffer_memory) {
-  VkBufferCreateInfo buffer_info = {
-    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-    .size = size,
-    .usage = usage,
-    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-  };
+// Returns a type with all of `properties` and `preferred`, or one with just `properties` if there's none.
+uint32_t _purrr_renderer_vulkan_find_memory_type(_purrr_renderer_data_t *data, uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred) {
+  VkPhysicalDeviceMemoryProperties *memProperties = &data->allocator.memory_properties;
 
-  if (vkCreateBuffer(data->device, &buffer_info, VK_NULL_HANDLE, buffer) != VK_SUCCESS) return false;
+  VkMemoryPropertyFlags wanted = properties | preferred;
+  for (uint32_t i = 0; i < memProperties->memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) && (memProperties->memoryTypes[i].propertyFlags & wanted) == wanted)
+      return i;
+  }
 
-  VkMemoryRequirements memRequirements = {0};
-  vkGetBufferMemoryRequirements(data->device, *buffer, &memRequirements);
+  for (uint32_t i = 0; i < memProperties->memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) && (memProperties->memoryTypes[i].propertyFlags & properties) == properties)
+      return i;
+  }
 
-  VkMemoryAllocateInfo alloc_info = {
-    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    .allocationSize = memRequirements.size,
-    .memoryTypeIndex = _purrr_renderer_vulkan_find_memory_type(data, memRequirements.memoryTypeBits, properties),
-  };
+  return UINT32_MAX;
+}
 
-  if (vkAllocateMemory(data->device, &alloc_info, VK_NULL_HANDLE, buffer_memory) != VK_SUCCESS) return false;
+// allocator
 
-  vkBindBufferMemory(data->device, *buffer, *buffer_memory, 0);
+// Makes room for one more offset.
+static bool _purrr_vulkan_free_list_reserve(_purrr_vulkan_free_list_t *list) {
+  if (list->count < list->capacity) return true;
+  size_t capacity = (list->capacity?list->capacity*2:8);
+  uint32_t *items = (uint32_t*)realloc(list->items, sizeof(*items)*capacity);
+  if (!items) return false;
+  list->items = items;
+  list->capacity = capacity;
+  return true;
+}
 
+static bool _purrr_vulkan_free_list_push(_purrr_vulkan_free_list_t *list, uint32_t offset) {
+  if (!_purrr_vulkan_free_list_reserve(list)) return false;
+  list->items[list->count++] = offset;
   return true;
 }
 
-// sampler
+static bool _purrr_vulkan_free_list_remove(_purrr_vulkan_free_list_t *list, uint32_t offset) {
+  for (size_t i = 0; i < list->count; ++i) {
+    if (list->items[i] != offset) continue;
+    list->items[i] = list->items[--list->count];
+    return true;
+  }
+  return false;
+}
 
-bool _purrr_sampler_vulkan_init(_purrr_sampler_t *sampler) {
-  if (!sampler || !sampler->renderer || !sampler->renderer->initialized) return false;
-  _purrr_sampler_data_t *data = (_purrr_sampler_data_t*)malloc(sizeof(*data));
-  assert(data);
-  memset(data, 0, sizeof(*data));
+static uint32_t _purrr_vulkan_log2(VkDeviceSize value) {
+  uint32_t result = 0;
+  while ((1ull<<result) < value) ++result;
+  return result;
+}
 
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)sampler->renderer->data_ptr;
+bool _purrr_vulkan_allocator_init(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_allocator_t *allocator = &data->allocator;
+  memset(allocator, 0, sizeof(*allocator));
 
-  {
-    VkSamplerCreateInfo sampler_info = {
-      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-      .magFilter = vk_filter(sampler->info.mag_filter),
-      .minFilter = vk_filter(sampler->info.min_filter),
-      .addressModeU = vk_sampler_address_mode(sampler->info.address_mode_u),
-      .addressModeV = vk_sampler_address_mode(sampler->info.address_mode_v),
-      .addressModeW = vk_sampler_address_mode(sampler->info.address_mode_w),
-      .anisotropyEnable = VK_FALSE, // TODO:
-      .maxAnisotropy = 1.0f, // TODO:
-      .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-      .unnormalizedCoordinates = VK_FALSE,
-      .compareEnable = VK_FALSE,
-      .compareOp = VK_COMPARE_OP_ALWAYS,
-      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-      .mipLodBias = 0.0f,
-      .minLod = 0.0f,
-      .maxLod = 0.0f,
-    };
+  vkGetPhysicalDeviceMemoryProperties(data->gpu, &allocator->memory_properties);
 
-    if (vkCreateSampler(renderer_data->device, &sampler_info, VK_NULL_HANDLE, &data->sampler) != VK_SUCCESS) goto error;
+  VkPhysicalDeviceProperties properties = {0};
+  vkGetPhysicalDeviceProperties(data->gpu, &properties);
+  allocator->buffer_image_granularity = properties.limits.bufferImageGranularity;
+  allocator->max_allocation_count = properties.limits.maxMemoryAllocationCount;
+
+  // Small heaps (like the 256MiB BAR heap) get smaller blocks so a single block can't eat them.
+  for (uint32_t i = 0; i < allocator->memory_properties.memoryTypeCount; ++i) {
+    VkDeviceSize heap_size = allocator->memory_properties.memoryHeaps[allocator->memory_properties.memoryTypes[i].heapIndex].size;
+    VkDeviceSize block_size = PURRR_VULKAN_MAX_BLOCK_SIZE;
+    while (block_size > PURRR_VULKAN_MIN_BLOCK_SIZE && block_size > heap_size/8) block_size >>= 1;
+    allocator->block_sizes[i] = block_size;
   }
 
-  sampler->initialized = true;
-  sampler->data_ptr = data;
+  // Without resizable BAR the host visible part of VRAM is only a 256MiB window.
+  for (uint32_t i = 0; i < allocator->memory_properties.memoryTypeCount; ++i) {
+    VkMemoryType type = allocator->memory_properties.memoryTypes[i];
+    VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    if ((type.propertyFlags & flags) == flags && allocator->memory_properties.memoryHeaps[type.heapIndex].size > 256ull*1024*1024) allocator->rebar = true;
+  }
 
   return true;
-error:
-  free(data);
-  return false;
 }
 
-void _purrr_sampler_vulkan_cleanup(_purrr_sampler_t *sampler) {
-  if (!sampler || !sampler->initialized) return;
-  assert(sampler->renderer);
-  _purrr_sampler_data_t *data = (_purrr_sampler_data_t*)sampler->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)sampler->renderer->data_ptr;
-  assert(data && renderer_data);
-  vkDestroySampler(renderer_data->device, data->sampler, VK_NULL_HANDLE);
+static void _purrr_vulkan_block_destroy(_purrr_renderer_data_t *data, _purrr_vulkan_memory_block_t *block) {
+  if (block->mapped) vkUnmapMemory(data->device, block->memory);
+  vkFreeMemory(data->device, block->memory, VK_NULL_HANDLE);
+  --data->allocator.allocation_count;
+  for (uint32_t i = 0; i <= block->max_order; ++i) free(block->free_lists[i].items);
+  free(block->free_lists);
+  free(block);
 }
 
-// image
+void _purrr_vulkan_allocator_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_allocator_t *allocator = &data->allocator;
+  for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+    for (uint32_t j = 0; j < 2; ++j) {
+      _purrr_vulkan_memory_pool_t *pool = &allocator->pools[i][j];
+      for (size_t k = 0; k < pool->count; ++k) _purrr_vulkan_block_destroy(data, pool->items[k]);
+      free(pool->items);
+      pool->items = NULL;
+      pool->count = pool->capacity = 0;
+    }
+  }
+}
 
-bool _purrr_image_vulkan_init(_purrr_image_t *image) {
-  if (!image || !image->renderer || !image->renderer->initialized) return false;
-  _purrr_image_data_t *data = (_purrr_image_data_t*)malloc(sizeof(*data));
-  assert(data);
-  memset(data, 0, sizeof(*data));
+static bool _purrr_vulkan_allocate_memory(_purrr_renderer_data_t *data, VkDeviceSize size, uint32_t memory_type, VkDeviceMemory *memory) {
+  _purrr_vulkan_allocator_t *allocator = &data->allocator;
+  if (allocator->max_allocation_count && allocator->allocation_count >= allocator->max_allocation_count) return false;
 
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)image->renderer->data_ptr;
-  assert(renderer_data);
+  VkMemoryAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize = size,
+    .memoryTypeIndex = memory_type,
+  };
 
-  VkFormat format = vk_format(renderer_data, image->info.format);
-  VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-  VkImageAspectFlags aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT;
+  if (vkAllocateMemory(data->device, &alloc_info, VK_NULL_HANDLE, memory) != VK_SUCCESS) return false;
+  ++allocator->allocation_count;
+  return true;
+}
 
-  bool depth = (image->info.format==PURRR_FORMAT_DEPTH);
-  if (depth) {
-    usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    aspect_flags = VK_IMAGE_ASPECT_DEPTH_BIT;
+static _purrr_vulkan_memory_block_t *_purrr_vulkan_block_create(_purrr_renderer_data_t *data, _purrr_vulkan_memory_pool_t *pool, uint32_t memory_type) {
+  _purrr_vulkan_memory_block_t *block = (_purrr_vulkan_memory_block_t*)malloc(sizeof(*block));
+  if (!block) return NULL;
+  memset(block, 0, sizeof(*block));
+
+  block->size = data->allocator.block_sizes[memory_type];
+  block->max_order = _purrr_vulkan_log2(block->size) - PURRR_VULKAN_MIN_CHUNK_SHIFT;
+  block->free_lists = (_purrr_vulkan_free_list_t*)malloc(sizeof(*block->free_lists)*(block->max_order+1));
+  if (!block->free_lists) goto error;
+  memset(block->free_lists, 0, sizeof(*block->free_lists)*(block->max_order+1));
+  if (!_purrr_vulkan_free_list_push(&block->free_lists[block->max_order], 0)) goto error;
+
+  if (pool->count >= pool->capacity) {
+    size_t capacity = (pool->capacity?pool->capacity*2:4);
+    _purrr_vulkan_memory_block_t **items = (_purrr_vulkan_memory_block_t**)realloc(pool->items, sizeof(*items)*capacity);
+    if (!items) goto error;
+    pool->items = items;
+    pool->capacity = capacity;
   }
 
-  {
-    VkImageCreateInfo create_info = {
-      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, VK_NULL_HANDLE, 0,
-      VK_IMAGE_TYPE_2D,
-      format,
-      (VkExtent3D){
-        .width = image->info.width,
-        .height = image->info.height,
-        .depth = 1,
-      },
-      1, // TODO: Implement, I forgot what it was an am too lazy to check :p
-      1,
-      (VkSampleCountFlagBits)1<<image->info.sample_count,
-      VK_IMAGE_TILING_OPTIMAL, // TODO: Add an option for tiling (if needed)
-      (VkImageUsageFlags)(usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT),
-      VK_SHARING_MODE_EXCLUSIVE,
-      0, NULL,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-    };
+  if (!_purrr_vulkan_allocate_memory(data, block->size, memory_type, &block->memory)) goto error;
 
-    if (vkCreateImage(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->image) != VK_SUCCESS) goto error;
+  block->pool = pool;
+  pool->items[pool->count++] = block;
+
+  return block;
+error:
+  if (block->free_lists) {
+    free(block->free_lists[block->max_order].items);
+    free(block->free_lists);
   }
+  free(block);
+  return NULL;
+}
 
-  {
-    VkMemoryRequirements memRequirements = {0};
-    vkGetImageMemoryRequirements(renderer_data->device, data->image, &memRequirements);
+static bool _purrr_vulkan_block_alloc(_purrr_vulkan_memory_block_t *block, uint32_t order, uint32_t *offset) {
+  uint32_t current = order;
+  while (current <= block->max_order && block->free_lists[current].count == 0) ++current;
+  if (current > block->max_order) return false;
 
-    VkMemoryAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = memRequirements.size;
-    alloc_info.memoryTypeIndex = _purrr_renderer_vulkan_find_memory_type(renderer_data, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (alloc_info.memoryTypeIndex == UINT32_MAX) return false;
+  // Room for the upper halves first, so the chunk can't get lost halfway through splitting it.
+  for (uint32_t i = order; i < current; ++i)
+    if (!_purrr_vulkan_free_list_reserve(&block->free_lists[i])) return false;
 
-    if (vkAllocateMemory(renderer_data->device, &alloc_info, VK_NULL_HANDLE, &data->image_memory) != VK_SUCCESS) goto error;
+  _purrr_vulkan_free_list_t *list = &block->free_lists[current];
+  uint32_t result = list->items[--list->count];
 
-    vkBindImageMemory(renderer_data->device, data->image, data->image_memory, 0);
+  // Split until we get to the requested order, upper halves go back to the free lists.
+  while (current > order) {
+    --current;
+    _purrr_vulkan_free_list_t *half_list = &block->free_lists[current];
+    half_list->items[half_list->count++] = result + (1u<<current);
   }
 
-  {
-    VkImageViewCreateInfo create_info = {
-      VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, VK_NULL_HANDLE, 0,
-      data->image,
-      VK_IMAGE_VIEW_TYPE_2D,
-      format,
-      (VkComponentMapping){0},
-      (VkImageSubresourceRange){
-        aspect_flags,
-        0,
-        1,
-        0,
-        1,
-      },
-    };
-
-    if (vkCreateImageView(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->image_view) != VK_SUCCESS) goto error;
-  }
+  block->used += (1ull<<order)<<PURRR_VULKAN_MIN_CHUNK_SHIFT;
+  *offset = result;
+  return true;
+}
 
-  // if (depth) {
-  //   _purrr_vulkan_transition_image_layout(renderer_data, data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-  //                                         0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-  //                                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
-  // }
+static void _purrr_vulkan_block_free(_purrr_vulkan_memory_block_t *block, uint32_t offset, uint32_t order) {
+  block->used -= (1ull<<order)<<PURRR_VULKAN_MIN_CHUNK_SHIFT;
 
-  image->initialized = true;
-  image->data_ptr = data;
+  // Merge with the buddy as long as it's free.
+  while (order < block->max_order) {
+    uint32_t buddy = offset ^ (1u<<order);
+    if (!_purrr_vulkan_free_list_remove(&block->free_lists[order], buddy)) break;
+    offset = min(offset, buddy);
+    ++order;
+  }
 
-  return true;
-error:
-  free(data);
-  return false;
+  bool pushed = _purrr_vulkan_free_list_push(&block->free_lists[order], offset);
+  assert(pushed);
+  (void)pushed;
 }
 
-void _purrr_image_vulkan_cleanup(_purrr_image_t *image) {
-  if (!image || !image->initialized) return;
-  assert(image->renderer);
-  _purrr_image_data_t *data = (_purrr_image_data_t*)image->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)image->renderer->data_ptr;
-  assert(data && renderer_data);
-  vkDestroyImageView(renderer_data->device, data->image_view, VK_NULL_HANDLE);
-  vkFreeMemory(renderer_data->device, data->image_memory, VK_NULL_HANDLE);
-  vkDestroyImage(renderer_data->device, data->image, VK_NULL_HANDLE);
-}
+static bool _purrr_vulkan_allocate_type(_purrr_renderer_data_t *data, VkMemoryRequirements requirements, uint32_t memory_type, bool linear, _purrr_vulkan_allocation_t *allocation) {
+  _purrr_vulkan_allocator_t *allocator = &data->allocator;
+  memset(allocation, 0, sizeof(*allocation));
+  allocation->memory_type = memory_type;
 
-bool _purrr_image_vulkan_load(_purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint32_t src_height) {
-  if (!dst || !dst->initialized || !dst->renderer || !dst->renderer->initialized) return false;
-  _purrr_image_data_t *data = (_purrr_image_data_t*)dst->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)dst->renderer->data_ptr;
-  assert(data && renderer_data);
-  if (dst->info.width < src_width || dst->info.height < src_height) return false;
+  VkDeviceSize chunk_size = max(requirements.size, requirements.alignment);
+  uint32_t shift = max(_purrr_vulkan_log2(chunk_size), PURRR_VULKAN_MIN_CHUNK_SHIFT);
 
-  VkDeviceSize size = src_width*src_height*format_size(dst->info.format);
+  if ((1ull<<shift) > allocator->block_sizes[memory_type]) { // dedicated
+    allocation->size = requirements.size;
+    return _purrr_vulkan_allocate_memory(data, requirements.size, memory_type, &allocation->memory);
+  }
 
-  VkBuffer staging_buffer;
-  VkDeviceMemory staging_buffer_memory;
-  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging_buffer, &staging_buffer_memory)) return false;
+  uint32_t order = shift - PURRR_VULKAN_MIN_CHUNK_SHIFT;
 
-  void* buffer_data;
-  vkMapMemory(renderer_data->device, staging_buffer_memory, 0, size, 0, &buffer_data);
-    memcpy(buffer_data, src, (size_t)size);
-  vkUnmapMemory(renderer_data->device, staging_buffer_memory);
+  // Chunks are aligned to their size, so buffers and optimal images can only end up on the same
+  // "page" if the granularity is bigger than the smallest chunk.
+  bool split = allocator->buffer_image_granularity > (1ull<<PURRR_VULKAN_MIN_CHUNK_SHIFT);
+  _purrr_vulkan_memory_pool_t *pool = &allocator->pools[memory_type][(split && !linear)?1:0];
 
-  _purrr_vulkan_transition_image_layout(renderer_data, data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-  _purrr_renderer_vulkan_copy_buffer_to_image(renderer_data, staging_buffer, data->image, src_width, src_height);
-  _purrr_vulkan_transition_image_layout(renderer_data, data->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+  _purrr_vulkan_memory_block_t *block = NULL;
+  uint32_t offset = 0;
+  for (size_t i = 0; i < pool->count; ++i) {
+    if (_purrr_vulkan_block_alloc(pool->items[i], order, &offset)) {
+      block = pool->items[i];
+      break;
+    }
+  }
 
-  vkDestroyBuffer(renderer_data->device, staging_buffer, VK_NULL_HANDLE);
-  vkFreeMemory(renderer_data->device, staging_buffer_memory, VK_NULL_HANDLE);
+  if (!block) {
+    if (!(block = _purrr_vulkan_block_create(data, pool, memory_type))) return false;
+    if (!_purrr_vulkan_block_alloc(block, order, &offset)) return false;
+  }
 
-  return true;
-}
+  allocation->block = block;
+  allocation->memory = block->memory;
+  allocation->offset = (VkDeviceSize)offset<<PURRR_VULKAN_MIN_CHUNK_SHIFT;
+  allocation->size = requirements.size;
+  allocation->order = order;
 
-bool _purrr_image_vulkan_copy(_purrr_image_t *dst, _purrr_image_t *src, uint32_t src_width, uint32_t src_height) {
-  (void)dst;
-  (void)src;
-  (void)src_width;
-  (void)src_height;
   return true;
 }
 
-// texture
+bool _purrr_vulkan_allocate(_purrr_renderer_data_t *data, VkMemoryRequirements requirements, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred, bool linear, _purrr_vulkan_allocation_t *allocation) {
+  assert(data && allocation);
 
-bool _purrr_texture_vulkan_init(_purrr_texture_t *texture) {
-  if (!texture || !texture->renderer || !texture->renderer->initialized) return false;
-  _purrr_texture_data_t *data = (_purrr_texture_data_t*)malloc(sizeof(*data));
-  assert(data);
-  memset(data, 0, sizeof(*data));
+  uint32_t type_bits = requirements.memoryTypeBits;
+  while (true) {
+    uint32_t memory_type = _purrr_renderer_vulkan_find_memory_type(data, type_bits, properties, preferred);
+    if (memory_type == UINT32_MAX) return false;
+    if (_purrr_vulkan_allocate_type(data, requirements, memory_type, linear, allocation)) return true;
+    type_bits &= ~(1u << memory_type); // The heap is probably full (small BAR heaps fill up quickly), try the next best type
+  }
+}
 
-  _purrr_image_data_t *image_data = (_purrr_image_data_t*)((_purrr_image_t*)texture->info.image)->data_ptr;
+void _purrr_vulkan_free(_purrr_renderer_data_t *data, _purrr_vulkan_allocation_t *allocation) {
+  assert(data && allocation);
+  if (!allocation->memory) return;
 
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)texture->renderer->data_ptr;
-  _purrr_sampler_data_t *sampler_data = (_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr;
-  assert(renderer_data && sampler_data);
+  if (!allocation->block) {
+    if (allocation->mapped) vkUnmapMemory(data->device, allocation->memory);
+    vkFreeMemory(data->device, allocation->memory, VK_NULL_HANDLE);
+    --data->allocator.allocation_count;
+    memset(allocation, 0, sizeof(*allocation));
+    return;
+  }
 
-  {
-    VkDescriptorSetAllocateInfo alloc_info = {
-      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-      .descriptorPool = renderer_data->descriptor_pool,
-      .descriptorSetCount = 1,
-      .pSetLayouts = &renderer_data->texture_descriptor_set_layout,
-    };
+  _purrr_vulkan_memory_block_t *block = allocation->block;
+  _purrr_vulkan_block_free(block, (uint32_t)(allocation->offset>>PURRR_VULKAN_MIN_CHUNK_SHIFT), allocation->order);
 
-    if (vkAllocateDescriptorSets(renderer_data->device, &alloc_info, &data->descriptor_set) != VK_SUCCESS) return false;
+  // Give empty blocks back to the driver, but keep the last one around so create/destroy loops don't thrash.
+  _purrr_vulkan_memory_pool_t *pool = block->pool;
+  if (block->used == 0 && pool->count > 1) {
+    for (size_t i = 0; i < pool->count; ++i) {
+      if (pool->items[i] != block) continue;
+      pool->items[i] = pool->items[--pool->count];
+      _purrr_vulkan_block_destroy(data, block);
+      break;
+    }
   }
 
-  {
-    VkDescriptorImageInfo texture_info = {
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-      .imageView = image_data->image_view,
-      .sampler = sampler_data->sampler,
-    };
+  memset(allocation, 0, sizeof(*allocation));
+}
 
-    VkWriteDescriptorSet descriptor_write = {
-      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      .dstSet = data->descriptor_set,
-      .dstBinding = 0,
-      .dstArrayElement = 0,
-      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-      .descriptorCount = 1,
-      .pImageInfo = &texture_info,
-    };
+// Host visible blocks are mapped once and stay mapped until they are destroyed.
+bool _purrr_vulkan_map(_purrr_renderer_data_t *data, _purrr_vulkan_allocation_t *allocation, void **out) {
+  assert(data && allocation && out);
+  if (!allocation->memory) return false;
+  if (!(data->allocator.memory_properties.memoryTypes[allocation->memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) return false;
+
+  void **mapped = (allocation->block?&allocation->block->mapped:&allocation->mapped);
+  if (!*mapped && vkMapMemory(data->device, allocation->memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) return false;
+
+  *out = (uint8_t*)*mapped + (allocation->block?allocation->offset:0);
+  return true;
+}
+
+bool _purrr_renderer_vulkan_create_buffer(_purrr_renderer_data_t *data, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred, VkBuffer *buffer, _purrr_vulkan_allocation_t *allocation) {
+  VkBufferCreateInfo buffer_info = {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    .size = size,
+    .usage = usage,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+  };
+
+  if (vkCreateBuffer(data->device, &buffer_info, VK_NULL_HANDLE, buffer) != VK_SUCCESS) return false;
+
+  VkMemoryRequirements memRequirements = {0};
+  vkGetBufferMemoryRequirements(data->device, *buffer, &memRequirements);
 
-    vkUpdateDescriptorSets(renderer_data->device, (uint32_t)1, &descriptor_write, 0, VK_NULL_HANDLE);
+  if (!_purrr_vulkan_allocate(data, memRequirements, properties, preferred, true, allocation)) {
+    vkDestroyBuffer(data->device, *buffer, VK_NULL_HANDLE);
+    *buffer = VK_NULL_HANDLE;
+    return false;
   }
 
-  texture->initialized = true;
-  texture->data_ptr = data;
+  vkBindBufferMemory(data->device, *buffer, allocation->memory, allocation->offset);
 
   return true;
-error:
-  free(data);
-  return false;
 }
 
-void _purrr_texture_vulkan_cleanup(_purrr_texture_t *texture) {
-  if (!texture || !texture->initialized) return;
-  assert(texture->renderer);
-  _purrr_texture_data_t *data = (_purrr_texture_data_t*)texture->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)texture->renderer->data_ptr;
-  assert(data && renderer_data);
-
+void _purrr_renderer_vulkan_destroy_buffer(_purrr_renderer_data_t *data, VkBuffer buffer, _purrr_vulkan_allocation_t *allocation) {
+  vkDestroyBuffer(data->device, buffer, VK_NULL_HANDLE);
+  _purrr_vulkan_free(data, allocation);
 }
 
-// pipeline descriptor
+// staging
 
-bool _purrr_pipeline_descriptor_vulkan_init(_purrr_pipeline_descriptor_t *pipeline_descriptor) {
-  if (!pipeline_descriptor || !pipeline_descriptor->renderer || !pipeline_descriptor->renderer->initialized) return false;
+static VkDeviceSize _purrr_vulkan_align_up(VkDeviceSize value, VkDeviceSize alignment) {
+  if (alignment <= 1) return value;
+  return ((value + alignment - 1) / alignment) * alignment;
+}
 
-  _purrr_pipeline_descriptor_data_t *data = (_purrr_pipeline_descriptor_data_t*)malloc(sizeof(*data));
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline_descriptor->renderer->data_ptr;
-  assert(data && renderer_data);
+static void _purrr_vulkan_staging_release(_purrr_renderer_data_t *data, _purrr_vulkan_staging_buffers_t *buffers) {
+  for (size_t i = 0; i < buffers->count; ++i)
+    _purrr_renderer_vulkan_destroy_buffer(data, buffers->items[i].buffer, &buffers->items[i].allocation);
+  buffers->count = 0;
+}
 
-  {
-    uint8_t resolve_multiplier = pipeline_descriptor->info.resolve_attachments?2:1;
-    uint32_t attachment_count = (pipeline_descriptor->info.color_attachment_count*resolve_multiplier)+(pipeline_descriptor->info.depth_attachment?1:0);
-    VkAttachmentDescription *attachments = (VkAttachmentDescription*)malloc(sizeof(*attachments) * attachment_count);
-    assert(attachments);
-    VkAttachmentReference *references = (VkAttachmentReference*)malloc(sizeof(*references) * pipeline_descriptor->info.color_attachment_count * resolve_multiplier);
-    assert(references);
+bool _purrr_vulkan_staging_init(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  memset(staging, 0, sizeof(*staging));
+  staging->size = PURRR_VULKAN_STAGING_SIZE;
 
-    bool depth = false;
-    VkAttachmentReference depth_reference = {0};
+  if (!_purrr_renderer_vulkan_create_buffer(data, staging->size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, &staging->buffer, &staging->allocation)) return false;
+  if (!_purrr_vulkan_map(data, &staging->allocation, (void**)&staging->mapped)) return false;
 
-    uint32_t i = 0;
-    for (; i < pipeline_descriptor->info.color_attachment_count; ++i) {
-      purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.color_attachments[i];
-      attachments[i] = (VkAttachmentDescription){
-        0,
-        vk_format(renderer_data, attachment_info.format),
-        (VkSampleCountFlagBits)1<<attachment_info.sample_count,
-        (attachment_info.load?VK_ATTACHMENT_LOAD_OP_LOAD:VK_ATTACHMENT_LOAD_OP_CLEAR),
-        (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
-        VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        (attachment_info.present_src?VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:((resolve_multiplier>1)?VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)),
-      };
+  VkCommandBuffer cmd_bufs[PURRR_VULKAN_STAGING_SUBMITS] = {0};
+  VkCommandBufferAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    .commandPool = data->command_pool,
+    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    .commandBufferCount = PURRR_VULKAN_STAGING_SUBMITS,
+  };
+  if (vkAllocateCommandBuffers(data->device, &alloc_info, cmd_bufs) != VK_SUCCESS) return false;
 
-      references[i] = (VkAttachmentReference){
-        i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-      };
-    }
+  VkFenceCreateInfo fence_info = {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+  };
 
-    if (pipeline_descriptor->info.resolve_attachments) {
-      for (uint32_t j = 0; j < pipeline_descriptor->info.color_attachment_count; ++j, ++i) {
-        purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.resolve_attachments[j];
-        attachments[i] = (VkAttachmentDescription){
-          0,
-          vk_format(renderer_data, attachment_info.format),
-          (VkSampleCountFlagBits)1<<attachment_info.sample_count,
-          (attachment_info.load?VK_ATTACHMENT_LOAD_OP_LOAD:VK_ATTACHMENT_LOAD_OP_CLEAR),
-          (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
-          VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-          VK_ATTACHMENT_STORE_OP_DONT_CARE,
-          VK_IMAGE_LAYOUT_UNDEFINED,
-          (attachment_info.present_src?VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
-        };
+  for (uint32_t i = 0; i < PURRR_VULKAN_STAGING_SUBMITS; ++i) {
+    staging->submits[i].cmd_buf = cmd_bufs[i];
+    if (vkCreateFence(data->device, &fence_info, VK_NULL_HANDLE, &staging->submits[i].fence) != VK_SUCCESS) return false;
+  }
 
-        references[i] = (VkAttachmentReference){
-          i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
-      }
-    }
+  return true;
+}
 
-    if (pipeline_descriptor->info.depth_attachment) {
-      depth_reference.attachment = pipeline_descriptor->info.color_attachment_count;
-      depth_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+// Retires every finished submission (or all of them if `wait` is set, oldest first).
+void _purrr_vulkan_staging_reclaim(_purrr_renderer_data_t *data, bool wait) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  while (staging->count > 0) {
+    _purrr_vulkan_staging_submit_t *submit = &staging->submits[staging->first];
+    if (wait) vkWaitForFences(data->device, 1, &submit->fence, VK_TRUE, UINT64_MAX);
+    else if (vkGetFenceStatus(data->device, submit->fence) != VK_SUCCESS) break;
+
+    vkResetFences(data->device, 1, &submit->fence);
+    _purrr_vulkan_staging_release(data, &submit->garbage);
+    staging->tail = submit->end;
+    staging->first = (staging->first+1)%PURRR_VULKAN_STAGING_SUBMITS;
+    --staging->count;
+  }
 
-      purrr_pipeline_descriptor_attachment_info_t attachment_info = *pipeline_descriptor->info.depth_attachment;
-      attachments[depth_reference.attachment] = (VkAttachmentDescription){
-        0,
-        vk_format(renderer_data, attachment_info.format),
-        (VkSampleCountFlagBits)1<<attachment_info.sample_count,
-        (attachment_info.load?VK_ATTACHMENT_LOAD_OP_LOAD:VK_ATTACHMENT_LOAD_OP_CLEAR),
-        (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
-        VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-      };
-      depth = true;
+  if (staging->count == 0 && staging->head == staging->tail) staging->head = staging->tail = 0;
+}
+
+static bool _purrr_vulkan_staging_fit(_purrr_vulkan_staging_t *staging, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *out_offset) {
+  VkDeviceSize offset = _purrr_vulkan_align_up(staging->head, alignment);
+  if (staging->head >= staging->tail) { // Free: [head, size) and [0, tail)
+    if (offset + size > staging->size) {
+      // Strictly less, so head never catches up with the tail (which would look like an empty ring).
+      if (size >= staging->tail) return false;
+      offset = 0;
     }
+  } else if (offset + size >= staging->tail) return false; // Free: [head, tail)
 
-    VkSubpassDescription subpass = {
-      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-      .colorAttachmentCount = pipeline_descriptor->info.color_attachment_count,
-      .pColorAttachments = references,
-      .pResolveAttachments = references+pipeline_descriptor->info.color_attachment_count,
-      .pDepthStencilAttachment = (depth?&depth_reference:NULL),
-    };
+  staging->head = offset + size;
+  *out_offset = offset;
+  return true;
+}
 
-    VkSubpassDependency dependency = {
-      .srcSubpass = VK_SUBPASS_EXTERNAL,
-      .dstSubpass = 0,
-      .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-      .srcAccessMask = 0,
-      .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-      .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-    };
+// Claims `size` bytes of staging memory for the next submission, uploads that don't fit
+// into the ring get their own buffer which is destroyed when that submission is done.
+bool _purrr_vulkan_staging_claim(_purrr_renderer_data_t *data, VkDeviceSize size, VkDeviceSize alignment, VkBuffer *buffer, VkDeviceSize *offset, void **ptr) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  assert(buffer && offset && ptr);
+
+  if (size < staging->size) {
+    _purrr_vulkan_staging_reclaim(data, false);
+    while (true) {
+      if (_purrr_vulkan_staging_fit(staging, size, alignment, offset)) {
+        *buffer = staging->buffer;
+        *ptr = staging->mapped + *offset;
+        return true;
+      }
+      if (staging->count == 0) break;
 
-    if (depth) {
-      dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-      dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-      dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      // Wait only for the oldest submission, not the whole queue.
+      _purrr_vulkan_staging_submit_t *oldest = &staging->submits[staging->first];
+      vkWaitForFences(data->device, 1, &oldest->fence, VK_TRUE, UINT64_MAX);
+      _purrr_vulkan_staging_reclaim(data, false);
     }
+  }
 
-    VkRenderPassCreateInfo create_info = {
-      .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-      .attachmentCount = attachment_count,
-      .pAttachments = attachments,
-      .subpassCount = 1,
-      .pSubpasses = &subpass,
-      .dependencyCount = 1,
-      .pDependencies = &dependency,
-    };
-
-    if (vkCreateRenderPass(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->render_pass) != VK_SUCCESS) goto error;
+  _purrr_vulkan_staging_buffers_t *garbage = &staging->garbage;
+  if (garbage->count >= garbage->capacity) {
+    size_t capacity = (garbage->capacity?garbage->capacity*2:4);
+    _purrr_vulkan_staging_buffer_t *items = (_purrr_vulkan_staging_buffer_t*)realloc(garbage->items, sizeof(*items)*capacity);
+    if (!items) return false;
+    garbage->items = items;
+    garbage->capacity = capacity;
   }
 
-  pipeline_descriptor->data_ptr = data;
-  pipeline_descriptor->initialized = true;
+  _purrr_vulkan_staging_buffer_t *temp = &garbage->items[garbage->count];
+  if (!_purrr_renderer_vulkan_create_buffer(data, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, &temp->buffer, &temp->allocation)) return false;
+  if (!_purrr_vulkan_map(data, &temp->allocation, ptr)) {
+    _purrr_renderer_vulkan_destroy_buffer(data, temp->buffer, &temp->allocation);
+    return false;
+  }
+  ++garbage->count;
 
+  *buffer = temp->buffer;
+  *offset = 0;
   return true;
-error:
-  free(data);
-  return false;
 }
 
-void _purrr_pipeline_descriptor_vulkan_cleanup(_purrr_pipeline_descriptor_t *pipeline_descriptor) {
-  _purrr_pipeline_descriptor_data_t *data = (_purrr_pipeline_descriptor_data_t*)pipeline_descriptor->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline_descriptor->renderer->data_ptr;
-  if (!data || !renderer_data) return;
-  if (pipeline_descriptor->initialized) {
-    vkDestroyRenderPass(renderer_data->device, data->render_pass, VK_NULL_HANDLE);
+VkCommandBuffer _purrr_vulkan_staging_begin(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  if (staging->count == PURRR_VULKAN_STAGING_SUBMITS) {
+    vkWaitForFences(data->device, 1, &staging->submits[staging->first].fence, VK_TRUE, UINT64_MAX);
+    _purrr_vulkan_staging_reclaim(data, false);
   }
-  free(data);
-  pipeline_descriptor->initialized = false;
-}
 
-// shader
+  VkCommandBuffer cmd_buf = staging->submits[(staging->first+staging->count)%PURRR_VULKAN_STAGING_SUBMITS].cmd_buf;
+  vkResetCommandBuffer(cmd_buf, 0);
 
-bool _purrr_shader_vulkan_init(_purrr_shader_t *shader) {
-  if (!shader || !shader->renderer || !shader->renderer->initialized) return false;
+  VkCommandBufferBeginInfo begin_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  if (vkBeginCommandBuffer(cmd_buf, &begin_info) != VK_SUCCESS) return VK_NULL_HANDLE;
 
-  _purrr_shader_data_t *data = (_purrr_shader_data_t*)malloc(sizeof(*data));
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)shader->renderer->data_ptr;
-  assert(data && renderer_data);
-  memset(data, 0, sizeof(*data));
+  return cmd_buf;
+}
 
-  if (shader->info.filename) {
-    if (shader->info.buffer) free(shader->info.buffer);
-    FILE *fd = fopen(shader->info.filename, "rb");
-    if (!fd) return VK_NULL_HANDLE;
-    fseek(fd, 0, SEEK_END);
-    shader->info.buffer_size = (size_t)ftell(fd);
-    fseek(fd, 0, SEEK_SET);
-    shader->info.buffer = malloc(shader->info.buffer_size);
-    assert(shader->info.buffer);
-    if ((shader->info.buffer_size % 4) != 0 || !shader->info.buffer ||
-        (fread(shader->info.buffer, shader->info.buffer_size, 1, fd) != 1)) {
-      fclose(fd);
-      free(shader->info.buffer);
-      return false;
-    }
-    fclose(fd);
-  }
+// Submits everything recorded since _purrr_vulkan_staging_begin, nothing waits unless `wait` is set.
+bool _purrr_vulkan_staging_submit(_purrr_renderer_data_t *data, VkCommandBuffer cmd_buf, bool wait) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  _purrr_vulkan_staging_submit_t *submit = &staging->submits[(staging->first+staging->count)%PURRR_VULKAN_STAGING_SUBMITS];
+  assert(submit->cmd_buf == cmd_buf);
 
-  VkShaderModuleCreateInfo create_info = {
-    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-    .codeSize = shader->info.buffer_size,
-    .pCode = (const uint32_t*)shader->info.buffer,
-  };
+  if (vkEndCommandBuffer(cmd_buf) != VK_SUCCESS) return false;
 
-  VkResult result = vkCreateShaderModule(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->shader_module);
-  if (result != VK_SUCCESS) {
-    assert(false);
-  }
+  VkSubmitInfo submit_info = {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &cmd_buf,
+  };
 
-  if (shader->info.filename) free(shader->info.buffer);
+  if (vkQueueSubmit(data->graphics_queue, 1, &submit_info, submit->fence) != VK_SUCCESS) return false;
 
-  shader->type = shader->info.type;
+  submit->end = staging->head;
+  _purrr_vulkan_staging_buffers_t garbage = submit->garbage;
+  submit->garbage = staging->garbage;
+  staging->garbage = garbage;
+  ++staging->count;
 
-  shader->initialized = true;
-  shader->data_ptr = data;
+  if (wait) _purrr_vulkan_staging_reclaim(data, true);
 
   return true;
 }
 
-void _purrr_shader_vulkan_cleanup(_purrr_shader_t *shader) {
-  _purrr_shader_data_t *data = (_purrr_shader_data_t*)shader->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)shader->renderer->data_ptr;
-  if (!data || !renderer_data) return;
-  if (shader->initialized) vkDestroyShaderModule(renderer_data->device, data->shader_module, VK_NULL_HANDLE);
-  free(data);
-  shader->initialized = false;
+void _purrr_vulkan_staging_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_staging_t *staging = &data->staging;
+  _purrr_vulkan_staging_reclaim(data, true);
+  _purrr_vulkan_staging_release(data, &staging->garbage);
+  free(staging->garbage.items);
+
+  for (uint32_t i = 0; i < PURRR_VULKAN_STAGING_SUBMITS; ++i) {
+    free(staging->submits[i].garbage.items);
+    if (staging->submits[i].fence) vkDestroyFence(data->device, staging->submits[i].fence, VK_NULL_HANDLE);
+  }
+
+  if (staging->buffer) _purrr_renderer_vulkan_destroy_buffer(data, staging->buffer, &staging->allocation);
+  memset(staging, 0, sizeof(*staging));
 }
 
-// pipeline
+// descriptors
+
+static bool _purrr_vulkan_descriptor_pool_create(_purrr_renderer_data_t *data, VkDescriptorPool *pool) {
+  VkDescriptorPoolSize pool_sizes[] = {
+    { VK_DESCRIPTOR_TYPE_SAMPLER,                PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+    { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,       PURRR_VULKAN_DESCRIPTOR_POOL_SETS },
+  };
 
-bool _purrr_pipeline_vulkan_init(_purrr_pipeline_t *pipeline) {
-  if (!pipeline || !pipeline->renderer || !pipeline->renderer->initialized) return false;
+  VkDescriptorPoolCreateInfo pool_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+    .poolSizeCount = sizeof(pool_sizes)/sizeof(pool_sizes[0]),
+    .pPoolSizes = pool_sizes,
+    .maxSets = PURRR_VULKAN_DESCRIPTOR_POOL_SETS,
+  };
 
-  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)malloc(sizeof(*data));
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
-  _purrr_pipeline_descriptor_data_t *pipeline_descriptor_data = (_purrr_pipeline_descriptor_data_t*)((_purrr_pipeline_descriptor_t*)pipeline->info.pipeline_descriptor)->data_ptr;
-  assert(data && renderer_data && pipeline_descriptor_data);
-  memset(data, 0, sizeof(*data));
+  return vkCreateDescriptorPool(data->device, &pool_info, VK_NULL_HANDLE, pool) == VK_SUCCESS;
+}
 
-  VkPipelineShaderStageCreateInfo *stage_infos = (VkPipelineShaderStageCreateInfo*)malloc(sizeof(*stage_infos)*pipeline->info.shader_count);
-  assert(stage_infos);
-  for (uint32_t i = 0; i < pipeline->info.shader_count; ++i) {
-    _purrr_shader_t *shader = (_purrr_shader_t*)pipeline->info.shaders[i];
-    assert(shader->initialized);
+// Tries the pool that had room last time first, then all the others, a new pool is only created once every one is full.
+static bool _purrr_vulkan_descriptor_allocate(_purrr_renderer_data_t *data, VkDescriptorSetLayout layout, VkDescriptorSet *set, VkDescriptorPool *pool) {
+  _purrr_vulkan_descriptors_t *descriptors = &data->descriptors;
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorSetCount = 1,
+    .pSetLayouts = &layout,
+  };
 
-    stage_infos[i] = (VkPipelineShaderStageCreateInfo){
-      .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-      .stage = vk_shader_stage(shader->type),
-      .module = ((_purrr_shader_data_t*)shader->data_ptr)->shader_module,
-      .pName = "main",
-    };
+  for (size_t i = 0; i < descriptors->pool_count; ++i) {
+    size_t index = (descriptors->current+i)%descriptors->pool_count;
+    alloc_info.descriptorPool = descriptors->pools[index];
+    VkResult result = vkAllocateDescriptorSets(data->device, &alloc_info, set);
+    if (result == VK_SUCCESS) {
+      descriptors->current = index;
+      *pool = alloc_info.descriptorPool;
+      return true;
+    }
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) return false;
   }
 
-  VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+  if (descriptors->pool_count >= descriptors->pool_capacity) {
+    size_t capacity = (descriptors->pool_capacity?descriptors->pool_capacity*2:4);
+    VkDescriptorPool *pools = (VkDescriptorPool*)realloc(descriptors->pools, sizeof(*pools)*capacity);
+    if (!pools) return false;
+    descriptors->pools = pools;
+    descriptors->pool_capacity = capacity;
+  }
 
-  VkPipelineDynamicStateCreateInfo dynamic_state = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-    .dynamicStateCount = 2,
-    .pDynamicStates = dynamic_states,
-  };
+  if (!_purrr_vulkan_descriptor_pool_create(data, &alloc_info.descriptorPool)) return false;
+  descriptors->pools[descriptors->pool_count] = alloc_info.descriptorPool;
+  descriptors->current = descriptors->pool_count++;
 
-  uint32_t vertex_attrib_count = pipeline->info.mesh_info.vertex_info_count;
-  VkPipelineVertexInputStateCreateInfo vertex_input_info = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-    .vertexBindingDescriptionCount = 0,
-    .pVertexBindingDescriptions = VK_NULL_HANDLE,
-    .vertexAttributeDescriptionCount = vertex_attrib_count,
-    .pVertexAttributeDescriptions = VK_NULL_HANDLE,
-  };
+  if (vkAllocateDescriptorSets(data->device, &alloc_info, set) != VK_SUCCESS) return false;
+  *pool = alloc_info.descriptorPool;
+  return true;
+}
 
-  VkVertexInputAttributeDescription *vertex_attributes = (vertex_attrib_count>0?(VkVertexInputAttributeDescription*)malloc(sizeof(*vertex_attributes)*vertex_attrib_count):VK_NULL_HANDLE);
-  assert(vertex_attributes);
-  uint32_t vertex_size = 0;
-  for (uint32_t i = 0; i < vertex_attrib_count; ++i) {
-    purrr_vertex_info_t info = pipeline->info.mesh_info.vertex_infos[i];
-    vertex_size += info.size;
-    vertex_attributes[i].location = i;
-    vertex_attributes[i].binding = 0;
-    vertex_attributes[i].format = vk_format(renderer_data, info.format);
-    vertex_attributes[i].offset = info.offset;
+static uint64_t _purrr_vulkan_descriptor_hash(const _purrr_vulkan_descriptor_key_t *key) {
+  return _purrr_vulkan_hash(key, sizeof(*key));
+}
+
+static bool _purrr_vulkan_descriptor_grow(_purrr_vulkan_descriptors_t *descriptors) {
+  size_t capacity = (descriptors->capacity?descriptors->capacity*2:64);
+  _purrr_vulkan_descriptor_entry_t *entries = (_purrr_vulkan_descriptor_entry_t*)calloc(capacity, sizeof(*entries));
+  if (!entries) return false;
+
+  for (size_t i = 0; i < descriptors->capacity; ++i) {
+    _purrr_vulkan_descriptor_entry_t *entry = &descriptors->entries[i];
+    if (!entry->set) continue;
+    size_t j = entry->hash & (capacity-1);
+    while (entries[j].set) j = (j+1) & (capacity-1);
+    entries[j] = *entry;
   }
 
-  VkVertexInputBindingDescription binding_description = {
-    .binding = 0,
-    .stride = vertex_size,
-    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-  };
+  free(descriptors->entries);
+  descriptors->entries = entries;
+  descriptors->capacity = capacity;
+  return true;
+}
 
-  if (vertex_attrib_count > 0) {
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
-    vertex_input_info.pVertexAttributeDescriptions = vertex_attributes;
-    assert(vertex_input_info.pVertexAttributeDescriptions);
+// Returns the cached set for a single binding of `type` at binding 0 of `layout`, or allocates and writes a new one.
+static bool _purrr_vulkan_descriptor_acquire(_purrr_renderer_data_t *data, VkDescriptorSetLayout layout, VkDescriptorType type, const VkDescriptorImageInfo *image_info, const VkDescriptorBufferInfo *buffer_info, _purrr_vulkan_descriptor_set_t *set) {
+  _purrr_vulkan_descriptors_t *descriptors = &data->descriptors;
+
+  _purrr_vulkan_descriptor_key_t key;
+  memset(&key, 0, sizeof(key)); // Padding is hashed too
+  key.layout = layout;
+  key.type = type;
+  if (image_info) {
+    key.image_view = image_info->imageView;
+    key.sampler = image_info->sampler;
+    key.image_layout = image_info->imageLayout;
+  }
+  if (buffer_info) {
+    key.buffer = buffer_info->buffer;
+    key.offset = buffer_info->offset;
+    key.range = buffer_info->range;
+  }
+  uint64_t hash = _purrr_vulkan_descriptor_hash(&key);
+
+  for (size_t i = hash & (descriptors->capacity-1); descriptors->capacity && descriptors->entries[i].set; i = (i+1) & (descriptors->capacity-1)) {
+    _purrr_vulkan_descriptor_entry_t *entry = &descriptors->entries[i];
+    if (entry->hash != hash || memcmp(&entry->key, &key, sizeof(key)) != 0) continue;
+    ++entry->references;
+    *set = (_purrr_vulkan_descriptor_set_t){ entry->set, hash };
+    return true;
   }
 
-  VkPipelineInputAssemblyStateCreateInfo input_assembly = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-    .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-    .primitiveRestartEnable = VK_FALSE,
-  };
+  if ((descriptors->count+1)*4 > descriptors->capacity*3 && !_purrr_vulkan_descriptor_grow(descriptors)) return false;
 
-  VkPipelineViewportStateCreateInfo viewport_state = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-    .viewportCount = 1,
-    .scissorCount = 1,
+  _purrr_vulkan_descriptor_entry_t entry = {
+    .key = key,
+    .hash = hash,
+    .references = 1,
   };
+  if (!_purrr_vulkan_descriptor_allocate(data, layout, &entry.set, &entry.pool)) return false;
 
-  VkPipelineRasterizationStateCreateInfo rasterizer = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-    .depthClampEnable = VK_FALSE,
-    .rasterizerDiscardEnable = VK_FALSE,
-    .polygonMode = VK_POLYGON_MODE_FILL,
-    .lineWidth = 1.0f,
-    .cullMode = VK_CULL_MODE_BACK_BIT,
-    .frontFace = VK_FRONT_FACE_CLOCKWISE,
-    .depthBiasEnable = VK_FALSE,
+  VkWriteDescriptorSet descriptor_write = {
+    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet = entry.set,
+    .dstBinding = 0,
+    .dstArrayElement = 0,
+    .descriptorType = type,
+    .descriptorCount = 1,
+    .pImageInfo = image_info,
+    .pBufferInfo = buffer_info,
   };
 
-  VkPipelineMultisampleStateCreateInfo multisampling = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-    .sampleShadingEnable = VK_FALSE,
-    .rasterizationSamples = (VkSampleCountFlagBits)1<<pipeline->info.sample_count,
-  };
+  vkUpdateDescriptorSets(data->device, 1, &descriptor_write, 0, VK_NULL_HANDLE);
 
-  VkPipelineColorBlendAttachmentState color_blend_attachment = {
-    .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    .blendEnable = VK_TRUE,
-    .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-    .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-    .colorBlendOp = VK_BLEND_OP_ADD,
-    .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-    .alphaBlendOp = VK_BLEND_OP_ADD,
-  };
+  size_t i = hash & (descriptors->capacity-1);
+  while (descriptors->entries[i].set) i = (i+1) & (descriptors->capacity-1);
+  descriptors->entries[i] = entry;
+  ++descriptors->count;
 
-  VkPipelineColorBlendStateCreateInfo color_blending = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-    .logicOpEnable = VK_FALSE,
-    .attachmentCount = 1,
-    .pAttachments = &color_blend_attachment,
-  };
+  *set = (_purrr_vulkan_descriptor_set_t){ entry.set, hash };
+  return true;
+}
 
-  VkPipelineDepthStencilStateCreateInfo depth_stencil = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-    .depthTestEnable = VK_TRUE,
-    .depthWriteEnable = VK_TRUE,
-    .depthCompareOp = VK_COMPARE_OP_LESS,
-    .depthBoundsTestEnable = VK_FALSE,
-    .minDepthBounds = 0.0f,
-    .maxDepthBounds = 1.0f,
-    .stencilTestEnable = VK_FALSE,
-  };
+// Hands `set` back to `pool` two frames from now.
+static void _purrr_vulkan_descriptor_retire(_purrr_renderer_data_t *data, VkDescriptorSet set, VkDescriptorPool pool) {
+  _purrr_vulkan_descriptor_garbages_t *garbage = &data->descriptors.garbage;
+  if (garbage->count >= garbage->capacity) {
+    size_t capacity = (garbage->capacity?garbage->capacity*2:4);
+    _purrr_vulkan_descriptor_garbage_t *items = (_purrr_vulkan_descriptor_garbage_t*)realloc(garbage->items, sizeof(*items)*capacity);
+    assert(items);
+    garbage->items = items;
+    garbage->capacity = capacity;
+  }
+  garbage->items[garbage->count++] = (_purrr_vulkan_descriptor_garbage_t){ set, pool, data->frame_counter };
+}
 
-  VkDescriptorSetLayout *layouts = (VkDescriptorSetLayout*)malloc(sizeof(*layouts)*pipeline->info.descriptor_slot_count);
-  assert(layouts);
-  for (uint32_t i = 0; i < pipeline->info.descriptor_slot_count; ++i) {
-    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
-    switch (pipeline->info.descriptor_slots[i]) {
-    case PURRR_DESCRIPTOR_TYPE_TEXTURE:
-      layout = renderer_data->texture_descriptor_set_layout;
-      break;
-    case PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-      layout = renderer_data->uniform_descriptor_set_layout;
-      break;
-    case PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-      layout = renderer_data->storage_descriptor_set_layout;
-      break;
-    case COUNT_PURRR_DESCRIPTOR_TYPES: {
-      assert(0 && "Unreachable");
-      return false;
-    }
+void _purrr_vulkan_descriptor_release(_purrr_renderer_data_t *data, _purrr_vulkan_descriptor_set_t *set) {
+  _purrr_vulkan_descriptors_t *descriptors = &data->descriptors;
+  if (!set->set || !descriptors->capacity) return;
+
+  size_t mask = descriptors->capacity-1;
+  size_t i = set->hash & mask;
+  while (descriptors->entries[i].set && descriptors->entries[i].set != set->set) i = (i+1) & mask;
+  _purrr_vulkan_descriptor_entry_t *entry = &descriptors->entries[i];
+  memset(set, 0, sizeof(*set));
+  if (!entry->set || --entry->references > 0) return;
+
+  _purrr_vulkan_descriptor_retire(data, entry->set, entry->pool);
+
+  // Backward shift deletion, every entry after the hole that may live there moves up.
+  size_t hole = i;
+  for (size_t j = (hole+1) & mask; descriptors->entries[j].set; j = (j+1) & mask) {
+    size_t home = descriptors->entries[j].hash & mask;
+    if (((j-home) & mask) < ((j-hole) & mask)) continue;
+    descriptors->entries[hole] = descriptors->entries[j];
+    hole = j;
+  }
+  memset(&descriptors->entries[hole], 0, sizeof(descriptors->entries[hole]));
+  --descriptors->count;
+}
+
+// Expects the fence of the frame being begun to be waited on.
+void _purrr_vulkan_descriptor_collect(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_descriptor_garbages_t *garbage = &data->descriptors.garbage;
+  for (size_t i = 0; i < garbage->count;) {
+    _purrr_vulkan_descriptor_garbage_t *item = &garbage->items[i];
+    if (item->frame+2 > data->frame_counter) {
+      ++i;
+      continue;
     }
-    layouts[i] = layout;
+    vkFreeDescriptorSets(data->device, item->pool, 1, &item->set);
+    *item = garbage->items[--garbage->count];
   }
+}
 
-  VkPushConstantRange *pc_ranges = (VkPushConstantRange*)malloc(sizeof(*pc_ranges)*pipeline->info.push_constant_count);
-  assert(pc_ranges);
-  for (size_t i = 0; i < pipeline->info.push_constant_count; ++i) {
-    pc_ranges[i] = (VkPushConstantRange){
-      .stageFlags = VK_SHADER_STAGE_ALL,
-      .offset = pipeline->info.push_constants[i].offset,
-      .size = pipeline->info.push_constants[i].size,
-    };
+void _purrr_vulkan_descriptors_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_descriptors_t *descriptors = &data->descriptors;
+  for (size_t i = 0; i < descriptors->pool_count; ++i) vkDestroyDescriptorPool(data->device, descriptors->pools[i], VK_NULL_HANDLE);
+  free(descriptors->pools);
+  free(descriptors->entries);
+  free(descriptors->garbage.items);
+  memset(descriptors, 0, sizeof(*descriptors));
+}
+
+// Returns the shared layout for `bindings`, it (and its update template) is created the first time it's asked for.
+static const _purrr_vulkan_set_layout_t *_purrr_vulkan_set_layout_get(_purrr_renderer_data_t *data, const purrr_descriptor_type_t *bindings, uint32_t binding_count, bool push) {
+  _purrr_vulkan_set_layouts_t *layouts = &data->set_layouts;
+  for (size_t i = 0; i < layouts->count; ++i) {
+    _purrr_vulkan_set_layout_t *layout = layouts->items[i];
+    if (layout->push == push && layout->binding_count == binding_count && memcmp(layout->bindings, bindings, sizeof(*bindings)*binding_count) == 0) return layout;
   }
 
-  VkPipelineLayoutCreateInfo pipeline_layout_info = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-    .pSetLayouts = layouts,
-    .setLayoutCount = pipeline->info.descriptor_slot_count,
-    .pPushConstantRanges = pc_ranges,
-    .pushConstantRangeCount = pipeline->info.push_constant_count,
-  };
+  if (!binding_count || (push && !data->cmd_push_descriptor_set)) return NULL;
+  for (uint32_t i = 0; i < binding_count; ++i)
+    if (bindings[i] != PURRR_DESCRIPTOR_TYPE_TEXTURE && bindings[i] != PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER && bindings[i] != PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER) return NULL;
 
-  if (vkCreatePipelineLayout(renderer_data->device, &pipeline_layout_info, VK_NULL_HANDLE, &data->pipeline_layout) != VK_SUCCESS) return false;
+  if (layouts->count >= layouts->capacity) {
+    size_t capacity = (layouts->capacity?layouts->capacity*2:4);
+    _purrr_vulkan_set_layout_t **items = (_purrr_vulkan_set_layout_t**)realloc(layouts->items, sizeof(*items)*capacity);
+    if (!items) return NULL;
+    layouts->items = items;
+    layouts->capacity = capacity;
+  }
 
-  free(pc_ranges);
-  free(layouts);
+  _purrr_vulkan_set_layout_t *layout = (_purrr_vulkan_set_layout_t*)malloc(sizeof(*layout));
+  assert(layout);
+  memset(layout, 0, sizeof(*layout));
+  layout->bindings = (purrr_descriptor_type_t*)malloc(sizeof(*layout->bindings)*binding_count);
+  assert(layout->bindings);
+  memcpy(layout->bindings, bindings, sizeof(*bindings)*binding_count);
+  layout->binding_count = binding_count;
+  layout->push = push;
+
+  VkDescriptorSetLayoutBinding *layout_bindings = (VkDescriptorSetLayoutBinding*)malloc(sizeof(*layout_bindings)*binding_count);
+  assert(layout_bindings);
+  VkDescriptorUpdateTemplateEntry *entries = (VkDescriptorUpdateTemplateEntry*)malloc(sizeof(*entries)*binding_count);
+  assert(entries);
+  for (uint32_t i = 0; i < binding_count; ++i) {
+    VkDescriptorType type = vk_set_descriptor_type(bindings[i]);
+    layout_bindings[i] = (VkDescriptorSetLayoutBinding){
+      .binding = i,
+      .descriptorType = type,
+      .descriptorCount = 1,
+      .stageFlags = VK_SHADER_STAGE_ALL,
+      .pImmutableSamplers = VK_NULL_HANDLE,
+    };
+    entries[i] = (VkDescriptorUpdateTemplateEntry){
+      .dstBinding = i,
+      .dstArrayElement = 0,
+      .descriptorCount = 1,
+      .descriptorType = type,
+      .offset = sizeof(_purrr_vulkan_descriptor_info_t)*i,
+      .stride = sizeof(_purrr_vulkan_descriptor_info_t),
+    };
+  }
 
-  VkGraphicsPipelineCreateInfo pipeline_info = {
-    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-    .stageCount = pipeline->info.shader_count,
-    .pStages = stage_infos,
-    .pVertexInputState = &vertex_input_info,
-    .pInputAssemblyState = &input_assembly,
-    .pViewportState = &viewport_state,
-    .pRasterizationState = &rasterizer,
-    .pMultisampleState = &multisampling,
-    .pColorBlendState = &color_blending,
-    .pDynamicState = &dynamic_state,
-    .layout = data->pipeline_layout,
-    .renderPass = pipeline_descriptor_data->render_pass,
-    .subpass = 0,
+  VkDescriptorSetLayoutCreateInfo layout_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .flags = (push?VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR:0),
+    .bindingCount = binding_count,
+    .pBindings = layout_bindings,
   };
-  if (((_purrr_pipeline_descriptor_t*)pipeline->info.pipeline_descriptor)->info.depth_attachment) pipeline_info.pDepthStencilState = &depth_stencil;
 
-  if (vkCreateGraphicsPipelines(renderer_data->device, VK_NULL_HANDLE, 1, &pipeline_info, VK_NULL_HANDLE, &data->pipeline) != VK_SUCCESS) return false;
+  bool created = (vkCreateDescriptorSetLayout(data->device, &layout_info, VK_NULL_HANDLE, &layout->layout) == VK_SUCCESS);
+  if (created && !push && data->create_update_template) {
+    VkDescriptorUpdateTemplateCreateInfo template_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .descriptorUpdateEntryCount = binding_count,
+      .pDescriptorUpdateEntries = entries,
+      .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = layout->layout,
+    };
 
-  free(stage_infos);
+    created = (data->create_update_template(data->device, &template_info, VK_NULL_HANDLE, &layout->update_template) == VK_SUCCESS);
+  }
+  free(entries);
+  free(layout_bindings);
 
-  pipeline->data_ptr = data;
-  pipeline->initialized = true;
+  if (!created) {
+    if (layout->layout) vkDestroyDescriptorSetLayout(data->device, layout->layout, VK_NULL_HANDLE);
+    free(layout->bindings);
+    free(layout);
+    return NULL;
+  }
 
-  return true;
+  layouts->items[layouts->count++] = layout;
+  return layout;
 }
 
-void _purrr_pipeline_vulkan_cleanup(_purrr_pipeline_t *pipeline) {
-  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)pipeline->data_ptr;
+// Writes `infos` (one per binding) into `set`, without an update template every binding gets a write of its own.
+static void _purrr_vulkan_set_layout_update(_purrr_renderer_data_t *data, const _purrr_vulkan_set_layout_t *layout, VkDescriptorSet set, const _purrr_vulkan_descriptor_info_t *infos) {
+  if (layout->update_template) {
+    data->update_with_template(data->device, set, layout->update_template, infos);
+    return;
+  }
+
+  VkWriteDescriptorSet *descriptor_writes = (VkWriteDescriptorSet*)malloc(sizeof(*descriptor_writes)*layout->binding_count);
+  assert(descriptor_writes);
+  for (uint32_t i = 0; i < layout->binding_count; ++i) {
+    bool image = (layout->bindings[i] == PURRR_DESCRIPTOR_TYPE_TEXTURE);
+    descriptor_writes[i] = (VkWriteDescriptorSet){
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = set,
+      .dstBinding = i,
+      .dstArrayElement = 0,
+      .descriptorType = vk_set_descriptor_type(layout->bindings[i]),
+      .descriptorCount = 1,
+      .pImageInfo = (image?&infos[i].image:NULL),
+      .pBufferInfo = (image?NULL:&infos[i].buffer),
+    };
+  }
+
+  vkUpdateDescriptorSets(data->device, layout->binding_count, descriptor_writes, 0, VK_NULL_HANDLE);
+  free(descriptor_writes);
+}
+
+void _purrr_vulkan_set_layouts_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_set_layouts_t *layouts = &data->set_layouts;
+  for (size_t i = 0; i < layouts->count; ++i) {
+    _purrr_vulkan_set_layout_t *layout = layouts->items[i];
+    if (layout->update_template) data->destroy_update_template(data->device, layout->update_template, VK_NULL_HANDLE);
+    vkDestroyDescriptorSetLayout(data->device, layout->layout, VK_NULL_HANDLE);
+    free(layout->bindings);
+    free(layout);
+  }
+  free(layouts->items);
+  memset(layouts, 0, sizeof(*layouts));
+}
+
+// bindless
+
+bool _purrr_vulkan_bindless_init(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_bindless_t *bindless = &data->bindless;
+  if (!bindless->count) return true;
+
+  VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+    .bindingCount = 1,
+    .pBindingFlags = &binding_flags,
+  };
+
+  VkDescriptorSetLayoutBinding binding = {
+    .binding = 0,
+    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = bindless->count,
+    .stageFlags = VK_SHADER_STAGE_ALL,
+    .pImmutableSamplers = VK_NULL_HANDLE,
+  };
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = &binding_flags_info,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+    .bindingCount = 1,
+    .pBindings = &binding,
+  };
+
+  if (vkCreateDescriptorSetLayout(data->device, &layout_info, VK_NULL_HANDLE, &bindless->layout) != VK_SUCCESS) return false;
+
+  VkDescriptorPoolSize pool_size = {
+    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = bindless->count,
+  };
+
+  VkDescriptorPoolCreateInfo pool_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+    .maxSets = 1,
+    .poolSizeCount = 1,
+    .pPoolSizes = &pool_size,
+  };
+
+  if (vkCreateDescriptorPool(data->device, &pool_info, VK_NULL_HANDLE, &bindless->pool) != VK_SUCCESS) return false;
+
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorPool = bindless->pool,
+    .descriptorSetCount = 1,
+    .pSetLayouts = &bindless->layout,
+  };
+
+  return vkAllocateDescriptorSets(data->device, &alloc_info, &bindless->set) == VK_SUCCESS;
+}
+
+void _purrr_vulkan_bindless_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_bindless_t *bindless = &data->bindless;
+  if (bindless->pool) vkDestroyDescriptorPool(data->device, bindless->pool, VK_NULL_HANDLE);
+  if (bindless->layout) vkDestroyDescriptorSetLayout(data->device, bindless->layout, VK_NULL_HANDLE);
+  free(bindless->released.items);
+  memset(bindless, 0, sizeof(*bindless));
+}
+
+// Takes the oldest released slot once no frame in flight can still read it, otherwise one that was never used.
+// Returns PURRR_NO_TEXTURE_INDEX if the array is full.
+static uint32_t _purrr_vulkan_bindless_acquire(_purrr_renderer_data_t *data, const VkDescriptorImageInfo *image_info) {
+  _purrr_vulkan_bindless_t *bindless = &data->bindless;
+  _purrr_vulkan_bindless_slots_t *released = &bindless->released;
+
+  uint32_t index = PURRR_NO_TEXTURE_INDEX;
+  if (released->count && released->items[0].frame+2 <= data->frame_counter) {
+    index = released->items[0].index;
+    memmove(released->items, released->items+1, sizeof(*released->items)*--released->count);
+  } else if (bindless->used < bindless->count) index = bindless->used++;
+  else return PURRR_NO_TEXTURE_INDEX;
+
+  VkWriteDescriptorSet descriptor_write = {
+    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+    .dstSet = bindless->set,
+    .dstBinding = 0,
+    .dstArrayElement = index,
+    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    .descriptorCount = 1,
+    .pImageInfo = image_info,
+  };
+
+  vkUpdateDescriptorSets(data->device, 1, &descriptor_write, 0, VK_NULL_HANDLE);
+  return index;
+}
+
+static void _purrr_vulkan_bindless_release(_purrr_renderer_data_t *data, uint32_t index) {
+  _purrr_vulkan_bindless_slots_t *released = &data->bindless.released;
+  if (released->count >= released->capacity) {
+    size_t capacity = (released->capacity?released->capacity*2:4);
+    _purrr_vulkan_bindless_slot_t *items = (_purrr_vulkan_bindless_slot_t*)realloc(released->items, sizeof(*items)*capacity);
+    assert(items);
+    released->items = items;
+    released->capacity = capacity;
+  }
+  released->items[released->count++] = (_purrr_vulkan_bindless_slot_t){ index, data->frame_counter };
+}
+
+// transient
+
+static VkDeviceSize _purrr_vulkan_gcd(VkDeviceSize a, VkDeviceSize b) {
+  while (b) {
+    VkDeviceSize t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+bool _purrr_vulkan_transient_init(_purrr_renderer_data_t *data, VkDeviceSize size) {
+  VkPhysicalDeviceProperties properties = {0};
+  vkGetPhysicalDeviceProperties(data->gpu, &properties);
+
+  data->transient_range = min(PURRR_VULKAN_TRANSIENT_RANGE, min((VkDeviceSize)properties.limits.maxUniformBufferRange, (VkDeviceSize)properties.limits.maxStorageBufferRange));
+  VkDeviceSize uniform_alignment = max(properties.limits.minUniformBufferOffsetAlignment, 1);
+  VkDeviceSize storage_alignment = max(properties.limits.minStorageBufferOffsetAlignment, 1);
+  data->uniform_offset_alignment = uniform_alignment;
+  data->storage_offset_alignment = storage_alignment;
+  data->uniform_max_range = properties.limits.maxUniformBufferRange;
+  data->storage_max_range = properties.limits.maxStorageBufferRange;
+  data->transient_alignment = uniform_alignment / _purrr_vulkan_gcd(uniform_alignment, storage_alignment) * storage_alignment;
+
+  VkDescriptorSetLayout layouts[] = { data->uniform_descriptor_set_layout, data->storage_descriptor_set_layout };
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    _purrr_vulkan_transient_t *transient = &data->transients[i];
+    memset(transient, 0, sizeof(*transient));
+    transient->size = size;
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (!_purrr_renderer_vulkan_create_buffer(data, size + data->transient_range, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &transient->buffer, &transient->allocation)) return false;
+    if (!_purrr_vulkan_map(data, &transient->allocation, (void**)&transient->mapped)) return false;
+
+    // Never released, they go away with the pools.
+    VkDescriptorPool pool;
+    if (!_purrr_vulkan_descriptor_allocate(data, layouts[0], &transient->uniform_set, &pool) ||
+        !_purrr_vulkan_descriptor_allocate(data, layouts[1], &transient->storage_set, &pool)) return false;
+
+    VkDescriptorBufferInfo buffer_info = {
+      .buffer = transient->buffer,
+      .offset = 0,
+      .range = data->transient_range,
+    };
+
+    VkWriteDescriptorSet writes[2] = {
+      (VkWriteDescriptorSet){
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = transient->uniform_set,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pBufferInfo = &buffer_info,
+      },
+      (VkWriteDescriptorSet){
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = transient->storage_set,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        .pBufferInfo = &buffer_info,
+      },
+    };
+    vkUpdateDescriptorSets(data->device, 2, writes, 0, VK_NULL_HANDLE);
+  }
+
+  return true;
+}
+
+// Expects the fence of `frame_index` to be waited on.
+static void _purrr_vulkan_transient_reset(_purrr_renderer_data_t *data, uint32_t frame_index) {
+  _purrr_vulkan_transient_t *transient = &data->transients[frame_index];
+  transient->head = 0;
+  for (size_t i = 0; i < transient->descriptor_pool_count; ++i) vkResetDescriptorPool(data->device, transient->descriptor_pools[i], 0);
+  transient->descriptor_pool_current = 0;
+}
+
+// The set is only valid until the end of the frame being recorded.
+static bool _purrr_vulkan_transient_allocate_set(_purrr_renderer_data_t *data, VkDescriptorSetLayout layout, VkDescriptorSet *set) {
+  _purrr_vulkan_transient_t *transient = &data->transients[data->frame_index];
+  VkDescriptorSetAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    .descriptorSetCount = 1,
+    .pSetLayouts = &layout,
+  };
+
+  for (; transient->descriptor_pool_current < transient->descriptor_pool_count; ++transient->descriptor_pool_current) {
+    alloc_info.descriptorPool = transient->descriptor_pools[transient->descriptor_pool_current];
+    VkResult result = vkAllocateDescriptorSets(data->device, &alloc_info, set);
+    if (result == VK_SUCCESS) return true;
+    if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) return false;
+  }
+
+  if (transient->descriptor_pool_count >= transient->descriptor_pool_capacity) {
+    size_t capacity = (transient->descriptor_pool_capacity?transient->descriptor_pool_capacity*2:4);
+    VkDescriptorPool *pools = (VkDescriptorPool*)realloc(transient->descriptor_pools, sizeof(*pools)*capacity);
+    if (!pools) return false;
+    transient->descriptor_pools = pools;
+    transient->descriptor_pool_capacity = capacity;
+  }
+
+  if (!_purrr_vulkan_descriptor_pool_create(data, &alloc_info.descriptorPool)) return false;
+  transient->descriptor_pools[transient->descriptor_pool_count] = alloc_info.descriptorPool;
+  transient->descriptor_pool_current = transient->descriptor_pool_count++;
+
+  return vkAllocateDescriptorSets(data->device, &alloc_info, set) == VK_SUCCESS;
+}
+
+void _purrr_vulkan_transient_cleanup(_purrr_renderer_data_t *data) {
+  for (uint32_t i = 0; i < 2; ++i) {
+    _purrr_vulkan_transient_t *transient = &data->transients[i];
+    if (transient->buffer) _purrr_renderer_vulkan_destroy_buffer(data, transient->buffer, &transient->allocation);
+    for (size_t j = 0; j < transient->descriptor_pool_count; ++j) vkDestroyDescriptorPool(data->device, transient->descriptor_pools[j], VK_NULL_HANDLE);
+    free(transient->descriptor_pools);
+    memset(transient, 0, sizeof(*transient));
+  }
+}
+
+// sampler
+
+bool _purrr_sampler_vulkan_init(_purrr_sampler_t *sampler) {
+  if (!sampler || !sampler->renderer || !sampler->renderer->initialized) return false;
+  _purrr_sampler_data_t *data = (_purrr_sampler_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)sampler->renderer->data_ptr;
+
+  {
+    VkSamplerCreateInfo sampler_info = {
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = vk_filter(sampler->info.mag_filter),
+      .minFilter = vk_filter(sampler->info.min_filter),
+      .addressModeU = vk_sampler_address_mode(sampler->info.address_mode_u),
+      .addressModeV = vk_sampler_address_mode(sampler->info.address_mode_v),
+      .addressModeW = vk_sampler_address_mode(sampler->info.address_mode_w),
+      .anisotropyEnable = VK_FALSE, // TODO:
+      .maxAnisotropy = 1.0f, // TODO:
+      .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+      .unnormalizedCoordinates = VK_FALSE,
+      .compareEnable = VK_FALSE,
+      .compareOp = VK_COMPARE_OP_ALWAYS,
+      .mipmapMode = vk_sampler_mipmap_mode(sampler->info.mipmap_mode),
+      .mipLodBias = 0.0f,
+      .minLod = sampler->info.min_lod,
+      .maxLod = sampler->info.max_lod,
+    };
+
+    if (vkCreateSampler(renderer_data->device, &sampler_info, VK_NULL_HANDLE, &data->sampler) != VK_SUCCESS) goto error;
+  }
+
+  sampler->initialized = true;
+  sampler->data_ptr = data;
+
+  return true;
+error:
+  free(data);
+  return false;
+}
+
+void _purrr_sampler_vulkan_cleanup(_purrr_sampler_t *sampler) {
+  if (!sampler || !sampler->initialized) return;
+  assert(sampler->renderer);
+  _purrr_sampler_data_t *data = (_purrr_sampler_data_t*)sampler->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)sampler->renderer->data_ptr;
+  assert(data && renderer_data);
+  vkDestroySampler(renderer_data->device, data->sampler, VK_NULL_HANDLE);
+}
+
+// render target pool
+
+static bool _purrr_render_target_pool_vulkan_is_free(_purrr_vulkan_pool_frame_t *frame, size_t block, VkDeviceSize offset, VkDeviceSize size) {
+  if (block == PURRR_VULKAN_POOL_NO_BLOCK) return true;
+  for (size_t i = 0; i < frame->images.count; ++i) {
+    _purrr_vulkan_pool_image_t *other = &frame->images.items[i];
+    if (other->acquired && other->block == block && offset < other->offset+other->size && other->offset < offset+size) return false;
+  }
+  return true;
+}
+
+// First fit around the acquired images of every block, a new block is only allocated if none of them has room.
+static bool _purrr_render_target_pool_vulkan_place(_purrr_renderer_data_t *renderer_data, _purrr_render_target_pool_t *pool, VkMemoryRequirements requirements, _purrr_vulkan_allocation_t *allocation) {
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)pool->data_ptr;
+  assert(data && data->placing);
+  _purrr_vulkan_pool_frame_t *frame = &data->frames[data->frame_index];
+
+  size_t block_index = frame->blocks.count;
+  VkDeviceSize offset = 0;
+  for (size_t i = 0; i < frame->blocks.count && block_index == frame->blocks.count; ++i) {
+    _purrr_vulkan_allocation_t *block = &frame->blocks.items[i];
+    if (!(requirements.memoryTypeBits & (1u << block->memory_type))) continue;
+
+    // Candidates are the start of the block and the end of every image acquired from it.
+    for (size_t j = 0; j <= frame->images.count; ++j) {
+      VkDeviceSize candidate = 0;
+      if (j > 0) {
+        _purrr_vulkan_pool_image_t *other = &frame->images.items[j-1];
+        if (!other->acquired || other->block != i) continue;
+        candidate = other->offset+other->size;
+      }
+      candidate = _purrr_vulkan_align_up(block->offset+candidate, requirements.alignment)-block->offset;
+      if (candidate+requirements.size > block->size || !_purrr_render_target_pool_vulkan_is_free(frame, i, candidate, requirements.size)) continue;
+      block_index = i;
+      offset = candidate;
+      break;
+    }
+  }
+
+  if (block_index == frame->blocks.count) {
+    _purrr_vulkan_pool_blocks_t *blocks = &frame->blocks;
+    if (blocks->count >= blocks->capacity) {
+      size_t capacity = (blocks->capacity?blocks->capacity*2:4);
+      _purrr_vulkan_allocation_t *items = (_purrr_vulkan_allocation_t*)realloc(blocks->items, sizeof(*items)*capacity);
+      if (!items) return false;
+      blocks->items = items;
+      blocks->capacity = capacity;
+    }
+
+    VkMemoryRequirements block_requirements = requirements;
+    block_requirements.size = max(requirements.size, PURRR_VULKAN_POOL_BLOCK_SIZE);
+    if (!_purrr_vulkan_allocate(renderer_data, block_requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false, &blocks->items[blocks->count])) return false;
+    ++blocks->count;
+  }
+
+  _purrr_vulkan_allocation_t *block = &frame->blocks.items[block_index];
+  memset(allocation, 0, sizeof(*allocation));
+  allocation->memory = block->memory;
+  allocation->offset = block->offset+offset;
+  allocation->size = requirements.size;
+  allocation->memory_type = block->memory_type;
+
+  data->placing->block = block_index;
+  data->placing->offset = offset;
+  data->placing->size = requirements.size;
+  return true;
+}
+
+// The first call of a frame releases whatever the last frame using the same frame in flight left acquired and
+// destroys what wasn't used for a while, that frame's fence was already waited on by begin_frame.
+static void _purrr_render_target_pool_vulkan_begin(_purrr_renderer_data_t *renderer_data, _purrr_render_target_pool_data_t *data) {
+  if (data->frame == renderer_data->frame_counter) return;
+  data->frame = renderer_data->frame_counter;
+  data->frame_index = renderer_data->frame_index;
+  _purrr_vulkan_pool_frame_t *frame = &data->frames[data->frame_index];
+
+  // Render targets can't be newer than their images, so these go before any of the images they use.
+  for (size_t i = 0; i < frame->render_targets.count;) {
+    _purrr_vulkan_pool_render_target_t *render_target = &frame->render_targets.items[i];
+    if (render_target->last_used+PURRR_VULKAN_POOL_MAX_IDLE >= data->frame) {
+      ++i;
+      continue;
+    }
+    _purrr_render_target_free(render_target->render_target);
+    *render_target = frame->render_targets.items[--frame->render_targets.count];
+  }
+
+  for (size_t i = 0; i < frame->images.count;) {
+    _purrr_vulkan_pool_image_t *image = &frame->images.items[i];
+    image->acquired = false;
+    if (image->last_used+PURRR_VULKAN_POOL_MAX_IDLE >= data->frame) {
+      ++i;
+      continue;
+    }
+    _purrr_image_free(image->image);
+    *image = frame->images.items[--frame->images.count];
+  }
+
+  for (size_t i = frame->blocks.count; i-- > 0;) {
+    bool used = false;
+    for (size_t j = 0; j < frame->images.count && !used; ++j) used = (frame->images.items[j].block == i);
+    if (used) continue;
+
+    _purrr_vulkan_free(renderer_data, &frame->blocks.items[i]);
+    size_t last = --frame->blocks.count;
+    if (i == last) continue;
+    frame->blocks.items[i] = frame->blocks.items[last];
+    for (size_t j = 0; j < frame->images.count; ++j)
+      if (frame->images.items[j].block == last) frame->images.items[j].block = i;
+  }
+}
+
+bool _purrr_render_target_pool_vulkan_init(_purrr_render_target_pool_t *pool) {
+  if (!pool || !pool->renderer || !pool->renderer->initialized) return false;
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+  pool->data_ptr = data;
+  return true;
+}
+
+void _purrr_render_target_pool_vulkan_cleanup(_purrr_render_target_pool_t *pool) {
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)pool->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pool->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  for (uint32_t i = 0; i < 2; ++i) {
+    _purrr_vulkan_pool_frame_t *frame = &data->frames[i];
+    for (size_t j = 0; j < frame->render_targets.count; ++j) _purrr_render_target_free(frame->render_targets.items[j].render_target);
+    for (size_t j = 0; j < frame->images.count; ++j) _purrr_image_free(frame->images.items[j].image);
+    for (size_t j = 0; j < frame->blocks.count; ++j) _purrr_vulkan_free(renderer_data, &frame->blocks.items[j]);
+    free(frame->render_targets.items);
+    free(frame->images.items);
+    free(frame->blocks.items);
+  }
+  free(data);
+  pool->data_ptr = NULL;
+  pool->initialized = false;
+}
+
+_purrr_image_t *_purrr_render_target_pool_vulkan_acquire(_purrr_render_target_pool_t *pool, purrr_image_info_t *info) {
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)pool->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pool->renderer->data_ptr;
+  assert(data && renderer_data);
+  if (!renderer_data->active_cmd_buf || renderer_data->active_render_target) return NULL;
+
+  _purrr_render_target_pool_vulkan_begin(renderer_data, data);
+  _purrr_vulkan_pool_frame_t *frame = &data->frames[data->frame_index];
+
+  purrr_image_info_t image_info = *info;
+  image_info.mip_levels = 1;
+  image_info.tiling = PURRR_IMAGE_TILING_OPTIMAL;
+
+  // An image made for the same request that isn't acquired and whose memory isn't taken by one that is.
+  _purrr_vulkan_pool_image_t *entry = NULL;
+  for (size_t i = 0; i < frame->images.count && !entry; ++i) {
+    _purrr_vulkan_pool_image_t *candidate = &frame->images.items[i];
+    purrr_image_info_t *candidate_info = &candidate->image->info;
+    if (candidate->acquired || candidate_info->width != image_info.width || candidate_info->height != image_info.height ||
+        candidate_info->format != image_info.format || candidate_info->sample_count != image_info.sample_count || candidate_info->usage != image_info.usage) continue;
+    if (_purrr_render_target_pool_vulkan_is_free(frame, candidate->block, candidate->offset, candidate->size)) entry = candidate;
+  }
+
+  if (!entry) {
+    _purrr_vulkan_pool_images_t *images = &frame->images;
+    if (images->count >= images->capacity) {
+      size_t capacity = (images->capacity?images->capacity*2:4);
+      _purrr_vulkan_pool_image_t *items = (_purrr_vulkan_pool_image_t*)realloc(images->items, sizeof(*items)*capacity);
+      if (!items) return NULL;
+      images->items = items;
+      images->capacity = capacity;
+    }
+
+    entry = &images->items[images->count];
+    memset(entry, 0, sizeof(*entry));
+    entry->block = PURRR_VULKAN_POOL_NO_BLOCK;
+    data->placing = entry;
+    entry->image = _purrr_image_create(&image_info, pool->renderer, pool);
+    data->placing = NULL;
+    if (!entry->image) return NULL;
+    ++images->count;
+  }
+
+  // Anything used earlier in this frame that shares memory with the image has to be done with it first.
+  bool aliased = false;
+  for (size_t i = 0; i < frame->images.count && !aliased; ++i) {
+    _purrr_vulkan_pool_image_t *other = &frame->images.items[i];
+    aliased = (entry->block != PURRR_VULKAN_POOL_NO_BLOCK && other->last_used == data->frame && other->block == entry->block && entry->offset < other->offset+other->size && other->offset < entry->offset+entry->size);
+  }
+
+  // Keeps the images in the layouts everything else expects them in.
+  _purrr_image_data_t *image_data = (_purrr_image_data_t*)entry->image->data_ptr;
+  VkImageLayout layout = image_data->layout;
+
+  VkMemoryBarrier memory_barrier = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+  };
+  VkImageMemoryBarrier image_barrier = _purrr_vulkan_image_barrier(image_data->image, VK_IMAGE_LAYOUT_UNDEFINED, layout, 0, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+  vkCmdPipelineBarrier(renderer_data->active_cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, (aliased?1:0), &memory_barrier, 0, NULL, 1, &image_barrier);
+
+  entry->acquired = true;
+  entry->last_used = data->frame;
+  return entry->image;
+}
+
+void _purrr_render_target_pool_vulkan_release(_purrr_render_target_pool_t *pool, _purrr_image_t *image) {
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)pool->data_ptr;
+  assert(data);
+  _purrr_vulkan_pool_frame_t *frame = &data->frames[data->frame_index];
+  for (size_t i = 0; i < frame->images.count; ++i) {
+    if (frame->images.items[i].image != image) continue;
+    frame->images.items[i].acquired = false;
+    return;
+  }
+}
+
+_purrr_render_target_t *_purrr_render_target_pool_vulkan_get_render_target(_purrr_render_target_pool_t *pool, purrr_render_target_info_t *info) {
+  _purrr_render_target_pool_data_t *data = (_purrr_render_target_pool_data_t*)pool->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pool->renderer->data_ptr;
+  assert(data && renderer_data);
+  if (data->frame != renderer_data->frame_counter) return NULL; // Nothing was acquired this frame
+
+  _purrr_pipeline_descriptor_t *pipeline_descriptor = (_purrr_pipeline_descriptor_t*)info->pipeline_descriptor;
+  if (!pipeline_descriptor->initialized) return NULL;
+  uint32_t image_count = pipeline_descriptor->info.color_attachment_count*(pipeline_descriptor->info.resolve_attachments?2:1)+(pipeline_descriptor->info.depth_attachment?1:0);
+
+  _purrr_vulkan_pool_frame_t *frame = &data->frames[data->frame_index];
+  for (uint32_t i = 0; i < image_count; ++i) {
+    bool acquired = false;
+    for (size_t j = 0; j < frame->images.count && !acquired; ++j)
+      acquired = (frame->images.items[j].acquired && (purrr_image_t*)frame->images.items[j].image == info->images[i]);
+    if (!acquired) return NULL;
+  }
+
+  for (size_t i = 0; i < frame->render_targets.count; ++i) {
+    _purrr_vulkan_pool_render_target_t *render_target = &frame->render_targets.items[i];
+    if (render_target->render_target->descriptor != pipeline_descriptor || render_target->render_target->width != info->width || render_target->render_target->height != info->height ||
+        memcmp(render_target->images, info->images, sizeof(*info->images)*image_count) != 0) continue;
+    render_target->last_used = data->frame;
+    return render_target->render_target;
+  }
+
+  _purrr_vulkan_pool_render_targets_t *render_targets = &frame->render_targets;
+  if (render_targets->count >= render_targets->capacity) {
+    size_t capacity = (render_targets->capacity?render_targets->capacity*2:4);
+    _purrr_vulkan_pool_render_target_t *items = (_purrr_vulkan_pool_render_target_t*)realloc(render_targets->items, sizeof(*items)*capacity);
+    if (!items) return NULL;
+    render_targets->items = items;
+    render_targets->capacity = capacity;
+  }
+
+  _purrr_vulkan_pool_render_target_t *render_target = &render_targets->items[render_targets->count];
+  memset(render_target, 0, sizeof(*render_target));
+  render_target->render_target = (_purrr_render_target_t*)purrr_render_target_create(info, (purrr_renderer_t*)pool->renderer);
+  if (!render_target->render_target) return NULL;
+  memcpy(render_target->images, info->images, sizeof(*info->images)*image_count);
+  render_target->last_used = data->frame;
+  ++render_targets->count;
+
+  return render_target->render_target;
+}
+
+// image
+
+// The layout an image stays in between uses, every transition goes back to it. It has to be one its usage allows.
+static VkImageLayout _purrr_image_vulkan_resting_layout(VkImageUsageFlags usage, bool linear) {
+  if (linear) return VK_IMAGE_LAYOUT_GENERAL;
+  if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  if (usage & VK_IMAGE_USAGE_STORAGE_BIT) return VK_IMAGE_LAYOUT_GENERAL;
+  if (usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  return VK_IMAGE_LAYOUT_GENERAL;
+}
+
+// What uses an image in its resting layout, for the barriers that transition back to it.
+static void _purrr_image_vulkan_resting_access(VkImageLayout layout, VkAccessFlags *access, VkPipelineStageFlags *stage) {
+  switch (layout) {
+  case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+    *access = VK_ACCESS_SHADER_READ_BIT;
+    *stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    break;
+  case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+    *access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    *stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    break;
+  case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+    *access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    *stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    break;
+  case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+    *access = VK_ACCESS_TRANSFER_READ_BIT;
+    *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    break;
+  default:
+    *access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    *stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    break;
+  }
+}
+
+// Creates the Vulkan objects of an image, split from init so streamed textures can bring evicted images back.
+static bool _purrr_image_vulkan_create(_purrr_renderer_data_t *renderer_data, _purrr_image_t *image, _purrr_image_data_t *data) {
+  VkFormat format = vk_format(renderer_data, image->info.format);
+  VkImageAspectFlags aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT;
+
+  bool depth = (image->info.format==PURRR_FORMAT_DEPTH);
+  if (depth) aspect_flags = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+  bool compressed = format_is_compressed(image->info.format);
+
+  purrr_image_usage_t usage = image->info.usage;
+  if (!usage) {
+    usage = PURRR_IMAGE_USAGE_SAMPLED | PURRR_IMAGE_USAGE_TRANSFER_SRC | PURRR_IMAGE_USAGE_TRANSFER_DST;
+    if (!compressed) usage |= (depth?PURRR_IMAGE_USAGE_DEPTH_TARGET:PURRR_IMAGE_USAGE_COLOR_TARGET);
+  }
+  bool transient = (usage & PURRR_IMAGE_USAGE_TRANSIENT);
+  if (transient && (compressed || (usage & ~(PURRR_IMAGE_USAGE_TRANSIENT | PURRR_IMAGE_USAGE_COLOR_TARGET | PURRR_IMAGE_USAGE_DEPTH_TARGET)))) return false;
+  if (compressed && (usage & (PURRR_IMAGE_USAGE_COLOR_TARGET | PURRR_IMAGE_USAGE_DEPTH_TARGET | PURRR_IMAGE_USAGE_STORAGE))) return false;
+
+  data->usage = 0;
+  if (usage & PURRR_IMAGE_USAGE_SAMPLED)      data->usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (usage & PURRR_IMAGE_USAGE_COLOR_TARGET) data->usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  if (usage & PURRR_IMAGE_USAGE_DEPTH_TARGET) data->usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  if (usage & PURRR_IMAGE_USAGE_STORAGE)      data->usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+  if (usage & PURRR_IMAGE_USAGE_TRANSFER_SRC) data->usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  if (usage & PURRR_IMAGE_USAGE_TRANSFER_DST) data->usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  if (transient)                              data->usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+  VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, preferred = (transient?VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT:0);
+
+  // Linear images are only used if the device can sample (or whatever else was asked for) them in that format.
+  VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
+  if (image->info.tiling == PURRR_IMAGE_TILING_LINEAR && !depth && !compressed && !transient && image->info.sample_count == PURRR_SAMPLE_COUNT_1) {
+    VkImageFormatProperties format_properties;
+    if (vkGetPhysicalDeviceImageFormatProperties(renderer_data->gpu, format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_LINEAR, data->usage, 0, &format_properties) == VK_SUCCESS &&
+        format_properties.maxExtent.width >= image->info.width && format_properties.maxExtent.height >= image->info.height) {
+      tiling = VK_IMAGE_TILING_LINEAR;
+      properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+      preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+  }
+  bool linear = (tiling == VK_IMAGE_TILING_LINEAR);
+
+  data->mip_levels = 1;
+  data->mip_filter = VK_FILTER_LINEAR;
+  if (!depth && !transient && !linear && image->info.sample_count == PURRR_SAMPLE_COUNT_1 && image->info.mip_levels != 1) {
+    uint32_t full_chain = 1;
+    for (uint32_t size = max(image->info.width, image->info.height); size > 1; size >>= 1) ++full_chain;
+    data->mip_levels = ((image->info.mip_levels && image->info.mip_levels < full_chain)?image->info.mip_levels:full_chain);
+
+    // The chain is generated with blits, formats that can't be blitted only get the first level.
+    // Compressed ones keep every level, those are uploaded from the source instead.
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(renderer_data->gpu, format, &props);
+    data->generate_mips = (!compressed && data->mip_levels > 1 && (data->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+    if ((props.optimalTilingFeatures & (VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT)) != (VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+      data->generate_mips = false;
+      if (!compressed) data->mip_levels = 1;
+    }
+    if (!(props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+      data->mip_filter = VK_FILTER_NEAREST;
+    if (data->generate_mips) data->usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
+  data->layout = _purrr_image_vulkan_resting_layout(data->usage, linear);
+
+  {
+    VkImageCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, VK_NULL_HANDLE, 0,
+      VK_IMAGE_TYPE_2D,
+      format,
+      (VkExtent3D){
+        .width = image->info.width,
+        .height = image->info.height,
+        .depth = 1,
+      },
+      data->mip_levels,
+      1,
+      (VkSampleCountFlagBits)1<<image->info.sample_count,
+      tiling,
+      data->usage,
+      VK_SHARING_MODE_EXCLUSIVE,
+      0, NULL,
+      (linear?VK_IMAGE_LAYOUT_PREINITIALIZED:VK_IMAGE_LAYOUT_UNDEFINED),
+    };
+
+    if (vkCreateImage(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->image) != VK_SUCCESS) return false;
+  }
+
+  {
+    VkMemoryRequirements memRequirements = {0};
+    vkGetImageMemoryRequirements(renderer_data->device, data->image, &memRequirements);
+
+    // Transient images stay out of the pool's blocks, those are plain device local memory and would take up
+    // real memory for something that may never need any.
+    if (image->pool && !transient) {
+      if (!_purrr_render_target_pool_vulkan_place(renderer_data, image->pool, memRequirements, &data->allocation)) return false;
+      data->pooled = true;
+    } else if (!_purrr_vulkan_allocate(renderer_data, memRequirements, properties, preferred, linear, &data->allocation)) return false;
+
+    vkBindImageMemory(renderer_data->device, data->image, data->allocation.memory, data->allocation.offset);
+    if (linear && !_purrr_vulkan_map(renderer_data, &data->allocation, (void**)&data->mapped)) return false;
+  }
+
+  // Views need a usage they could be read or rendered through, transfer-only images don't get any.
+  if (data->usage & (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
+    VkImageViewCreateInfo create_info = {
+      VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, VK_NULL_HANDLE, 0,
+      data->image,
+      VK_IMAGE_VIEW_TYPE_2D,
+      format,
+      (VkComponentMapping){0},
+      (VkImageSubresourceRange){
+        aspect_flags,
+        0,
+        data->mip_levels,
+        0,
+        1,
+      },
+    };
+
+    if (vkCreateImageView(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->image_view) != VK_SUCCESS) return false;
+
+    // Framebuffers can only take a single level.
+    data->attachment_view = data->image_view;
+    if (data->mip_levels > 1) {
+      create_info.subresourceRange.levelCount = 1;
+      if (vkCreateImageView(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->attachment_view) != VK_SUCCESS) return false;
+    }
+  }
+
+  // GENERAL keeps whatever the host writes. The transition goes into the frame being recorded or the next one (or
+  // transfer) instead of waiting for a submit of its own, only inside a render pass it can't be recorded there.
+  if (linear && renderer_data->active_render_target) {
+    VkCommandBuffer cmd_buf = _purrr_vulkan_staging_begin(renderer_data);
+    if (!cmd_buf) return false;
+    _purrr_vulkan_cmd_transition_image_layout(cmd_buf, data->image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    if (!_purrr_vulkan_staging_submit(renderer_data, cmd_buf, true)) return false;
+  } else if (linear && renderer_data->active_cmd_buf) {
+    _purrr_vulkan_cmd_transition_image_layout(renderer_data->active_cmd_buf, data->image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    data->last_used = renderer_data->frame_counter;
+    data->last_frame_index = renderer_data->frame_index;
+  } else if (linear) {
+    _purrr_vulkan_image_list_t *preinitialized = &renderer_data->preinitialized;
+    if (preinitialized->count >= preinitialized->capacity) {
+      size_t capacity = (preinitialized->capacity?preinitialized->capacity*2:4);
+      _purrr_image_data_t **items = (_purrr_image_data_t**)realloc(preinitialized->items, sizeof(*items)*capacity);
+      if (!items) return false;
+      preinitialized->items = items;
+      preinitialized->capacity = capacity;
+    }
+    preinitialized->items[preinitialized->count++] = data;
+  }
+
+  return true;
+}
+
+static void _purrr_image_vulkan_forget_preinitialized(_purrr_renderer_data_t *renderer_data, _purrr_image_data_t *data) {
+  _purrr_vulkan_image_list_t *preinitialized = &renderer_data->preinitialized;
+  for (size_t i = 0; i < preinitialized->count; ++i) {
+    if (preinitialized->items[i] != data) continue;
+    preinitialized->items[i] = preinitialized->items[--preinitialized->count];
+    return;
+  }
+}
+
+// Moves the linear images created since the last call to GENERAL, host writes made before the submit are kept.
+static void _purrr_vulkan_cmd_transition_preinitialized(_purrr_renderer_data_t *renderer_data, VkCommandBuffer cmd_buf) {
+  _purrr_vulkan_image_list_t *preinitialized = &renderer_data->preinitialized;
+  for (size_t i = 0; i < preinitialized->count; ++i) {
+    _purrr_image_data_t *data = preinitialized->items[i];
+    _purrr_vulkan_cmd_transition_image_layout(cmd_buf, data->image, VK_IMAGE_LAYOUT_PREINITIALIZED, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    data->last_used = renderer_data->frame_counter;
+    data->last_frame_index = renderer_data->frame_index;
+  }
+  preinitialized->count = 0;
+}
+
+static void _purrr_image_vulkan_mark_used(_purrr_renderer_data_t *renderer_data, _purrr_image_t *image) {
+  _purrr_image_data_t *data = (_purrr_image_data_t*)image->data_ptr;
+  data->last_used = renderer_data->frame_counter;
+  data->last_frame_index = renderer_data->frame_index;
+}
+
+// Linear images have a single level, the rows are copied straight into the mapped memory.
+// Only the frame in flight that last used the image is waited on. The frame being recorded hasn't been submitted
+// (its fence is still signaled) and sees the write once it is, but the one before it could have used the image too.
+// Images read through descriptor sets or bindless slots wait for both frames.
+static void _purrr_image_vulkan_write_linear(_purrr_renderer_data_t *renderer_data, _purrr_image_t *image, const uint8_t *pixels, uint32_t width, uint32_t height) {
+  _purrr_image_data_t *data = (_purrr_image_data_t*)image->data_ptr;
+  if (data->indirect || data->last_used == renderer_data->frame_counter)
+    vkWaitForFences(renderer_data->device, 2, renderer_data->flight_fences, VK_TRUE, UINT64_MAX);
+  else if (data->last_used+1 == renderer_data->frame_counter)
+    vkWaitForFences(renderer_data->device, 1, &renderer_data->flight_fences[data->last_frame_index], VK_TRUE, UINT64_MAX);
+
+  VkImageSubresource subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 };
+  VkSubresourceLayout layout;
+  vkGetImageSubresourceLayout(renderer_data->device, data->image, &subresource, &layout);
+
+  size_t row_size = (size_t)format_size(image->info.format)*width;
+  for (uint32_t y = 0; y < height; ++y)
+    memcpy(data->mapped + layout.offset + layout.rowPitch*y, pixels + row_size*y, row_size);
+}
+
+static void _purrr_image_vulkan_destroy(_purrr_renderer_data_t *renderer_data, _purrr_image_data_t *data) {
+  if (!data->image) return;
+  _purrr_image_vulkan_forget_preinitialized(renderer_data, data);
+  if (data->attachment_view != data->image_view) vkDestroyImageView(renderer_data->device, data->attachment_view, VK_NULL_HANDLE);
+  vkDestroyImageView(renderer_data->device, data->image_view, VK_NULL_HANDLE);
+  vkDestroyImage(renderer_data->device, data->image, VK_NULL_HANDLE);
+  if (data->pooled) memset(&data->allocation, 0, sizeof(data->allocation));
+  else _purrr_vulkan_free(renderer_data, &data->allocation);
+  data->mapped = NULL;
+  data->image = VK_NULL_HANDLE;
+  data->image_view = VK_NULL_HANDLE;
+  data->attachment_view = VK_NULL_HANDLE;
+}
+
+bool _purrr_image_vulkan_init(_purrr_image_t *image) {
+  if (!image || !image->renderer || !image->renderer->initialized) return false;
+  _purrr_image_data_t *data = (_purrr_image_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)image->renderer->data_ptr;
+  assert(renderer_data);
+
+  if (!_purrr_image_vulkan_create(renderer_data, image, data)) goto error;
+
+  // if (depth) {
+  //   _purrr_vulkan_transition_image_layout(renderer_data, data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+  //                                         0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+  //                                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT);
+  // }
+
+  image->initialized = true;
+  image->data_ptr = data;
+
+  return true;
+error:
+  _purrr_image_vulkan_destroy(renderer_data, data);
+  free(data);
+  return false;
+}
+
+void _purrr_image_vulkan_cleanup(_purrr_image_t *image) {
+  if (!image || !image->initialized) return;
+  assert(image->renderer);
+  _purrr_image_data_t *data = (_purrr_image_data_t*)image->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)image->renderer->data_ptr;
+  assert(data && renderer_data);
+  _purrr_image_vulkan_destroy(renderer_data, data);
+}
+
+bool _purrr_image_vulkan_load(_purrr_image_t *dst, uint8_t *src, uint32_t src_width, uint32_t src_height) {
+  if (!dst || !dst->initialized || !dst->renderer || !dst->renderer->initialized) return false;
+  purrr_image_load_info_t info = {
+    .image = (purrr_image_t*)dst,
+    .pixels = src,
+    .width = src_width,
+    .height = src_height,
+  };
+  return _purrr_image_vulkan_load_many(&info, 1);
+}
+
+bool _purrr_image_vulkan_load_many(purrr_image_load_info_t *infos, uint32_t count) {
+  if (!infos || count == 0) return false;
+  _purrr_image_t *first = (_purrr_image_t*)infos[0].image;
+  if (!first || !first->renderer || !first->renderer->initialized) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)first->renderer->data_ptr;
+  assert(renderer_data);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    _purrr_image_t *image = (_purrr_image_t*)infos[i].image;
+    if (!image || !image->initialized || image->renderer != first->renderer || !infos[i].pixels) return false;
+    if (image->info.width < infos[i].width || image->info.height < infos[i].height) return false;
+    _purrr_image_data_t *image_data = (_purrr_image_data_t*)image->data_ptr;
+    if (!image_data->mapped && !(image_data->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) return false;
+  }
+
+  // Linear images are written in place, only the rest goes through the staging ring.
+  purrr_image_load_info_t *staged = (purrr_image_load_info_t*)malloc(sizeof(*staged)*count);
+  assert(staged);
+  uint32_t staged_count = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    _purrr_image_t *image = (_purrr_image_t*)infos[i].image;
+    if (((_purrr_image_data_t*)image->data_ptr)->mapped) _purrr_image_vulkan_write_linear(renderer_data, image, infos[i].pixels, infos[i].width, infos[i].height);
+    else staged[staged_count++] = infos[i];
+  }
+  infos = staged;
+  count = staged_count;
+  if (count == 0) {
+    free(staged);
+    return true;
+  }
+
+  VkBuffer *staging_buffers = (VkBuffer*)malloc(sizeof(*staging_buffers)*count);
+  VkDeviceSize *staging_offsets = (VkDeviceSize*)malloc(sizeof(*staging_offsets)*count);
+  VkImageMemoryBarrier *barriers = (VkImageMemoryBarrier*)malloc(sizeof(*barriers)*count);
+  assert(staging_buffers && staging_offsets && barriers);
+
+  bool result = false;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    _purrr_image_t *image = (_purrr_image_t*)infos[i].image;
+    VkDeviceSize texel_size = format_size(image->info.format);
+    VkDeviceSize size = format_image_size(image->info.format, infos[i].width, infos[i].height);
+
+    void *buffer_data;
+    if (!_purrr_vulkan_staging_claim(renderer_data, size, texel_size*4, &staging_buffers[i], &staging_offsets[i], &buffer_data)) goto defer;
+    memcpy(buffer_data, infos[i].pixels, (size_t)size);
+  }
+
+  VkCommandBuffer cmd_buf = _purrr_vulkan_staging_begin(renderer_data);
+  if (!cmd_buf) goto defer;
+
+  for (uint32_t i = 0; i < count; ++i)
+    barriers[i] = _purrr_vulkan_image_barrier(((_purrr_image_data_t*)((_purrr_image_t*)infos[i].image)->data_ptr)->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, count, barriers);
+
+  for (uint32_t i = 0; i < count; ++i)
+    _purrr_renderer_vulkan_copy_buffer_to_image(cmd_buf, staging_buffers[i], staging_offsets[i], barriers[i].image, 0, format_block_extent(((_purrr_image_t*)infos[i].image)->info.format), infos[i].width, infos[i].height);
+
+  VkPipelineStageFlags dst_stages = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    _purrr_image_t *image = (_purrr_image_t*)infos[i].image;
+    _purrr_image_data_t *image_data = (_purrr_image_data_t*)image->data_ptr;
+    barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    if (image_data->generate_mips) {
+      _purrr_vulkan_cmd_generate_mips(cmd_buf, image_data->image, image->info.width, image->info.height, image_data->mip_levels, image_data->mip_filter);
+      barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    }
+    VkPipelineStageFlags stage;
+    barriers[i].newLayout = image_data->layout;
+    barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    _purrr_image_vulkan_resting_access(image_data->layout, &barriers[i].dstAccessMask, &stage);
+    dst_stages |= stage;
+  }
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, count, barriers);
+
+  result = _purrr_vulkan_staging_submit(renderer_data, cmd_buf, false);
+
+defer:
+  free(staged);
+  free(staging_buffers);
+  free(staging_offsets);
+  free(barriers);
+  return result;
+}
+
+bool _purrr_image_vulkan_load_levels(_purrr_image_t *dst, const _purrr_image_level_t *levels, uint32_t level_count) {
+  if (!dst || !dst->initialized || !dst->renderer || !dst->renderer->initialized || !levels || level_count == 0) return false;
+  _purrr_image_data_t *data = (_purrr_image_data_t*)dst->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)dst->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (data->mapped) {
+    if (level_count != 1 || levels[0].size < format_image_size(dst->info.format, dst->info.width, dst->info.height)) return false;
+    _purrr_image_vulkan_write_linear(renderer_data, dst, levels[0].data, dst->info.width, dst->info.height);
+    return true;
+  }
+  if (!(data->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) return false;
+
+  // Either every level is provided or the chain is generated from the first one.
+  bool generate = (level_count == 1 && data->generate_mips);
+  if (level_count != data->mip_levels && !generate) return false;
+
+  VkBuffer *staging_buffers = (VkBuffer*)malloc(sizeof(*staging_buffers)*level_count);
+  VkDeviceSize *staging_offsets = (VkDeviceSize*)malloc(sizeof(*staging_offsets)*level_count);
+  assert(staging_buffers && staging_offsets);
+
+  bool result = false;
+
+  VkDeviceSize block_size = format_size(dst->info.format);
+  for (uint32_t i = 0; i < level_count; ++i) {
+    uint32_t width = max(dst->info.width>>i, 1u), height = max(dst->info.height>>i, 1u);
+    VkDeviceSize size = format_image_size(dst->info.format, width, height);
+    if (levels[i].size < size) goto defer;
+
+    void *buffer_data;
+    if (!_purrr_vulkan_staging_claim(renderer_data, size, block_size*4, &staging_buffers[i], &staging_offsets[i], &buffer_data)) goto defer;
+    memcpy(buffer_data, levels[i].data, (size_t)size);
+  }
+
+  VkCommandBuffer cmd_buf = _purrr_vulkan_staging_begin(renderer_data);
+  if (!cmd_buf) goto defer;
+
+  _purrr_vulkan_cmd_transition_image_layout(cmd_buf, data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  for (uint32_t i = 0; i < level_count; ++i)
+    _purrr_renderer_vulkan_copy_buffer_to_image(cmd_buf, staging_buffers[i], staging_offsets[i], data->image, i, format_block_extent(dst->info.format), max(dst->info.width>>i, 1u), max(dst->info.height>>i, 1u));
+
+  VkImageLayout layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  if (generate) {
+    _purrr_vulkan_cmd_generate_mips(cmd_buf, data->image, dst->info.width, dst->info.height, data->mip_levels, data->mip_filter);
+    layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  }
+  VkAccessFlags access;
+  VkPipelineStageFlags stage;
+  _purrr_image_vulkan_resting_access(data->layout, &access, &stage);
+  _purrr_vulkan_cmd_transition_image_layout(cmd_buf, data->image, layout, data->layout, VK_ACCESS_TRANSFER_WRITE_BIT, access, VK_PIPELINE_STAGE_TRANSFER_BIT, stage);
+
+  result = _purrr_vulkan_staging_submit(renderer_data, cmd_buf, false);
+
+defer:
+  free(staging_buffers);
+  free(staging_offsets);
+  return result;
+}
+
+// Fills in zero sized regions and checks they fit into their level.
+static bool _purrr_image_vulkan_region(_purrr_image_t *image, const purrr_image_region_t *region, VkOffset3D offsets[2]) {
+  _purrr_image_data_t *data = (_purrr_image_data_t*)image->data_ptr;
+  if (region->mip_level >= data->mip_levels) return false;
+  uint32_t level_width = max(image->info.width>>region->mip_level, 1u), level_height = max(image->info.height>>region->mip_level, 1u);
+  if (region->x >= level_width || region->y >= level_height) return false;
+  uint32_t width = (region->width?region->width:level_width - region->x), height = (region->height?region->height:level_height - region->y);
+  if (width > level_width - region->x || height > level_height - region->y) return false;
+  offsets[0] = (VkOffset3D){ (int32_t)region->x, (int32_t)region->y, 0 };
+  offsets[1] = (VkOffset3D){ (int32_t)(region->x + width), (int32_t)(region->y + height), 1 };
+  return true;
+}
+
+// Copies of block-compressed images move whole blocks, only the edges of the level may end in a partial one.
+static bool _purrr_image_vulkan_block_aligned(_purrr_image_t *image, uint32_t mip_level, const VkOffset3D offsets[2]) {
+  uint32_t block = format_block_extent(image->info.format);
+  if (block <= 1) return true;
+  uint32_t level_width = max(image->info.width>>mip_level, 1u), level_height = max(image->info.height>>mip_level, 1u);
+  if (offsets[0].x % block || offsets[0].y % block) return false;
+  if ((uint32_t)offsets[1].x != level_width && offsets[1].x % block) return false;
+  if ((uint32_t)offsets[1].y != level_height && offsets[1].y % block) return false;
+  return true;
+}
+
+static VkFormatFeatureFlags _purrr_image_vulkan_format_features(_purrr_renderer_data_t *renderer_data, _purrr_image_t *image) {
+  VkFormatProperties props = {0};
+  vkGetPhysicalDeviceFormatProperties(renderer_data->gpu, vk_format(renderer_data, image->info.format), &props);
+  return (((_purrr_image_data_t*)image->data_ptr)->mapped?props.linearTilingFeatures:props.optimalTilingFeatures);
+}
+
+// Images sit in their data's layout between commands, multisampled ones stay in COLOR_ATTACHMENT_OPTIMAL
+// after their render pass (they can't be sampled anyway). The destination is discarded if all of it gets overwritten.
+static bool _purrr_vulkan_cmd_transfer_image(VkCommandBuffer cmd_buf, const purrr_image_transfer_info_t *info) {
+  _purrr_image_t *dst = (_purrr_image_t*)info->dst, *src = (_purrr_image_t*)info->src;
+  if (!dst || !src || dst == src || !dst->initialized || !src->initialized || dst->renderer != src->renderer) return false;
+  _purrr_image_data_t *dst_data = (_purrr_image_data_t*)dst->data_ptr, *src_data = (_purrr_image_data_t*)src->data_ptr;
+  if (!dst_data->image || !src_data->image) return false; // Evicted
+  if (!(dst_data->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) || !(src_data->usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) return false;
+  if (dst->info.format == PURRR_FORMAT_DEPTH || src->info.format == PURRR_FORMAT_DEPTH || dst->info.sample_count != PURRR_SAMPLE_COUNT_1) return false;
+
+  VkOffset3D src_offsets[2], dst_offsets[2];
+  if (!_purrr_image_vulkan_region(src, &info->src_region, src_offsets)) return false;
+  purrr_image_region_t dst_region = info->dst_region;
+  if (info->op != PURRR_IMAGE_OP_BLIT) { // The extent always comes from the source
+    dst_region.width = (uint32_t)(src_offsets[1].x - src_offsets[0].x);
+    dst_region.height = (uint32_t)(src_offsets[1].y - src_offsets[0].y);
+  }
+  if (!_purrr_image_vulkan_region(dst, &dst_region, dst_offsets)) return false;
+
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)dst->renderer->data_ptr;
+  switch (info->op) {
+  case PURRR_IMAGE_OP_COPY:
+    if (format_size(dst->info.format) != format_size(src->info.format) || format_block_extent(dst->info.format) != format_block_extent(src->info.format)) return false;
+    if (src->info.sample_count != PURRR_SAMPLE_COUNT_1) return false;
+    if (!_purrr_image_vulkan_block_aligned(src, info->src_region.mip_level, src_offsets) ||
+        !_purrr_image_vulkan_block_aligned(dst, info->dst_region.mip_level, dst_offsets)) return false;
+    break;
+  case PURRR_IMAGE_OP_BLIT: {
+    if (format_is_compressed(dst->info.format) || format_is_compressed(src->info.format) || src->info.sample_count != PURRR_SAMPLE_COUNT_1) return false;
+    VkFormatFeatureFlags src_features = _purrr_image_vulkan_format_features(renderer_data, src);
+    if (!(src_features & VK_FORMAT_FEATURE_BLIT_SRC_BIT)) return false;
+    if (!(_purrr_image_vulkan_format_features(renderer_data, dst) & VK_FORMAT_FEATURE_BLIT_DST_BIT)) return false;
+    if (info->filter == PURRR_SAMPLER_FILTER_LINEAR && !(src_features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) return false;
+  } break;
+  case PURRR_IMAGE_OP_RESOLVE:
+    if (dst->info.format != src->info.format || src->info.sample_count == PURRR_SAMPLE_COUNT_1) return false;
+    break;
+  case COUNT_PURRR_IMAGE_OPS:
+  default: return false;
+  }
+
+  VkImageLayout src_layout = src_data->layout;
+  bool whole = (dst_data->mip_levels == 1 && dst_offsets[0].x == 0 && dst_offsets[0].y == 0 &&
+                (uint32_t)dst_offsets[1].x == dst->info.width && (uint32_t)dst_offsets[1].y == dst->info.height);
+
+  VkImageMemoryBarrier barriers[2] = {
+    _purrr_vulkan_image_barrier(src_data->image, src_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+    _purrr_vulkan_image_barrier(dst_data->image, (whole?VK_IMAGE_LAYOUT_UNDEFINED:dst_data->layout), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT),
+  };
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 2, barriers);
+
+  VkImageSubresourceLayers src_subresource = {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .mipLevel = info->src_region.mip_level,
+    .baseArrayLayer = 0,
+    .layerCount = 1,
+  };
+  VkImageSubresourceLayers dst_subresource = src_subresource;
+  dst_subresource.mipLevel = info->dst_region.mip_level;
+  VkExtent3D extent = { (uint32_t)(src_offsets[1].x - src_offsets[0].x), (uint32_t)(src_offsets[1].y - src_offsets[0].y), 1 };
+
+  switch (info->op) {
+  case PURRR_IMAGE_OP_COPY: {
+    VkImageCopy region = {
+      .srcSubresource = src_subresource,
+      .srcOffset = src_offsets[0],
+      .dstSubresource = dst_subresource,
+      .dstOffset = dst_offsets[0],
+      .extent = extent,
+    };
+    vkCmdCopyImage(cmd_buf, src_data->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_data->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  } break;
+  case PURRR_IMAGE_OP_BLIT: {
+    VkImageBlit region = {
+      .srcSubresource = src_subresource,
+      .srcOffsets = { src_offsets[0], src_offsets[1] },
+      .dstSubresource = dst_subresource,
+      .dstOffsets = { dst_offsets[0], dst_offsets[1] },
+    };
+    vkCmdBlitImage(cmd_buf, src_data->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_data->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, vk_filter(info->filter));
+  } break;
+  case PURRR_IMAGE_OP_RESOLVE: {
+    VkImageResolve region = {
+      .srcSubresource = src_subresource,
+      .srcOffset = src_offsets[0],
+      .dstSubresource = dst_subresource,
+      .dstOffset = dst_offsets[0],
+      .extent = extent,
+    };
+    vkCmdResolveImage(cmd_buf, src_data->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_data->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  } break;
+  case COUNT_PURRR_IMAGE_OPS:
+  default: break;
+  }
+
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barriers[0].newLayout = src_layout;
+  barriers[0].srcAccessMask = 0;
+  barriers[0].dstAccessMask = 0;
+  barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barriers[1].newLayout = dst_data->layout;
+  barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barriers[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 2, barriers);
+
+  return true;
+}
+
+bool _purrr_image_vulkan_transfer(const purrr_image_transfer_info_t *infos, uint32_t count) {
+  if (!infos || count == 0) return false;
+  _purrr_image_t *first = (_purrr_image_t*)infos[0].dst;
+  if (!first || !first->renderer || !first->renderer->initialized) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)first->renderer->data_ptr;
+  assert(renderer_data);
+
+  for (uint32_t i = 0; i < count; ++i)
+    if (!infos[i].dst || ((_purrr_image_t*)infos[i].dst)->renderer != first->renderer) return false;
+
+  VkCommandBuffer cmd_buf = _purrr_vulkan_staging_begin(renderer_data);
+  if (!cmd_buf) return false;
+  _purrr_vulkan_cmd_transition_preinitialized(renderer_data, cmd_buf); // Staging runs before the next frame
+
+  // Nothing can be taken back once recorded, so a failed transfer still submits the ones before it.
+  bool result = true;
+  for (uint32_t i = 0; i < count && result; ++i) result = _purrr_vulkan_cmd_transfer_image(cmd_buf, &infos[i]);
+
+  return _purrr_vulkan_staging_submit(renderer_data, cmd_buf, false) && result;
+}
+
+bool _purrr_image_vulkan_copy(_purrr_image_t *dst, _purrr_image_t *src, uint32_t src_width, uint32_t src_height) {
+  purrr_image_transfer_info_t info = {
+    .op = PURRR_IMAGE_OP_COPY,
+    .dst = (purrr_image_t*)dst,
+    .src = (purrr_image_t*)src,
+    .src_region = { 0, 0, src_width, src_height, 0 },
+  };
+  return _purrr_image_vulkan_transfer(&info, 1);
+}
+
+// texture
+
+static bool _purrr_texture_vulkan_allocate_set(_purrr_renderer_data_t *renderer_data, _purrr_image_data_t *image_data, VkSampler sampler, _purrr_vulkan_descriptor_set_t *set) {
+  VkDescriptorImageInfo texture_info = {
+    .imageLayout = image_data->layout,
+    .imageView = image_data->image_view,
+    .sampler = sampler,
+  };
+
+  return _purrr_vulkan_descriptor_acquire(renderer_data, renderer_data->texture_descriptor_set_layout, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &texture_info, NULL, set);
+}
+
+// Builds the placeholder straight from the caller's pixels, a nearest downsample is good enough
+// for something that's only shown for the few frames it takes to bring the real image back.
+static bool _purrr_texture_vulkan_stream_init(_purrr_renderer_data_t *renderer_data, _purrr_texture_t *texture, _purrr_texture_data_t *data) {
+  _purrr_image_t *image = (_purrr_image_t*)texture->info.image;
+  if (format_is_compressed(image->info.format) || image->info.format == PURRR_FORMAT_DEPTH || image->info.sample_count != PURRR_SAMPLE_COUNT_1) return false;
+
+  const uint8_t *pixels = texture->info.stream_pixels;
+  uint32_t width = image->info.width, height = image->info.height;
+  if (!_purrr_image_vulkan_load(image, (uint8_t*)pixels, width, height)) return false;
+
+  if (max(width, height) == 1) return true; // Nothing smaller to fall back to
+
+  uint32_t shift = 1;
+  while ((max(width, height)>>shift) > PURRR_VULKAN_PLACEHOLDER_SIZE) ++shift;
+
+  size_t texel_size = (size_t)format_size(image->info.format);
+
+  uint32_t placeholder_width = max(width>>shift, 1u), placeholder_height = max(height>>shift, 1u);
+  uint8_t *placeholder_pixels = (uint8_t*)malloc(texel_size*placeholder_width*placeholder_height);
+  assert(placeholder_pixels);
+  for (uint32_t y = 0; y < placeholder_height; ++y)
+    for (uint32_t x = 0; x < placeholder_width; ++x)
+      memcpy(placeholder_pixels + ((size_t)y*placeholder_width + x)*texel_size, pixels + (((size_t)y<<shift)*width + ((size_t)x<<shift))*texel_size, texel_size);
+
+  purrr_image_info_t placeholder_info = {
+    .width = placeholder_width,
+    .height = placeholder_height,
+    .format = image->info.format,
+    .sample_count = PURRR_SAMPLE_COUNT_1,
+    .mip_levels = 0,
+  };
+
+  data->placeholder = purrr_image_create(&placeholder_info, (purrr_renderer_t*)texture->renderer);
+  bool loaded = (data->placeholder && _purrr_image_vulkan_load((_purrr_image_t*)data->placeholder, placeholder_pixels, placeholder_width, placeholder_height));
+  free(placeholder_pixels);
+  if (!loaded) return false;
+
+  _purrr_image_data_t *placeholder_data = (_purrr_image_data_t*)((_purrr_image_t*)data->placeholder)->data_ptr;
+  _purrr_sampler_data_t *sampler_data = (_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr;
+  return _purrr_texture_vulkan_allocate_set(renderer_data, placeholder_data, sampler_data->sampler, &data->placeholder_set);
+}
+
+// Hands the texture over to update_residency, last thing init does so a failed init never has to take it back.
+static bool _purrr_texture_vulkan_stream_register(_purrr_renderer_data_t *renderer_data, _purrr_texture_t *texture, _purrr_texture_data_t *data) {
+  _purrr_image_t *image = (_purrr_image_t*)texture->info.image;
+  _purrr_vulkan_streamed_textures_t *streamed = &renderer_data->streamed_textures;
+  if (streamed->count >= streamed->capacity) {
+    size_t capacity = (streamed->capacity?streamed->capacity*2:4);
+    _purrr_texture_t **items = (_purrr_texture_t**)realloc(streamed->items, sizeof(*items)*capacity);
+    if (!items) return false;
+    streamed->items = items;
+    streamed->capacity = capacity;
+  }
+  streamed->items[streamed->count++] = texture;
+
+  data->size = ((_purrr_image_data_t*)image->data_ptr)->allocation.size;
+  data->resident = true;
+  data->last_used = renderer_data->frame_counter;
+  renderer_data->streamed_size += data->size;
+
+  return true;
+}
+
+static void _purrr_texture_vulkan_evict(_purrr_renderer_data_t *renderer_data, _purrr_texture_t *texture) {
+  _purrr_texture_data_t *data = (_purrr_texture_data_t*)texture->data_ptr;
+  _purrr_image_vulkan_destroy(renderer_data, (_purrr_image_data_t*)((_purrr_image_t*)texture->info.image)->data_ptr);
+  _purrr_vulkan_descriptor_release(renderer_data, &data->descriptor_set);
+  renderer_data->streamed_size -= data->size;
+  data->resident = false;
+}
+
+// Recreates the image and uploads the caller's pixels again through the staging ring, the old descriptor set was released
+// on eviction (its view is gone), so the new view gets a set of its own.
+static bool _purrr_texture_vulkan_restore(_purrr_renderer_data_t *renderer_data, _purrr_texture_t *texture) {
+  _purrr_texture_data_t *data = (_purrr_texture_data_t*)texture->data_ptr;
+  _purrr_image_t *image = (_purrr_image_t*)texture->info.image;
+  _purrr_image_data_t *image_data = (_purrr_image_data_t*)image->data_ptr;
+
+  if (!_purrr_image_vulkan_create(renderer_data, image, image_data) ||
+      !_purrr_image_vulkan_load(image, (uint8_t*)texture->info.stream_pixels, image->info.width, image->info.height)) {
+    _purrr_image_vulkan_destroy(renderer_data, image_data);
+    return false;
+  }
+
+  VkSampler sampler = ((_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr)->sampler;
+  if (!_purrr_texture_vulkan_allocate_set(renderer_data, image_data, sampler, &data->descriptor_set)) {
+    _purrr_image_vulkan_destroy(renderer_data, image_data);
+    return false;
+  }
+
+  data->size = image_data->allocation.size;
+  data->resident = true;
+  data->requested = false;
+  data->last_used = renderer_data->frame_counter;
+  renderer_data->streamed_size += data->size;
+
+  return true;
+}
+
+bool _purrr_texture_vulkan_init(_purrr_texture_t *texture) {
+  if (!texture || !texture->renderer || !texture->renderer->initialized) return false;
+  _purrr_texture_data_t *data = (_purrr_texture_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+
+  _purrr_image_data_t *image_data = (_purrr_image_data_t*)((_purrr_image_t*)texture->info.image)->data_ptr;
+
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)texture->renderer->data_ptr;
+  _purrr_sampler_data_t *sampler_data = (_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr;
+  assert(renderer_data && sampler_data);
+
+  texture->data_ptr = data;
+  if (!(image_data->usage & VK_IMAGE_USAGE_SAMPLED_BIT)) goto error;
+  data->index = PURRR_NO_TEXTURE_INDEX;
+
+  // Bindless textures can be read without ever being bound, so there's no telling when they could be evicted.
+  bool bindless = (renderer_data->bindless.count > 0);
+  if (texture->info.stream_pixels && !bindless && !_purrr_texture_vulkan_stream_init(renderer_data, texture, data)) goto error;
+
+  if (!_purrr_texture_vulkan_allocate_set(renderer_data, image_data, sampler_data->sampler, &data->descriptor_set)) goto error;
+
+  if (bindless) {
+    VkDescriptorImageInfo texture_info = {
+      .imageLayout = image_data->layout,
+      .imageView = image_data->image_view,
+      .sampler = sampler_data->sampler,
+    };
+
+    data->index = _purrr_vulkan_bindless_acquire(renderer_data, &texture_info);
+    if (data->index == PURRR_NO_TEXTURE_INDEX) goto error;
+    image_data->indirect = true;
+  }
+
+  if (data->placeholder && !_purrr_texture_vulkan_stream_register(renderer_data, texture, data)) goto error;
+
+  texture->initialized = true;
+
+  return true;
+error:
+  _purrr_vulkan_descriptor_release(renderer_data, &data->descriptor_set);
+  _purrr_vulkan_descriptor_release(renderer_data, &data->placeholder_set);
+  if (data->placeholder) purrr_image_destroy(data->placeholder);
+  free(data);
+  texture->data_ptr = NULL;
+  return false;
+}
+
+void _purrr_texture_vulkan_cleanup(_purrr_texture_t *texture) {
+  if (!texture || !texture->initialized) return;
+  assert(texture->renderer);
+  _purrr_texture_data_t *data = (_purrr_texture_data_t*)texture->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)texture->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (data->placeholder) {
+    _purrr_vulkan_streamed_textures_t *streamed = &renderer_data->streamed_textures;
+    for (size_t i = 0; i < streamed->count; ++i) {
+      if (streamed->items[i] != texture) continue;
+      streamed->items[i] = streamed->items[--streamed->count];
+      break;
+    }
+    if (data->resident) renderer_data->streamed_size -= data->size;
+    _purrr_vulkan_descriptor_release(renderer_data, &data->placeholder_set);
+    purrr_image_destroy(data->placeholder);
+  }
+  _purrr_vulkan_descriptor_release(renderer_data, &data->descriptor_set);
+  if (data->index != PURRR_NO_TEXTURE_INDEX) _purrr_vulkan_bindless_release(renderer_data, data->index);
+  free(data);
+}
+
+uint32_t _purrr_texture_vulkan_get_index(_purrr_texture_t *texture) {
+  if (!texture || !texture->initialized) return PURRR_NO_TEXTURE_INDEX;
+  return ((_purrr_texture_data_t*)texture->data_ptr)->index;
+}
+
+// pipeline compiler
+
+static void _purrr_vulkan_pipeline_job_free(_purrr_vulkan_pipeline_job_t *job) {
+  free(job->stage_infos);
+  free(job->vertex_attributes);
+  free(job->color_blend_attachments);
+  free(job->stage_feedbacks);
+  free(job);
+}
+
+// The copy points into its own arrays and state structs, without creation feedback.
+static _purrr_vulkan_pipeline_job_t *_purrr_vulkan_pipeline_job_copy(const _purrr_vulkan_pipeline_job_t *src) {
+  _purrr_vulkan_pipeline_job_t *job = (_purrr_vulkan_pipeline_job_t*)malloc(sizeof(*job));
+  assert(job);
+  *job = *src;
+  job->next = NULL;
+  job->done = false;
+  job->pipeline = VK_NULL_HANDLE;
+  memset(&job->stats, 0, sizeof(job->stats));
+
+  uint32_t stage_count = src->pipeline_info.stageCount;
+  job->stage_infos = (VkPipelineShaderStageCreateInfo*)malloc(sizeof(*job->stage_infos)*stage_count);
+  assert(job->stage_infos || stage_count == 0);
+  if (stage_count) memcpy(job->stage_infos, src->stage_infos, sizeof(*job->stage_infos)*stage_count);
+
+  uint32_t vertex_attrib_count = src->vertex_input_info.vertexAttributeDescriptionCount;
+  job->vertex_attributes = (vertex_attrib_count>0?(VkVertexInputAttributeDescription*)malloc(sizeof(*job->vertex_attributes)*vertex_attrib_count):VK_NULL_HANDLE);
+  assert(job->vertex_attributes || vertex_attrib_count == 0);
+  if (vertex_attrib_count) memcpy(job->vertex_attributes, src->vertex_attributes, sizeof(*job->vertex_attributes)*vertex_attrib_count);
+
+  uint32_t color_attachment_count = src->color_blending.attachmentCount;
+  job->color_blend_attachments = (VkPipelineColorBlendAttachmentState*)calloc(color_attachment_count, sizeof(*job->color_blend_attachments));
+  assert(job->color_blend_attachments || color_attachment_count == 0);
+  if (color_attachment_count) memcpy(job->color_blend_attachments, src->color_blend_attachments, sizeof(*job->color_blend_attachments)*color_attachment_count);
+
+  job->stage_feedbacks = NULL;
+  memset(&job->feedback_info, 0, sizeof(job->feedback_info));
+
+  job->dynamic_state.pDynamicStates = job->dynamic_states;
+  if (vertex_attrib_count > 0) {
+    job->vertex_input_info.pVertexBindingDescriptions = &job->binding_description;
+    job->vertex_input_info.pVertexAttributeDescriptions = job->vertex_attributes;
+  }
+  job->color_blending.pAttachments = job->color_blend_attachments;
+
+  job->pipeline_info.pNext = VK_NULL_HANDLE;
+  job->pipeline_info.pStages = job->stage_infos;
+  job->pipeline_info.pVertexInputState = &job->vertex_input_info;
+  job->pipeline_info.pInputAssemblyState = &job->input_assembly;
+  job->pipeline_info.pViewportState = &job->viewport_state;
+  job->pipeline_info.pRasterizationState = &job->rasterizer;
+  job->pipeline_info.pMultisampleState = &job->multisampling;
+  job->pipeline_info.pColorBlendState = &job->color_blending;
+  job->pipeline_info.pDynamicState = &job->dynamic_state;
+  if (src->pipeline_info.pDepthStencilState) job->pipeline_info.pDepthStencilState = &job->depth_stencil;
+
+  return job;
+}
+
+static void _purrr_vulkan_pipeline_job_compile(_purrr_renderer_data_t *data, _purrr_vulkan_pipeline_job_t *job) {
+  if (vkCreateGraphicsPipelines(data->device, data->pipeline_cache, 1, &job->pipeline_info, VK_NULL_HANDLE, &job->pipeline) != VK_SUCCESS) {
+    job->pipeline = VK_NULL_HANDLE;
+    return;
+  }
+
+  if (job->feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) {
+    job->stats.valid = true;
+    job->stats.cache_hit = (job->feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+    job->stats.duration = job->feedback.duration;
+  }
+}
+
+static int _purrr_vulkan_compiler_worker(void *arg) {
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)arg;
+  _purrr_vulkan_compiler_t *compiler = &data->compiler;
+
+  for (;;) {
+    mtx_lock(&compiler->mutex);
+    while (!compiler->queue_first && !compiler->stopping) cnd_wait(&compiler->work_cond, &compiler->mutex);
+    _purrr_vulkan_pipeline_job_t *job = compiler->queue_first;
+    if (!job) {
+      mtx_unlock(&compiler->mutex);
+      return 0;
+    }
+    compiler->queue_first = job->next;
+    if (!compiler->queue_first) compiler->queue_last = NULL;
+    mtx_unlock(&compiler->mutex);
+
+    // The pipeline cache is synchronized by the driver
+    _purrr_vulkan_pipeline_job_compile(data, job);
+
+    mtx_lock(&compiler->mutex);
+    job->done = true;
+    --compiler->pending;
+    cnd_broadcast(&compiler->done_cond);
+    mtx_unlock(&compiler->mutex);
+  }
+}
+
+static bool _purrr_vulkan_compiler_start(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_compiler_t *compiler = &data->compiler;
+  if (compiler->thread_count > 0) return true;
+
+  if (mtx_init(&compiler->mutex, mtx_plain) != thrd_success) return false;
+  cnd_init(&compiler->work_cond);
+  cnd_init(&compiler->done_cond);
+
+  // One core is left for the thread recording frames
+  uint32_t cpu_count = _purrr_vulkan_cpu_count();
+  uint32_t thread_count = max(cpu_count, 2u)-1;
+  compiler->threads = (thrd_t*)malloc(sizeof(*compiler->threads)*thread_count);
+  assert(compiler->threads);
+
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    if (thrd_create(&compiler->threads[i], _purrr_vulkan_compiler_worker, data) != thrd_success) break; // Fewer threads are fine
+    ++compiler->thread_count;
+  }
+
+  if (compiler->thread_count == 0) {
+    cnd_destroy(&compiler->work_cond);
+    cnd_destroy(&compiler->done_cond);
+    mtx_destroy(&compiler->mutex);
+    free(compiler->threads);
+    compiler->threads = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+static void _purrr_vulkan_compiler_queue(_purrr_renderer_data_t *data, _purrr_vulkan_pipeline_job_t *job) {
+  _purrr_vulkan_compiler_t *compiler = &data->compiler;
+  mtx_lock(&compiler->mutex);
+  if (compiler->queue_last) compiler->queue_last->next = job;
+  else compiler->queue_first = job;
+  compiler->queue_last = job;
+  ++compiler->pending;
+  cnd_signal(&compiler->work_cond);
+  mtx_unlock(&compiler->mutex);
+}
+
+// Shaders and render passes have to outlive the compiles that use them, so destroying one waits for those.
+static void _purrr_vulkan_compiler_wait_idle(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_compiler_t *compiler = &data->compiler;
+  if (compiler->thread_count == 0) return;
+  mtx_lock(&compiler->mutex);
+  while (compiler->pending > 0) cnd_wait(&compiler->done_cond, &compiler->mutex);
+  mtx_unlock(&compiler->mutex);
+}
+
+// Queued jobs are still compiled before the threads exit.
+static void _purrr_vulkan_compiler_stop(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_compiler_t *compiler = &data->compiler;
+  if (compiler->thread_count == 0) return;
+
+  mtx_lock(&compiler->mutex);
+  compiler->stopping = true;
+  cnd_broadcast(&compiler->work_cond);
+  mtx_unlock(&compiler->mutex);
+  for (uint32_t i = 0; i < compiler->thread_count; ++i) thrd_join(compiler->threads[i], NULL);
+
+  cnd_destroy(&compiler->work_cond);
+  cnd_destroy(&compiler->done_cond);
+  mtx_destroy(&compiler->mutex);
+  free(compiler->threads);
+  compiler->threads = NULL;
+  compiler->thread_count = 0;
+}
+
+// pipeline descriptor
+
+// Leaves the attachments in `final_layouts` (per attachment, in the render target's order), the defaults without them.
+// Render passes that only differ in layouts are compatible, so render targets can end in their images' layouts.
+static bool _purrr_vulkan_render_pass_create(_purrr_renderer_data_t *renderer_data, const purrr_pipeline_descriptor_info_t *info, const VkImageLayout *final_layouts, VkRenderPass *render_pass) {
+  uint8_t resolve_multiplier = info->resolve_attachments?2:1;
+  uint32_t attachment_count = (info->color_attachment_count*resolve_multiplier)+(info->depth_attachment?1:0);
+  VkAttachmentDescription *attachments = (VkAttachmentDescription*)malloc(sizeof(*attachments) * attachment_count);
+  assert(attachments);
+  VkAttachmentReference *references = (VkAttachmentReference*)malloc(sizeof(*references) * info->color_attachment_count * resolve_multiplier);
+  assert(references);
+
+  bool depth = false;
+  VkAttachmentReference depth_reference = {0};
+
+  uint32_t i = 0;
+  for (; i < info->color_attachment_count; ++i) {
+    purrr_pipeline_descriptor_attachment_info_t attachment_info = info->color_attachments[i];
+    attachments[i] = (VkAttachmentDescription){
+      0,
+      vk_format(renderer_data, attachment_info.format),
+      (VkSampleCountFlagBits)1<<attachment_info.sample_count,
+      vk_attachment_load_op(&attachment_info),
+      (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      (final_layouts?final_layouts[i]:(attachment_info.present_src?VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:((resolve_multiplier>1)?VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL))),
+    };
+
+    references[i] = (VkAttachmentReference){
+      i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+  }
+
+  if (info->resolve_attachments) {
+    for (uint32_t j = 0; j < info->color_attachment_count; ++j, ++i) {
+      purrr_pipeline_descriptor_attachment_info_t attachment_info = info->resolve_attachments[j];
+      attachments[i] = (VkAttachmentDescription){
+        0,
+        vk_format(renderer_data, attachment_info.format),
+        (VkSampleCountFlagBits)1<<attachment_info.sample_count,
+        vk_attachment_load_op(&attachment_info),
+        (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
+        VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        (final_layouts?final_layouts[i]:(attachment_info.present_src?VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)),
+      };
+
+      references[i] = (VkAttachmentReference){
+        i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+      };
+    }
+  }
+
+  if (info->depth_attachment) {
+    // After the colors and their resolves, like the render target's images and clear values
+    depth_reference.attachment = info->color_attachment_count*resolve_multiplier;
+    depth_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    purrr_pipeline_descriptor_attachment_info_t attachment_info = *info->depth_attachment;
+    attachments[depth_reference.attachment] = (VkAttachmentDescription){
+      0,
+      vk_format(renderer_data, attachment_info.format),
+      (VkSampleCountFlagBits)1<<attachment_info.sample_count,
+      vk_attachment_load_op(&attachment_info),
+      (attachment_info.store?VK_ATTACHMENT_STORE_OP_STORE:VK_ATTACHMENT_STORE_OP_DONT_CARE),
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      (final_layouts?final_layouts[depth_reference.attachment]:VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL),
+    };
+    depth = true;
+  }
+
+  VkSubpassDescription subpass = {
+    .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+    .colorAttachmentCount = info->color_attachment_count,
+    .pColorAttachments = references,
+    .pResolveAttachments = references+info->color_attachment_count,
+    .pDepthStencilAttachment = (depth?&depth_reference:NULL),
+  };
+
+  VkSubpassDependency dependency = {
+    .srcSubpass = VK_SUBPASS_EXTERNAL,
+    .dstSubpass = 0,
+    .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .srcAccessMask = 0,
+    .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+  };
+
+  if (depth) {
+    dependency.srcStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  }
+
+  VkRenderPassCreateInfo create_info = {
+    .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+    .attachmentCount = attachment_count,
+    .pAttachments = attachments,
+    .subpassCount = 1,
+    .pSubpasses = &subpass,
+    .dependencyCount = 1,
+    .pDependencies = &dependency,
+  };
+
+  bool result = (vkCreateRenderPass(renderer_data->device, &create_info, VK_NULL_HANDLE, render_pass) == VK_SUCCESS);
+  free(attachments);
+  free(references);
+  return result;
+}
+
+bool _purrr_pipeline_descriptor_vulkan_init(_purrr_pipeline_descriptor_t *pipeline_descriptor) {
+  if (!pipeline_descriptor || !pipeline_descriptor->renderer || !pipeline_descriptor->renderer->initialized) return false;
+
+  _purrr_pipeline_descriptor_data_t *data = (_purrr_pipeline_descriptor_data_t*)malloc(sizeof(*data));
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline_descriptor->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (!_purrr_vulkan_render_pass_create(renderer_data, &pipeline_descriptor->info, NULL, &data->render_pass)) goto error;
+
+  pipeline_descriptor->data_ptr = data;
+  pipeline_descriptor->initialized = true;
+
+  return true;
+error:
+  free(data);
+  return false;
+}
+
+void _purrr_pipeline_descriptor_vulkan_cleanup(_purrr_pipeline_descriptor_t *pipeline_descriptor) {
+  _purrr_pipeline_descriptor_data_t *data = (_purrr_pipeline_descriptor_data_t*)pipeline_descriptor->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline_descriptor->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  if (pipeline_descriptor->initialized) {
+    _purrr_vulkan_compiler_wait_idle(renderer_data);
+    vkDestroyRenderPass(renderer_data->device, data->render_pass, VK_NULL_HANDLE);
+  }
+  free(data);
+  pipeline_descriptor->initialized = false;
+}
+
+// shader
+
+bool _purrr_shader_vulkan_init(_purrr_shader_t *shader) {
+  if (!shader || !shader->renderer || !shader->renderer->initialized) return false;
+
+  _purrr_shader_data_t *data = (_purrr_shader_data_t*)malloc(sizeof(*data));
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)shader->renderer->data_ptr;
+  assert(data && renderer_data);
+  memset(data, 0, sizeof(*data));
+
+  if (shader->info.filename) {
+    if (shader->info.buffer) free(shader->info.buffer);
+    FILE *fd = fopen(shader->info.filename, "rb");
+    if (!fd) return VK_NULL_HANDLE;
+    fseek(fd, 0, SEEK_END);
+    shader->info.buffer_size = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    shader->info.buffer = malloc(shader->info.buffer_size);
+    assert(shader->info.buffer);
+    if ((shader->info.buffer_size % 4) != 0 || !shader->info.buffer ||
+        (fread(shader->info.buffer, shader->info.buffer_size, 1, fd) != 1)) {
+      fclose(fd);
+      free(shader->info.buffer);
+      return false;
+    }
+    fclose(fd);
+  }
+
+  VkShaderModuleCreateInfo create_info = {
+    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+    .codeSize = shader->info.buffer_size,
+    .pCode = (const uint32_t*)shader->info.buffer,
+  };
+
+  VkResult result = vkCreateShaderModule(renderer_data->device, &create_info, VK_NULL_HANDLE, &data->shader_module);
+  if (result != VK_SUCCESS) {
+    assert(false);
+  }
+
+  data->code_hash = _purrr_vulkan_hash(shader->info.buffer, shader->info.buffer_size);
+  data->code_size = shader->info.buffer_size;
+  if (renderer_data->native_dynamic_states != PURRR_VULKAN_DYNAMIC_STATES) {
+    data->code = (uint32_t*)malloc(data->code_size);
+    assert(data->code);
+    memcpy(data->code, shader->info.buffer, data->code_size);
+  }
+
+  if (shader->info.filename) free(shader->info.buffer);
+
+  shader->type = shader->info.type;
+
+  shader->initialized = true;
+  shader->data_ptr = data;
+
+  return true;
+}
+
+void _purrr_shader_vulkan_cleanup(_purrr_shader_t *shader) {
+  _purrr_shader_data_t *data = (_purrr_shader_data_t*)shader->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)shader->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  if (shader->initialized) {
+    _purrr_vulkan_compiler_wait_idle(renderer_data);
+    vkDestroyShaderModule(renderer_data->device, data->shader_module, VK_NULL_HANDLE);
+  }
+  free(data->code);
+  free(data);
+  shader->initialized = false;
+}
+
+// pipeline
+
+static VkStencilOpState _purrr_vulkan_stencil_op_state(const purrr_pipeline_stencil_t *stencil) {
+  return (VkStencilOpState){
+    .failOp = vk_stencil_op(stencil->fail_op),
+    .passOp = vk_stencil_op(stencil->pass_op),
+    .depthFailOp = vk_stencil_op(stencil->depth_fail_op),
+    .compareOp = vk_compare_op(stencil->compare_op),
+    .compareMask = stencil->compare_mask,
+    .writeMask = stencil->write_mask,
+    .reference = stencil->reference,
+  };
+}
+
+static _purrr_vulkan_dynamic_values_t _purrr_vulkan_pipeline_job_values(const _purrr_vulkan_pipeline_job_t *job) {
+  _purrr_vulkan_dynamic_values_t values = {
+    .cull_mode = job->rasterizer.cullMode,
+    .front_face = job->rasterizer.frontFace,
+    .topology = job->input_assembly.topology,
+    .polygon_mode = job->rasterizer.polygonMode,
+    .depth_test = job->depth_stencil.depthTestEnable,
+    .depth_write = job->depth_stencil.depthWriteEnable,
+    .depth_compare_op = job->depth_stencil.depthCompareOp,
+    .depth_bias = job->rasterizer.depthBiasEnable,
+    .stencil_test = job->depth_stencil.stencilTestEnable,
+  };
+  for (uint32_t i = 0; i < job->color_blending.attachmentCount && i < 32; ++i)
+    if (job->color_blend_attachments[i].blendEnable) values.blend_enables |= 1u << i;
+  return values;
+}
+
+static void _purrr_vulkan_pipeline_job_apply(_purrr_vulkan_pipeline_job_t *job, const _purrr_vulkan_dynamic_values_t *values, purrr_dynamic_state_t states) {
+  if (states & PURRR_DYNAMIC_STATE_CULL_MODE)        job->rasterizer.cullMode = values->cull_mode;
+  if (states & PURRR_DYNAMIC_STATE_FRONT_FACE)       job->rasterizer.frontFace = values->front_face;
+  if (states & PURRR_DYNAMIC_STATE_TOPOLOGY)         job->input_assembly.topology = values->topology;
+  if (states & PURRR_DYNAMIC_STATE_POLYGON_MODE)     job->rasterizer.polygonMode = values->polygon_mode;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_TEST)       job->depth_stencil.depthTestEnable = values->depth_test;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_WRITE)      job->depth_stencil.depthWriteEnable = values->depth_write;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP) job->depth_stencil.depthCompareOp = values->depth_compare_op;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_BIAS)       job->rasterizer.depthBiasEnable = values->depth_bias;
+  if (states & PURRR_DYNAMIC_STATE_STENCIL_TEST)     job->depth_stencil.stencilTestEnable = values->stencil_test;
+  if (states & PURRR_DYNAMIC_STATE_BLEND) {
+    for (uint32_t i = 0; i < job->color_blending.attachmentCount && i < 32; ++i)
+      job->color_blend_attachments[i].blendEnable = (values->blend_enables >> i) & 1;
+  }
+}
+
+// Leaves only the fields of `states`, so values can be compared by the states that matter.
+static _purrr_vulkan_dynamic_values_t _purrr_vulkan_dynamic_values_mask(const _purrr_vulkan_dynamic_values_t *values, purrr_dynamic_state_t states) {
+  _purrr_vulkan_dynamic_values_t masked = {0};
+  if (states & PURRR_DYNAMIC_STATE_CULL_MODE)        masked.cull_mode = values->cull_mode;
+  if (states & PURRR_DYNAMIC_STATE_FRONT_FACE)       masked.front_face = values->front_face;
+  if (states & PURRR_DYNAMIC_STATE_TOPOLOGY)         masked.topology = values->topology;
+  if (states & PURRR_DYNAMIC_STATE_POLYGON_MODE)     masked.polygon_mode = values->polygon_mode;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_TEST)       masked.depth_test = values->depth_test;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_WRITE)      masked.depth_write = values->depth_write;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP) masked.depth_compare_op = values->depth_compare_op;
+  if (states & PURRR_DYNAMIC_STATE_DEPTH_BIAS)       masked.depth_bias = values->depth_bias;
+  if (states & PURRR_DYNAMIC_STATE_STENCIL_TEST)     masked.stencil_test = values->stencil_test;
+  if (states & PURRR_DYNAMIC_STATE_BLEND)            masked.blend_enables = values->blend_enables;
+  return masked;
+}
+
+// Creates the pipeline layout right away, the pipeline itself is left to _purrr_vulkan_pipeline_job_compile.
+static _purrr_vulkan_pipeline_job_t *_purrr_pipeline_vulkan_prepare(_purrr_pipeline_t *pipeline, _purrr_pipeline_data_t *data) {
+  _purrr_vulkan_pipeline_job_t *job = (_purrr_vulkan_pipeline_job_t*)malloc(sizeof(*job));
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
+  _purrr_pipeline_descriptor_data_t *pipeline_descriptor_data = (_purrr_pipeline_descriptor_data_t*)((_purrr_pipeline_descriptor_t*)pipeline->info.pipeline_descriptor)->data_ptr;
+  assert(job && renderer_data && pipeline_descriptor_data);
+  memset(job, 0, sizeof(*job));
+
+  data->dynamic_states = pipeline->info.dynamic_states & PURRR_VULKAN_DYNAMIC_STATES;
+  data->baked_states = data->dynamic_states & ~renderer_data->native_dynamic_states;
+  if (data->baked_states) {
+    // The variants are created long after the user's shaders may be gone
+    data->modules = (VkShaderModule*)calloc(pipeline->info.shader_count, sizeof(*data->modules));
+    assert(data->modules || pipeline->info.shader_count == 0);
+  }
+
+  job->stage_infos = (VkPipelineShaderStageCreateInfo*)malloc(sizeof(*job->stage_infos)*pipeline->info.shader_count);
+  assert(job->stage_infos);
+  for (uint32_t i = 0; i < pipeline->info.shader_count; ++i) {
+    _purrr_shader_t *shader = (_purrr_shader_t*)pipeline->info.shaders[i];
+    _purrr_shader_data_t *shader_data = (_purrr_shader_data_t*)shader->data_ptr;
+    assert(shader->initialized);
+
+    VkShaderModule module = shader_data->shader_module;
+    if (data->modules) {
+      VkShaderModuleCreateInfo module_info = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shader_data->code_size,
+        .pCode = shader_data->code,
+      };
+      if (!shader_data->code || vkCreateShaderModule(renderer_data->device, &module_info, VK_NULL_HANDLE, &data->modules[i]) != VK_SUCCESS) goto error;
+      data->module_count = i+1;
+      module = data->modules[i];
+    }
+
+    job->stage_infos[i] = (VkPipelineShaderStageCreateInfo){
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .stage = vk_shader_stage(shader->type),
+      .module = module,
+      .pName = "main",
+    };
+  }
+
+  uint32_t dynamic_state_count = 0;
+  job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_VIEWPORT;
+  job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_SCISSOR;
+  purrr_dynamic_state_t native_states = data->dynamic_states & renderer_data->native_dynamic_states;
+  if (native_states & PURRR_DYNAMIC_STATE_CULL_MODE)        job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_CULL_MODE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_FRONT_FACE)       job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_FRONT_FACE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_TOPOLOGY)         job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_POLYGON_MODE)     job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_POLYGON_MODE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_DEPTH_TEST)       job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_DEPTH_WRITE)      job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP) job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_DEPTH_BIAS)       job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_STENCIL_TEST)     job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT;
+  if (native_states & PURRR_DYNAMIC_STATE_BLEND)            job->dynamic_states[dynamic_state_count++] = VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT;
+
+  job->dynamic_state = (VkPipelineDynamicStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+    .dynamicStateCount = dynamic_state_count,
+    .pDynamicStates = job->dynamic_states,
+  };
+
+  uint32_t vertex_attrib_count = pipeline->info.mesh_info.vertex_info_count;
+  job->vertex_input_info = (VkPipelineVertexInputStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    .vertexBindingDescriptionCount = 0,
+    .pVertexBindingDescriptions = VK_NULL_HANDLE,
+    .vertexAttributeDescriptionCount = vertex_attrib_count,
+    .pVertexAttributeDescriptions = VK_NULL_HANDLE,
+  };
+
+  job->vertex_attributes = (vertex_attrib_count>0?(VkVertexInputAttributeDescription*)malloc(sizeof(*job->vertex_attributes)*vertex_attrib_count):VK_NULL_HANDLE);
+  assert(job->vertex_attributes || vertex_attrib_count == 0);
+  uint32_t vertex_size = 0;
+  for (uint32_t i = 0; i < vertex_attrib_count; ++i) {
+    purrr_vertex_info_t info = pipeline->info.mesh_info.vertex_infos[i];
+    vertex_size += info.size;
+    job->vertex_attributes[i].location = i;
+    job->vertex_attributes[i].binding = 0;
+    job->vertex_attributes[i].format = vk_format(renderer_data, info.format);
+    job->vertex_attributes[i].offset = info.offset;
+  }
+
+  job->binding_description = (VkVertexInputBindingDescription){
+    .binding = 0,
+    .stride = vertex_size,
+    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+  };
+
+  if (vertex_attrib_count > 0) {
+    job->vertex_input_info.vertexBindingDescriptionCount = 1;
+    job->vertex_input_info.pVertexBindingDescriptions = &job->binding_description;
+    job->vertex_input_info.pVertexAttributeDescriptions = job->vertex_attributes;
+  }
+
+  job->viewport_state = (VkPipelineViewportStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+    .viewportCount = 1,
+    .scissorCount = 1,
+  };
+
+  // Without a state block it's what pipelines always did
+  static const purrr_pipeline_blend_t alpha_blend = {
+    .enable = true,
+    .src_color = PURRR_BLEND_FACTOR_SRC_ALPHA,
+    .dst_color = PURRR_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    .color_op = PURRR_BLEND_OP_ADD,
+    .src_alpha = PURRR_BLEND_FACTOR_ONE,
+    .dst_alpha = PURRR_BLEND_FACTOR_ZERO,
+    .alpha_op = PURRR_BLEND_OP_ADD,
+  };
+  static const purrr_pipeline_state_t default_state = {
+    .depth_test = true,
+    .depth_write = true,
+  };
+  const purrr_pipeline_state_t *state = (pipeline->info.state?pipeline->info.state:&default_state);
+  const purrr_pipeline_descriptor_info_t *descriptor_info = &((_purrr_pipeline_descriptor_t*)pipeline->info.pipeline_descriptor)->info;
+
+  if (state->polygon_mode != PURRR_POLYGON_MODE_FILL && !renderer_data->features.fillModeNonSolid) goto error;
+  if (state->depth_bias && state->depth_bias_clamp != 0.0f && !renderer_data->features.depthBiasClamp) goto error;
+
+  job->input_assembly = (VkPipelineInputAssemblyStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+    .topology = vk_primitive_topology(state->topology),
+    .primitiveRestartEnable = VK_FALSE,
+  };
+
+  job->rasterizer = (VkPipelineRasterizationStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+    .depthClampEnable = VK_FALSE,
+    .rasterizerDiscardEnable = VK_FALSE,
+    .polygonMode = vk_polygon_mode(state->polygon_mode),
+    .lineWidth = 1.0f,
+    .cullMode = vk_cull_mode(state->cull_mode),
+    .frontFace = vk_front_face(state->front_face),
+    .depthBiasEnable = state->depth_bias,
+    .depthBiasConstantFactor = state->depth_bias_constant,
+    .depthBiasSlopeFactor = state->depth_bias_slope,
+    .depthBiasClamp = state->depth_bias_clamp,
+  };
+
+  job->multisampling = (VkPipelineMultisampleStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+    .sampleShadingEnable = VK_FALSE,
+    .rasterizationSamples = (VkSampleCountFlagBits)1<<pipeline->info.sample_count,
+  };
+
+  uint32_t color_attachment_count = descriptor_info->color_attachment_count;
+  job->color_blend_attachments = (VkPipelineColorBlendAttachmentState*)calloc(color_attachment_count, sizeof(*job->color_blend_attachments));
+  assert(job->color_blend_attachments || color_attachment_count == 0);
+  for (uint32_t i = 0; i < color_attachment_count; ++i) {
+    const purrr_pipeline_blend_t *blend = (pipeline->info.state?(state->blends?&state->blends[i]:NULL):&alpha_blend);
+    job->color_blend_attachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (!blend) continue;
+    if (i < 32) data->blend_attachments |= 1u << i;
+    job->color_blend_attachments[i].blendEnable = blend->enable;
+    job->color_blend_attachments[i].srcColorBlendFactor = vk_blend_factor(blend->src_color);
+    job->color_blend_attachments[i].dstColorBlendFactor = vk_blend_factor(blend->dst_color);
+    job->color_blend_attachments[i].colorBlendOp = vk_blend_op(blend->color_op);
+    job->color_blend_attachments[i].srcAlphaBlendFactor = vk_blend_factor(blend->src_alpha);
+    job->color_blend_attachments[i].dstAlphaBlendFactor = vk_blend_factor(blend->dst_alpha);
+    job->color_blend_attachments[i].alphaBlendOp = vk_blend_op(blend->alpha_op);
+    if (i > 0 && !renderer_data->features.independentBlend &&
+        memcmp(&job->color_blend_attachments[i], &job->color_blend_attachments[0], sizeof(*job->color_blend_attachments)) != 0) goto error;
+  }
+
+  job->color_blending = (VkPipelineColorBlendStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+    .logicOpEnable = VK_FALSE,
+    .attachmentCount = color_attachment_count,
+    .pAttachments = job->color_blend_attachments,
+  };
+
+  job->depth_stencil = (VkPipelineDepthStencilStateCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+    .depthTestEnable = state->depth_test,
+    .depthWriteEnable = state->depth_write,
+    .depthCompareOp = vk_compare_op(state->depth_compare_op),
+    .depthBoundsTestEnable = VK_FALSE,
+    .minDepthBounds = 0.0f,
+    .maxDepthBounds = 1.0f,
+    .stencilTestEnable = state->stencil_test,
+    .front = _purrr_vulkan_stencil_op_state(&state->stencil_front),
+    .back = _purrr_vulkan_stencil_op_state(&state->stencil_back),
+  };
+
+  uint32_t set_count = pipeline->info.descriptor_slot_count + pipeline->info.descriptor_set_count;
+  VkDescriptorSetLayout *layouts = (VkDescriptorSetLayout*)malloc(sizeof(*layouts)*set_count);
+  assert(layouts || set_count == 0);
+  data->push_set = UINT32_MAX;
+  if (pipeline->info.descriptor_slot_count < 32 && (pipeline->info.push_descriptor_slots >> pipeline->info.descriptor_slot_count)) {
+    free(layouts);
+    goto error;
+  }
+  for (uint32_t i = 0; i < pipeline->info.descriptor_slot_count; ++i) {
+    if (i < 32 && ((pipeline->info.push_descriptor_slots >> i) & 1)) {
+      // A pipeline layout can only have one push descriptor set, the other push slots get sets that live for the frame.
+      bool push = (data->push_set == UINT32_MAX && renderer_data->cmd_push_descriptor_set);
+      const _purrr_vulkan_set_layout_t *set_layout = _purrr_vulkan_set_layout_get(renderer_data, &pipeline->info.descriptor_slots[i], 1, push);
+      if (!set_layout) {
+        free(layouts);
+        goto error;
+      }
+      if (push) data->push_set = i;
+      data->push_slots |= 1u << i;
+      layouts[i] = set_layout->layout;
+      continue;
+    }
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    switch (pipeline->info.descriptor_slots[i]) {
+    case PURRR_DESCRIPTOR_TYPE_TEXTURE:
+      layout = renderer_data->texture_descriptor_set_layout;
+      break;
+    case PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      layout = renderer_data->uniform_descriptor_set_layout;
+      break;
+    case PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      layout = renderer_data->storage_descriptor_set_layout;
+      break;
+    case PURRR_DESCRIPTOR_TYPE_TEXTURE_ARRAY: {
+      if (!renderer_data->bindless.count || i >= 32) {
+        free(layouts);
+        goto error;
+      }
+      layout = renderer_data->bindless.layout;
+      data->texture_array_slots |= 1u << i;
+    } break;
+    case COUNT_PURRR_DESCRIPTOR_TYPES: {
+      assert(0 && "Unreachable");
+      free(layouts);
+      goto error;
+    }
+    }
+    layouts[i] = layout;
+  }
+
+  for (uint32_t i = 0; i < pipeline->info.descriptor_set_count; ++i) {
+    const purrr_descriptor_set_info_t *set_info = &pipeline->info.descriptor_sets[i];
+    const _purrr_vulkan_set_layout_t *set_layout = _purrr_vulkan_set_layout_get(renderer_data, set_info->bindings, set_info->binding_count, false);
+    if (!set_layout) {
+      free(layouts);
+      goto error;
+    }
+    layouts[pipeline->info.descriptor_slot_count + i] = set_layout->layout;
+  }
+  data->set_layouts = layouts;
+  data->set_layout_count = set_count;
+
+  VkPushConstantRange *pc_ranges = (VkPushConstantRange*)malloc(sizeof(*pc_ranges)*pipeline->info.push_constant_count);
+  assert(pc_ranges);
+  for (size_t i = 0; i < pipeline->info.push_constant_count; ++i) {
+    pc_ranges[i] = (VkPushConstantRange){
+      .stageFlags = VK_SHADER_STAGE_ALL,
+      .offset = pipeline->info.push_constants[i].offset,
+      .size = pipeline->info.push_constants[i].size,
+    };
+  }
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    .pSetLayouts = layouts,
+    .setLayoutCount = set_count,
+    .pPushConstantRanges = pc_ranges,
+    .pushConstantRangeCount = pipeline->info.push_constant_count,
+  };
+
+  VkResult result = vkCreatePipelineLayout(renderer_data->device, &pipeline_layout_info, VK_NULL_HANDLE, &data->pipeline_layout);
+  free(pc_ranges);
+  if (result != VK_SUCCESS) goto error;
+
+  job->pipeline_info = (VkGraphicsPipelineCreateInfo){
+    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+    .stageCount = pipeline->info.shader_count,
+    .pStages = job->stage_infos,
+    .pVertexInputState = &job->vertex_input_info,
+    .pInputAssemblyState = &job->input_assembly,
+    .pViewportState = &job->viewport_state,
+    .pRasterizationState = &job->rasterizer,
+    .pMultisampleState = &job->multisampling,
+    .pColorBlendState = &job->color_blending,
+    .pDynamicState = &job->dynamic_state,
+    .layout = data->pipeline_layout,
+    .renderPass = pipeline_descriptor_data->render_pass,
+    .subpass = 0,
+  };
+  if (descriptor_info->depth_attachment) job->pipeline_info.pDepthStencilState = &job->depth_stencil;
+
+  job->stage_feedbacks = (VkPipelineCreationFeedbackEXT*)calloc(pipeline->info.shader_count, sizeof(*job->stage_feedbacks));
+  assert(job->stage_feedbacks || pipeline->info.shader_count == 0);
+  job->feedback_info = (VkPipelineCreationFeedbackCreateInfoEXT){
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT,
+    .pPipelineCreationFeedback = &job->feedback,
+    .pipelineStageCreationFeedbackCount = pipeline->info.shader_count,
+    .pPipelineStageCreationFeedbacks = job->stage_feedbacks,
+  };
+  if (renderer_data->creation_feedback) job->pipeline_info.pNext = &job->feedback_info;
+
+  data->values = _purrr_vulkan_pipeline_job_values(job);
+  data->color_attachment_count = color_attachment_count;
+
+  return job;
+error:
+  _purrr_vulkan_pipeline_job_free(job);
+  return NULL;
+}
+
+// Takes the results of the data's job if it has one, returns false if the pipeline couldn't be compiled.
+static bool _purrr_pipeline_vulkan_finish(_purrr_pipeline_data_t *data) {
+  if (data->job) {
+    data->pipeline = data->job->pipeline;
+    data->stats = data->job->stats;
+    if (data->baked_states && data->pipeline) data->variant_job = data->job;
+    else _purrr_vulkan_pipeline_job_free(data->job);
+    data->job = NULL;
+  }
+  return data->pipeline != VK_NULL_HANDLE;
+}
+
+static bool _purrr_pipeline_vulkan_ready(_purrr_renderer_data_t *renderer_data, _purrr_pipeline_data_t *data) {
+  if (data->job) {
+    mtx_lock(&renderer_data->compiler.mutex);
+    bool done = data->job->done;
+    mtx_unlock(&renderer_data->compiler.mutex);
+    if (!done) return false;
+  }
+  return _purrr_pipeline_vulkan_finish(data);
+}
+
+static void _purrr_pipeline_vulkan_variant_finish(_purrr_vulkan_pipeline_variant_t *variant) {
+  variant->pipeline = variant->job->pipeline;
+  _purrr_vulkan_pipeline_job_free(variant->job);
+  variant->job = NULL;
+}
+
+// Waits for the variants as well, so the data can be destroyed after.
+static bool _purrr_pipeline_vulkan_wait(_purrr_renderer_data_t *renderer_data, _purrr_pipeline_data_t *data) {
+  if (data->job) {
+    mtx_lock(&renderer_data->compiler.mutex);
+    while (!data->job->done) cnd_wait(&renderer_data->compiler.done_cond, &renderer_data->compiler.mutex);
+    mtx_unlock(&renderer_data->compiler.mutex);
+  }
+  for (size_t i = 0; i < data->variants.count; ++i) {
+    _purrr_vulkan_pipeline_variant_t *variant = &data->variants.items[i];
+    if (!variant->job) continue;
+    mtx_lock(&renderer_data->compiler.mutex);
+    while (!variant->job->done) cnd_wait(&renderer_data->compiler.done_cond, &renderer_data->compiler.mutex);
+    mtx_unlock(&renderer_data->compiler.mutex);
+    _purrr_pipeline_vulkan_variant_finish(variant);
+  }
+  return _purrr_pipeline_vulkan_finish(data);
+}
+
+static void _purrr_vulkan_key_append(_purrr_vulkan_pipeline_key_t *key, const void *bytes, size_t size) {
+  if (key->count+size > key->capacity) {
+    size_t capacity = (key->capacity?key->capacity*2:64);
+    while (capacity < key->count+size) capacity *= 2;
+    key->items = (uint8_t*)realloc(key->items, capacity);
+    assert(key->items);
+    key->capacity = capacity;
+  }
+  memcpy(key->items+key->count, bytes, size);
+  key->count += size;
+}
+
+static void _purrr_vulkan_key_u32(_purrr_vulkan_pipeline_key_t *key, uint32_t value) {
+  _purrr_vulkan_key_append(key, &value, sizeof(value));
+}
+
+static void _purrr_vulkan_key_attachment(_purrr_vulkan_pipeline_key_t *key, const purrr_pipeline_descriptor_attachment_info_t *attachment) {
+  _purrr_vulkan_key_u32(key, attachment != NULL);
+  if (!attachment) return;
+  _purrr_vulkan_key_u32(key, attachment->format);
+  _purrr_vulkan_key_u32(key, attachment->sample_count);
+}
+
+// Everything the VkPipeline is created from, field by field so padding never ends up in it.
+// The render pass only counts by its compatibility (attachment formats and samples), like it does for Vulkan.
+// The fixed-function state goes last, it's only there if the pipeline has a state block.
+static void _purrr_pipeline_vulkan_build_key(_purrr_pipeline_t *pipeline, _purrr_vulkan_pipeline_key_t *key) {
+  const purrr_pipeline_info_t *info = &pipeline->info;
+
+  _purrr_vulkan_key_u32(key, info->shader_count);
+  for (uint32_t i = 0; i < info->shader_count; ++i) {
+    _purrr_shader_t *shader = (_purrr_shader_t*)info->shaders[i];
+    _purrr_shader_data_t *shader_data = (_purrr_shader_data_t*)shader->data_ptr;
+    _purrr_vulkan_key_u32(key, shader->type);
+    _purrr_vulkan_key_append(key, &shader_data->code_hash, sizeof(shader_data->code_hash));
+    _purrr_vulkan_key_append(key, &shader_data->code_size, sizeof(shader_data->code_size));
+  }
+
+  _purrr_vulkan_key_u32(key, info->mesh_info.vertex_info_count);
+  for (uint32_t i = 0; i < info->mesh_info.vertex_info_count; ++i) {
+    _purrr_vulkan_key_u32(key, info->mesh_info.vertex_infos[i].format);
+    _purrr_vulkan_key_u32(key, info->mesh_info.vertex_infos[i].size);
+    _purrr_vulkan_key_u32(key, info->mesh_info.vertex_infos[i].offset);
+  }
+
+  _purrr_vulkan_key_u32(key, info->descriptor_slot_count);
+  for (uint32_t i = 0; i < info->descriptor_slot_count; ++i) _purrr_vulkan_key_u32(key, info->descriptor_slots[i]);
+  _purrr_vulkan_key_u32(key, info->push_descriptor_slots);
+
+  _purrr_vulkan_key_u32(key, info->descriptor_set_count);
+  for (uint32_t i = 0; i < info->descriptor_set_count; ++i) {
+    _purrr_vulkan_key_u32(key, info->descriptor_sets[i].binding_count);
+    for (uint32_t j = 0; j < info->descriptor_sets[i].binding_count; ++j) _purrr_vulkan_key_u32(key, info->descriptor_sets[i].bindings[j]);
+  }
+
+  _purrr_vulkan_key_u32(key, info->push_constant_count);
+  for (uint32_t i = 0; i < info->push_constant_count; ++i) {
+    _purrr_vulkan_key_u32(key, info->push_constants[i].offset);
+    _purrr_vulkan_key_u32(key, info->push_constants[i].size);
+  }
+
+  _purrr_vulkan_key_u32(key, info->sample_count);
+  _purrr_vulkan_key_u32(key, info->dynamic_states);
+
+  const purrr_pipeline_descriptor_info_t *descriptor_info = &((_purrr_pipeline_descriptor_t*)info->pipeline_descriptor)->info;
+  _purrr_vulkan_key_u32(key, descriptor_info->color_attachment_count);
+  for (uint32_t i = 0; i < descriptor_info->color_attachment_count; ++i) {
+    _purrr_vulkan_key_attachment(key, &descriptor_info->color_attachments[i]);
+    _purrr_vulkan_key_attachment(key, (descriptor_info->resolve_attachments?&descriptor_info->resolve_attachments[i]:NULL));
+  }
+  _purrr_vulkan_key_attachment(key, descriptor_info->depth_attachment);
+
+  const purrr_pipeline_state_t *state = info->state;
+  _purrr_vulkan_key_u32(key, state != NULL);
+  if (!state) return;
+  _purrr_vulkan_key_u32(key, state->topology);
+  _purrr_vulkan_key_u32(key, state->cull_mode);
+  _purrr_vulkan_key_u32(key, state->front_face);
+  _purrr_vulkan_key_u32(key, state->polygon_mode);
+
+  _purrr_vulkan_key_u32(key, state->blends != NULL);
+  for (uint32_t i = 0; state->blends && i < descriptor_info->color_attachment_count; ++i) {
+    const purrr_pipeline_blend_t *blend = &state->blends[i];
+    _purrr_vulkan_key_u32(key, blend->enable);
+    _purrr_vulkan_key_u32(key, blend->src_color);
+    _purrr_vulkan_key_u32(key, blend->dst_color);
+    _purrr_vulkan_key_u32(key, blend->color_op);
+    _purrr_vulkan_key_u32(key, blend->src_alpha);
+    _purrr_vulkan_key_u32(key, blend->dst_alpha);
+    _purrr_vulkan_key_u32(key, blend->alpha_op);
+  }
+
+  _purrr_vulkan_key_u32(key, state->depth_test);
+  _purrr_vulkan_key_u32(key, state->depth_write);
+  _purrr_vulkan_key_u32(key, state->depth_compare_op);
+
+  _purrr_vulkan_key_u32(key, state->depth_bias);
+  _purrr_vulkan_key_append(key, &state->depth_bias_constant, sizeof(state->depth_bias_constant));
+  _purrr_vulkan_key_append(key, &state->depth_bias_slope, sizeof(state->depth_bias_slope));
+  _purrr_vulkan_key_append(key, &state->depth_bias_clamp, sizeof(state->depth_bias_clamp));
+
+  _purrr_vulkan_key_u32(key, state->stencil_test);
+  const purrr_pipeline_stencil_t *stencils[2] = { &state->stencil_front, &state->stencil_back };
+  for (uint32_t i = 0; i < 2; ++i) {
+    _purrr_vulkan_key_u32(key, stencils[i]->fail_op);
+    _purrr_vulkan_key_u32(key, stencils[i]->pass_op);
+    _purrr_vulkan_key_u32(key, stencils[i]->depth_fail_op);
+    _purrr_vulkan_key_u32(key, stencils[i]->compare_op);
+    _purrr_vulkan_key_u32(key, stencils[i]->compare_mask);
+    _purrr_vulkan_key_u32(key, stencils[i]->write_mask);
+    _purrr_vulkan_key_u32(key, stencils[i]->reference);
+  }
+}
+
+// The data must not have a job in the compiler queue.
+static void _purrr_pipeline_vulkan_destroy_data(_purrr_renderer_data_t *renderer_data, _purrr_pipeline_data_t *data) {
+  if (data->pipeline) vkDestroyPipeline(renderer_data->device, data->pipeline, VK_NULL_HANDLE);
+  for (size_t i = 0; i < data->variants.count; ++i) {
+    if (data->variants.items[i].pipeline) vkDestroyPipeline(renderer_data->device, data->variants.items[i].pipeline, VK_NULL_HANDLE);
+    if (data->variants.items[i].job) _purrr_vulkan_pipeline_job_free(data->variants.items[i].job);
+  }
+  free(data->variants.items);
+  if (data->pipeline_layout) vkDestroyPipelineLayout(renderer_data->device, data->pipeline_layout, VK_NULL_HANDLE);
+  for (uint32_t i = 0; i < data->module_count; ++i) vkDestroyShaderModule(renderer_data->device, data->modules[i], VK_NULL_HANDLE);
+  free(data->modules);
+  if (data->variant_job) _purrr_vulkan_pipeline_job_free(data->variant_job);
+  if (data->job) _purrr_vulkan_pipeline_job_free(data->job);
+  free(data->set_layouts);
+  free(data->key);
+  free(data);
+}
+
+// Gets the pipeline to draw with for the values of the data's baked states, returns false if it couldn't be created.
+// New combinations are queued on the compiler the first time they're used, `pipeline` is VK_NULL_HANDLE until they're done.
+static bool _purrr_pipeline_vulkan_variant(_purrr_renderer_data_t *renderer_data, _purrr_pipeline_data_t *data, const _purrr_vulkan_dynamic_values_t *values, VkPipeline *pipeline) {
+  _purrr_vulkan_dynamic_values_t masked = _purrr_vulkan_dynamic_values_mask(values, data->baked_states);
+  _purrr_vulkan_dynamic_values_t base = _purrr_vulkan_dynamic_values_mask(&data->values, data->baked_states);
+  if (memcmp(&masked, &base, sizeof(masked)) == 0) {
+    *pipeline = data->pipeline;
+    return true;
+  }
+
+  _purrr_vulkan_pipeline_variants_t *variants = &data->variants;
+  for (size_t i = 0; i < variants->count; ++i) {
+    _purrr_vulkan_pipeline_variant_t *variant = &variants->items[i];
+    if (memcmp(&variant->values, &masked, sizeof(masked)) != 0) continue;
+    if (variant->job) {
+      mtx_lock(&renderer_data->compiler.mutex);
+      bool done = variant->job->done;
+      mtx_unlock(&renderer_data->compiler.mutex);
+      if (!done) {
+        *pipeline = VK_NULL_HANDLE;
+        return true;
+      }
+      _purrr_pipeline_vulkan_variant_finish(variant);
+    }
+    *pipeline = variant->pipeline;
+    return variant->pipeline != VK_NULL_HANDLE;
+  }
+
+  if (!data->variant_job) return false;
+  _purrr_vulkan_pipeline_job_t *job = _purrr_vulkan_pipeline_job_copy(data->variant_job);
+  _purrr_vulkan_pipeline_job_apply(job, &masked, data->baked_states);
+
+  if (variants->count >= variants->capacity) {
+    variants->capacity = (variants->capacity?variants->capacity*2:4);
+    variants->items = (_purrr_vulkan_pipeline_variant_t*)realloc(variants->items, sizeof(*variants->items)*variants->capacity);
+    assert(variants->items);
+  }
+  _purrr_vulkan_pipeline_variant_t *variant = &variants->items[variants->count++];
+  *variant = (_purrr_vulkan_pipeline_variant_t){
+    .values = masked,
+    .pipeline = VK_NULL_HANDLE,
+    .job = job,
+  };
+
+  if (_purrr_vulkan_compiler_start(renderer_data)) {
+    _purrr_vulkan_compiler_queue(renderer_data, job);
+    *pipeline = VK_NULL_HANDLE;
+    return true;
+  }
+
+  // Compiled right here instead
+  _purrr_vulkan_pipeline_job_compile(renderer_data, job);
+  _purrr_pipeline_vulkan_variant_finish(variant);
+  *pipeline = variant->pipeline;
+  return variant->pipeline != VK_NULL_HANDLE;
+}
+
+static bool _purrr_pipeline_vulkan_create(_purrr_pipeline_t *pipeline, bool async) {
+  if (!pipeline || !pipeline->renderer || !pipeline->renderer->initialized) return false;
+
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
+  assert(renderer_data);
+
+  _purrr_vulkan_pipeline_key_t key = {0};
+  _purrr_pipeline_vulkan_build_key(pipeline, &key);
+  uint64_t hash = _purrr_vulkan_hash(key.items, key.count);
+
+  for (size_t i = 0; i < renderer_data->pipelines.count; ++i) {
+    _purrr_pipeline_data_t *shared = renderer_data->pipelines.items[i];
+    if (shared->hash != hash || shared->key_size != key.count || memcmp(shared->key, key.items, key.count) != 0) continue;
+    free(key.items);
+    // purrr_pipeline_create can't return a pipeline that's still compiling
+    if (!async && !_purrr_pipeline_vulkan_wait(renderer_data, shared)) return false;
+    ++shared->references;
+    pipeline->data_ptr = shared;
+    pipeline->initialized = true;
+    return true;
+  }
+
+  if (async && !_purrr_vulkan_compiler_start(renderer_data)) async = false; // Compiled right here instead
+
+  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+
+  _purrr_vulkan_pipeline_job_t *job = _purrr_pipeline_vulkan_prepare(pipeline, data);
+  if (!job) {
+    _purrr_pipeline_vulkan_destroy_data(renderer_data, data);
+    free(key.items);
+    return false;
+  }
+  data->job = job;
+
+  if (async) _purrr_vulkan_compiler_queue(renderer_data, job);
+  else {
+    _purrr_vulkan_pipeline_job_compile(renderer_data, job);
+    if (!_purrr_pipeline_vulkan_finish(data)) {
+      _purrr_pipeline_vulkan_destroy_data(renderer_data, data);
+      free(key.items);
+      return false;
+    }
+  }
+
+  data->hash = hash;
+  data->key = key.items;
+  data->key_size = key.count;
+  data->references = 1;
+
+  _purrr_vulkan_pipelines_t *pipelines = &renderer_data->pipelines;
+  if (pipelines->count >= pipelines->capacity) {
+    pipelines->capacity = (pipelines->capacity?pipelines->capacity*2:4);
+    pipelines->items = (_purrr_pipeline_data_t**)realloc(pipelines->items, sizeof(*pipelines->items)*pipelines->capacity);
+    assert(pipelines->items);
+  }
+  pipelines->items[pipelines->count++] = data;
+
+  pipeline->data_ptr = data;
+  pipeline->initialized = true;
+
+  return true;
+}
+
+bool _purrr_pipeline_vulkan_init(_purrr_pipeline_t *pipeline) {
+  return _purrr_pipeline_vulkan_create(pipeline, false);
+}
+
+bool _purrr_pipeline_vulkan_init_async(_purrr_pipeline_t *pipeline) {
+  return _purrr_pipeline_vulkan_create(pipeline, true);
+}
+
+void _purrr_pipeline_vulkan_cleanup(_purrr_pipeline_t *pipeline) {
+  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)pipeline->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  pipeline->data_ptr = NULL;
+  pipeline->initialized = false;
+  if (--data->references > 0) return;
+
+  _purrr_vulkan_pipelines_t *pipelines = &renderer_data->pipelines;
+  for (size_t i = 0; i < pipelines->count; ++i) {
+    if (pipelines->items[i] != data) continue;
+    pipelines->items[i] = pipelines->items[--pipelines->count];
+    break;
+  }
+
+  _purrr_pipeline_vulkan_wait(renderer_data, data);
+  _purrr_pipeline_vulkan_destroy_data(renderer_data, data);
+}
+
+bool _purrr_pipeline_vulkan_get_stats(_purrr_pipeline_t *pipeline, purrr_pipeline_stats_t *stats) {
+  if (!pipeline || !pipeline->initialized || !stats) return false;
+  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)pipeline->data_ptr;
   _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
+  assert(data && renderer_data);
+  _purrr_pipeline_vulkan_ready(renderer_data, data);
+  *stats = data->stats;
+  return data->stats.valid;
+}
+
+bool _purrr_pipeline_vulkan_is_ready(_purrr_pipeline_t *pipeline) {
+  if (!pipeline || !pipeline->initialized) return false;
+  _purrr_pipeline_data_t *data = (_purrr_pipeline_data_t*)pipeline->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)pipeline->renderer->data_ptr;
+  assert(data && renderer_data);
+  return _purrr_pipeline_vulkan_ready(renderer_data, data);
+}
+
+// descriptor set
+
+bool _purrr_descriptor_set_vulkan_init(_purrr_descriptor_set_t *set) {
+  if (!set || !set->renderer || !set->renderer->initialized) return false;
+
+  _purrr_descriptor_set_data_t *data = (_purrr_descriptor_set_data_t*)malloc(sizeof(*data));
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)set->renderer->data_ptr;
+  assert(data && renderer_data);
+  memset(data, 0, sizeof(*data));
+
+  data->layout = _purrr_vulkan_set_layout_get(renderer_data, set->info.bindings, set->info.binding_count, false);
+  if (!data->layout) {
+    free(data);
+    return false;
+  }
+
+  data->infos = (_purrr_vulkan_descriptor_info_t*)malloc(sizeof(*data->infos)*data->layout->binding_count);
+  assert(data->infos);
+
+  set->info.bindings = NULL; // The layout keeps its own copy
+  set->data_ptr = data;
+
+  return true;
+}
+
+void _purrr_descriptor_set_vulkan_cleanup(_purrr_descriptor_set_t *set) {
+  _purrr_descriptor_set_data_t *data = (_purrr_descriptor_set_data_t*)set->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)set->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  if (data->set) _purrr_vulkan_descriptor_retire(renderer_data, data->set, data->pool);
+  free(data->infos);
+  free(data);
+  set->data_ptr = NULL;
+  set->initialized = false;
+}
+
+static bool _purrr_descriptor_set_vulkan_fill(_purrr_renderer_data_t *renderer_data, purrr_descriptor_type_t type, const purrr_descriptor_write_t *write, _purrr_vulkan_descriptor_info_t *info) {
+  switch (type) {
+  case PURRR_DESCRIPTOR_TYPE_TEXTURE: {
+    _purrr_texture_t *texture = (_purrr_texture_t*)write->texture;
+    if (!texture || !texture->initialized) return false;
+    if (((_purrr_texture_data_t*)texture->data_ptr)->placeholder) return false; // Its image view comes and goes
+    _purrr_image_data_t *image_data = (_purrr_image_data_t*)((_purrr_image_t*)texture->info.image)->data_ptr;
+    _purrr_sampler_data_t *sampler_data = (_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr;
+    image_data->indirect = true;
+
+    info->image = (VkDescriptorImageInfo){
+      .sampler = sampler_data->sampler,
+      .imageView = image_data->image_view,
+      .imageLayout = image_data->layout,
+    };
+  } return true;
+  case PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+    bool uniform = (type == PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    _purrr_buffer_t *buffer = (_purrr_buffer_t*)write->buffer;
+    if (!buffer || !buffer->initialized || buffer->info.type != (uniform?PURRR_BUFFER_TYPE_UNIFORM:PURRR_BUFFER_TYPE_STORAGE) || write->offset >= buffer->info.size) return false;
+    uint32_t size = (write->size?write->size:buffer->info.size-write->offset);
+    VkDeviceSize alignment = (uniform?renderer_data->uniform_offset_alignment:renderer_data->storage_offset_alignment);
+    VkDeviceSize max_range = (uniform?renderer_data->uniform_max_range:renderer_data->storage_max_range);
+    if ((uint64_t)write->offset + size > buffer->info.size || write->offset % alignment || size > max_range) return false;
+
+    info->buffer = (VkDescriptorBufferInfo){
+      .buffer = ((_purrr_buffer_data_t*)buffer->data_ptr)->buffer,
+      .offset = write->offset,
+      .range = size,
+    };
+  } return true;
+  case PURRR_DESCRIPTOR_TYPE_TEXTURE_ARRAY:
+  case COUNT_PURRR_DESCRIPTOR_TYPES:
+  default: return false;
+  }
+}
+
+bool _purrr_descriptor_set_vulkan_write(_purrr_descriptor_set_t *set, const purrr_descriptor_write_t *writes) {
+  if (!set || !set->initialized || !writes) return false;
+  _purrr_descriptor_set_data_t *data = (_purrr_descriptor_set_data_t*)set->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)set->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  const _purrr_vulkan_set_layout_t *layout = data->layout;
+  for (uint32_t i = 0; i < layout->binding_count; ++i)
+    if (!_purrr_descriptor_set_vulkan_fill(renderer_data, layout->bindings[i], &writes[i], &data->infos[i])) return false;
+
+  // A frame in flight might still read the current set, so it's swapped for a new one instead of being updated.
+  if (data->set && data->bound && data->last_bound+2 > renderer_data->frame_counter) {
+    _purrr_vulkan_descriptor_retire(renderer_data, data->set, data->pool);
+    data->set = VK_NULL_HANDLE;
+  }
+  if (!data->set && !_purrr_vulkan_descriptor_allocate(renderer_data, layout->layout, &data->set, &data->pool)) return false;
+  data->bound = false;
+
+  _purrr_vulkan_set_layout_update(renderer_data, layout, data->set, data->infos);
+
+  return true;
+}
+
+// render target
+
+bool _purrr_render_target_vulkan_init(_purrr_render_target_t *render_target) {
+  if (!render_target || !render_target->renderer || !render_target->renderer->initialized) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)render_target->renderer->data_ptr;
+  _purrr_render_target_data_t *data = (_purrr_render_target_data_t*)malloc(sizeof(*data));
+  assert(data && renderer_data);
+  memset(data, 0, sizeof(*data));
+
+  _purrr_pipeline_descriptor_t *pipeline_descriptor = (_purrr_pipeline_descriptor_t*)render_target->descriptor;
+  if (!pipeline_descriptor || !pipeline_descriptor->initialized || pipeline_descriptor->info.color_attachment_count == 0 || !pipeline_descriptor->info.color_attachments) return false;
+  render_target->image_count = pipeline_descriptor->info.color_attachment_count*(pipeline_descriptor->info.resolve_attachments?2:1)+(pipeline_descriptor->info.depth_attachment?1:0);
+
+  VkImageView *views = (VkImageView*)malloc(sizeof(*views)*render_target->image_count);
+  assert(views);
+
+  if (render_target->info.images) {
+    for (uint32_t i = 0; i < render_target->image_count; ++i) {
+      purrr_image_t *image = render_target->info.images[i];
+      assert(image);
+      _purrr_image_data_t *image_data = (_purrr_image_data_t*)((_purrr_image_t*)image)->data_ptr;
+      if (!(image_data->usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))) {
+        free(views);
+        return false;
+      }
+      views[i] = image_data->attachment_view;
+    }
+  } else {
+    render_target->images = (_purrr_image_t**)malloc(sizeof(render_target->images)*render_target->image_count);
+    assert(render_target->images);
+
+    uint32_t i = 0;
+    for (; i < pipeline_descriptor->info.color_attachment_count; ++i) {
+      purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.color_attachments[i];
+      purrr_image_info_t info = {
+        .width = render_target->width,
+        .height = render_target->height,
+        .format = attachment_info.format,
+        .sample_count = attachment_info.sample_count,
+        .mip_levels = 1,
+        // Only lives inside the render pass if it's resolved into something else.
+        .usage = ((pipeline_descriptor->info.resolve_attachments && !attachment_info.load && !attachment_info.store)?(PURRR_IMAGE_USAGE_COLOR_TARGET | PURRR_IMAGE_USAGE_TRANSIENT):0),
+      };
+
+      _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
+      if (!image) return false;
+      render_target->images[i] = image;
+      views[i] = ((_purrr_image_data_t*)image->data_ptr)->attachment_view;
+    }
+    if (pipeline_descriptor->info.resolve_attachments) {
+      for (uint32_t j = 0; j < pipeline_descriptor->info.color_attachment_count; ++j, ++i) {
+        purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.resolve_attachments[j];
+        purrr_image_info_t info = {
+          .width = render_target->width,
+          .height = render_target->height,
+          .format = attachment_info.format,
+          .mip_levels = 1,
+        };
+
+        _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
+        if (!image) return false;
+        render_target->images[i] = image;
+        views[i] = ((_purrr_image_data_t*)image->data_ptr)->attachment_view;
+      }
+    }
+    if (i < render_target->image_count) { // depth I think
+      purrr_pipeline_descriptor_attachment_info_t attachment_info = *pipeline_descriptor->info.depth_attachment;
+      purrr_image_info_t info = {
+        .width = render_target->width,
+        .height = render_target->height,
+        .format = attachment_info.format,
+        .sample_count = attachment_info.sample_count,
+        .mip_levels = 1,
+        .usage = ((!attachment_info.load && !attachment_info.store)?(PURRR_IMAGE_USAGE_DEPTH_TARGET | PURRR_IMAGE_USAGE_TRANSIENT):0),
+      };
+
+      _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
+      if (!image) return false;
+      render_target->images[i] = image;
+      views[i++] = ((_purrr_image_data_t*)image->data_ptr)->attachment_view;
+    }
+    assert(i == render_target->image_count);
+  }
+
+  {
+    VkImageLayout *final_layouts = (VkImageLayout*)malloc(sizeof(*final_layouts)*render_target->image_count);
+    assert(final_layouts);
+    for (uint32_t i = 0; i < render_target->image_count; ++i) {
+      _purrr_image_t *image = (render_target->info.images?(_purrr_image_t*)render_target->info.images[i]:render_target->images[i]);
+      final_layouts[i] = ((_purrr_image_data_t*)image->data_ptr)->layout;
+    }
+    bool created = _purrr_vulkan_render_pass_create(renderer_data, &pipeline_descriptor->info, final_layouts, &data->render_pass);
+    free(final_layouts);
+    if (!created) return false;
+  }
+
+  {
+    VkFramebufferCreateInfo framebuffer_info = {
+      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+      .renderPass = data->render_pass,
+      .attachmentCount = render_target->image_count,
+      .pAttachments = views,
+      .width = render_target->width,
+      .height = render_target->height,
+      .layers = 1,
+    };
+
+    if (vkCreateFramebuffer(renderer_data->device, &framebuffer_info, VK_NULL_HANDLE, &data->framebuffer) != VK_SUCCESS) return false;
+  }
+
+  render_target->data_ptr = data;
+
+  return true;
+}
+
+void _purrr_render_target_vulkan_cleanup(_purrr_render_target_t *render_target) {
+  _purrr_render_target_data_t *data = (_purrr_render_target_data_t*)render_target->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)render_target->renderer->data_ptr;
+  if (!data || !renderer_data) return;
+  if (render_target->initialized) {
+    vkDestroyFramebuffer(renderer_data->device, data->framebuffer, VK_NULL_HANDLE);
+    vkDestroyRenderPass(renderer_data->device, data->render_pass, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < render_target->image_count && render_target->images; ++i)
+      _purrr_image_free(render_target->images[i]);
+  }
+  free(data);
+  render_target->initialized = false;
+  render_target->image_count = 0;
+}
+
+_purrr_image_t *_purrr_render_target_vulkan_get_image(_purrr_render_target_t *render_target, uint32_t image_index) {
+  if (!render_target || !render_target->initialized ||
+      !render_target->images || image_index >= render_target->image_count)
+    return NULL;
+  return render_target->images[image_index];
+}
+
+// buffer
+
+bool _purrr_buffer_vulkan_init(_purrr_buffer_t *buffer) {
+  if (!buffer) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
+  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)malloc(sizeof(*data));
+  assert(data && renderer_data);
+  memset(data, 0, sizeof(*data));
+
+  VkBufferUsageFlagBits usage = 0;
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+  switch (buffer->info.type) {
+  case PURRR_BUFFER_TYPE_UNIFORM:
+    usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    layout = renderer_data->uniform_descriptor_set_layout;
+    break;
+  case PURRR_BUFFER_TYPE_STORAGE:
+    usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    layout = renderer_data->storage_descriptor_set_layout;
+    break;
+  case PURRR_BUFFER_TYPE_VERTEX:
+    usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    break;
+  case PURRR_BUFFER_TYPE_INDEX:
+    usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    break;
+  case COUNT_PURRR_BUFFER_TYPES:
+  default: {
+    assert(0 && "Unreachable");
+    return false;
+  }
+  }
+
+  VkMemoryPropertyFlags properties = 0, preferred = 0;
+  switch (buffer->info.usage) {
+  case PURRR_MEMORY_USAGE_CPU_TO_GPU:
+    properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    // Don't fill the small BAR window with data that is only written once in a while.
+    if (renderer_data->allocator.rebar) preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    break;
+  case PURRR_MEMORY_USAGE_GPU_ONLY:
+    preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    break;
+  case PURRR_MEMORY_USAGE_GPU_TO_CPU:
+    properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    break;
+  case PURRR_MEMORY_USAGE_STREAM:
+    properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    break;
+  case COUNT_PURRR_MEMORY_USAGES:
+  default: {
+    assert(0 && "Unreachable");
+    return false;
+  }
+  }
+
+  purrr_buffer_info_t info = buffer->info;
+  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, info.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, properties, preferred, &data->buffer, &data->allocation)) return false;
+
+  // Mapped once, purrr_buffer_map just hands the pointer out.
+  if (!_purrr_vulkan_map(renderer_data, &data->allocation, &data->mapped)) data->mapped = NULL;
+
+  // Buffers bigger than a descriptor can cover only get bound in ranges.
+  if (!layout || info.size > ((buffer->info.type == PURRR_BUFFER_TYPE_UNIFORM)?renderer_data->uniform_max_range:renderer_data->storage_max_range)) goto defer;
+
+  VkDescriptorBufferInfo buffer_info = {
+    .buffer = data->buffer,
+    .offset = 0,
+    .range = buffer->info.size,
+  };
+
+  if (!_purrr_vulkan_descriptor_acquire(renderer_data, layout, vk_descriptor_type(buffer->info.type), NULL, &buffer_info, &data->set)) return false;
+
+defer:
+  buffer->data_ptr = data;
+
+  return true;
+}
+
+void _purrr_buffer_vulkan_cleanup(_purrr_buffer_t *buffer) {
+  if (!buffer) return;
+  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
   if (!data || !renderer_data) return;
-  if (pipeline->initialized) {
-    vkDestroyPipeline(renderer_data->device, data->pipeline, VK_NULL_HANDLE);
-    vkDestroyPipelineLayout(renderer_data->device, data->pipeline_layout, VK_NULL_HANDLE);
+  if (buffer->initialized) _purrr_renderer_vulkan_destroy_buffer(renderer_data, data->buffer, &data->allocation);
+  _purrr_vulkan_descriptor_release(renderer_data, &data->set);
+  for (size_t i = 0; i < data->range_sets.count; ++i) _purrr_vulkan_descriptor_release(renderer_data, &data->range_sets.items[i].set);
+  free(data->range_sets.items);
+  free(data);
+  buffer->initialized = false;
+}
+
+bool _purrr_buffer_vulkan_copy(_purrr_buffer_t *buffer, void *in_data, uint32_t size, uint32_t offset) {
+  if (!buffer || !buffer->initialized || !in_data) return false;
+  assert(size <= buffer->info.size);
+  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
+  if (!data || !renderer_data) return false;
+
+  VkBuffer staging_buffer;
+  VkDeviceSize staging_offset;
+  void* buffer_data;
+  if (!_purrr_vulkan_staging_claim(renderer_data, size, 16, &staging_buffer, &staging_offset, &buffer_data)) return false;
+  memcpy(buffer_data, in_data, (size_t)size);
+
+  VkCommandBuffer cmd_buf = _purrr_vulkan_staging_begin(renderer_data);
+  if (!cmd_buf) return false;
+  _purrr_renderer_vulkan_copy_buffer(cmd_buf, staging_buffer, staging_offset, data->buffer, size, offset);
+
+  return _purrr_vulkan_staging_submit(renderer_data, cmd_buf, false);
+}
+
+bool _purrr_buffer_vulkan_map(_purrr_buffer_t *buffer, void **out_data) {
+  if (!buffer || !buffer->initialized || !out_data) return false;
+  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
+  if (!data || !renderer_data) return false;
+
+  if (!data->mapped) return false; // GPU_ONLY buffers, use purrr_buffer_copy instead
+  *out_data = data->mapped;
+  return true;
+}
+
+bool _purrr_buffer_vulkan_unmap(_purrr_buffer_t *buffer) {
+  if (!buffer || !buffer->initialized) return false;
+  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
+  if (!data || !renderer_data) return false;
+
+  // Memory stays mapped for the lifetime of its block, see _purrr_vulkan_map.
+
+  return true;
+}
+
+// upload
+
+// A batch is fenced on its own (and on another queue) so it can't share the staging ring, instead it
+// sub-allocates from buffers of at least this size, only growing by another one when the last is full.
+#define PURRR_VULKAN_UPLOAD_CHUNK_SIZE (8ull*1024*1024)
+
+typedef struct {
+  VkCommandBuffer cmd_buf;         // Recorded for the transfer family
+  VkCommandBuffer acquire_cmd_buf; // Takes ownership back on the graphics family, only with a separate transfer family
+  VkCommandBuffer release_cmd_buf; // Hands partially written buffers to the transfer family first, same condition
+  bool releasing;                  // Something was recorded into release_cmd_buf
+  VkSemaphore semaphore;
+  VkSemaphore release_semaphore;
+  VkFence fence;
+  _purrr_vulkan_staging_buffers_t staging;
+  uint8_t *staging_mapped; // Of the last staging buffer
+  VkDeviceSize staging_size;
+  VkDeviceSize staging_head;
+} _purrr_upload_data_t;
+
+static void _purrr_upload_vulkan_release_staging(_purrr_renderer_data_t *renderer_data, _purrr_upload_data_t *data) {
+  _purrr_vulkan_staging_release(renderer_data, &data->staging);
+  free(data->staging.items);
+  memset(&data->staging, 0, sizeof(data->staging));
+  data->staging_mapped = NULL;
+  data->staging_size = data->staging_head = 0;
+}
+
+static bool _purrr_upload_vulkan_stage(_purrr_renderer_data_t *renderer_data, _purrr_upload_data_t *data, void *src, VkDeviceSize size, VkBuffer *out, VkDeviceSize *out_offset) {
+  _purrr_vulkan_staging_buffers_t *staging = &data->staging;
+
+  // 16 covers the texel block sizes and the 4 byte alignment buffer to image copies need.
+  VkDeviceSize offset = _purrr_vulkan_align_up(data->staging_head, 16);
+  if (staging->count > 0 && offset + size <= data->staging_size) {
+    memcpy(data->staging_mapped + offset, src, (size_t)size);
+    data->staging_head = offset + size;
+    *out = staging->items[staging->count-1].buffer;
+    *out_offset = offset;
+    return true;
+  }
+
+  if (staging->count >= staging->capacity) {
+    size_t capacity = (staging->capacity?staging->capacity*2:4);
+    _purrr_vulkan_staging_buffer_t *items = (_purrr_vulkan_staging_buffer_t*)realloc(staging->items, sizeof(*items)*capacity);
+    if (!items) return false;
+    staging->items = items;
+    staging->capacity = capacity;
+  }
+
+  _purrr_vulkan_staging_buffer_t *buffer = &staging->items[staging->count];
+  VkDeviceSize buffer_size = max(size, PURRR_VULKAN_UPLOAD_CHUNK_SIZE);
+  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, &buffer->buffer, &buffer->allocation)) return false;
+
+  void *mapped;
+  if (!_purrr_vulkan_map(renderer_data, &buffer->allocation, &mapped)) {
+    _purrr_renderer_vulkan_destroy_buffer(renderer_data, buffer->buffer, &buffer->allocation);
+    return false;
+  }
+  memcpy(mapped, src, (size_t)size);
+
+  ++staging->count;
+  data->staging_mapped = (uint8_t*)mapped;
+  data->staging_size = buffer_size;
+  data->staging_head = size;
+  *out = buffer->buffer;
+  *out_offset = 0;
+  return true;
+}
+
+bool _purrr_upload_vulkan_init(_purrr_upload_t *upload) {
+  if (!upload || !upload->renderer) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)malloc(sizeof(*data));
+  assert(data && renderer_data);
+  memset(data, 0, sizeof(*data));
+  upload->data_ptr = data;
+
+  VkCommandBufferAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    .commandPool = renderer_data->transfer_command_pool,
+    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    .commandBufferCount = 1,
+  };
+  if (vkAllocateCommandBuffers(renderer_data->device, &alloc_info, &data->cmd_buf) != VK_SUCCESS) return false;
+
+  VkCommandBufferBeginInfo begin_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  if (vkBeginCommandBuffer(data->cmd_buf, &begin_info) != VK_SUCCESS) return false;
+
+  if (renderer_data->transfer_family != renderer_data->graphics_family) {
+    alloc_info.commandPool = renderer_data->command_pool;
+    if (vkAllocateCommandBuffers(renderer_data->device, &alloc_info, &data->acquire_cmd_buf) != VK_SUCCESS) return false;
+    if (vkBeginCommandBuffer(data->acquire_cmd_buf, &begin_info) != VK_SUCCESS) return false;
+    if (vkAllocateCommandBuffers(renderer_data->device, &alloc_info, &data->release_cmd_buf) != VK_SUCCESS) return false;
+    if (vkBeginCommandBuffer(data->release_cmd_buf, &begin_info) != VK_SUCCESS) return false;
+
+    VkSemaphoreCreateInfo semaphore_info = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    };
+    if (vkCreateSemaphore(renderer_data->device, &semaphore_info, VK_NULL_HANDLE, &data->semaphore) != VK_SUCCESS) return false;
+    if (vkCreateSemaphore(renderer_data->device, &semaphore_info, VK_NULL_HANDLE, &data->release_semaphore) != VK_SUCCESS) return false;
+  }
+
+  VkFenceCreateInfo fence_info = {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+  };
+  if (vkCreateFence(renderer_data->device, &fence_info, VK_NULL_HANDLE, &data->fence) != VK_SUCCESS) return false;
+
+  upload->initialized = true;
+
+  return true;
+}
+
+void _purrr_upload_vulkan_cleanup(_purrr_upload_t *upload) {
+  if (!upload) return;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  if (!data) return;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(renderer_data);
+
+  if (upload->submitted) vkWaitForFences(renderer_data->device, 1, &data->fence, VK_TRUE, UINT64_MAX);
+
+  _purrr_upload_vulkan_release_staging(renderer_data, data);
+  if (data->cmd_buf) vkFreeCommandBuffers(renderer_data->device, renderer_data->transfer_command_pool, 1, &data->cmd_buf);
+  if (data->acquire_cmd_buf) vkFreeCommandBuffers(renderer_data->device, renderer_data->command_pool, 1, &data->acquire_cmd_buf);
+  if (data->release_cmd_buf) vkFreeCommandBuffers(renderer_data->device, renderer_data->command_pool, 1, &data->release_cmd_buf);
+  if (data->semaphore) vkDestroySemaphore(renderer_data->device, data->semaphore, VK_NULL_HANDLE);
+  if (data->release_semaphore) vkDestroySemaphore(renderer_data->device, data->release_semaphore, VK_NULL_HANDLE);
+  if (data->fence) vkDestroyFence(renderer_data->device, data->fence, VK_NULL_HANDLE);
+
+  free(data);
+  upload->data_ptr = NULL;
+  upload->initialized = false;
+}
+
+bool _purrr_upload_vulkan_buffer(_purrr_upload_t *upload, _purrr_buffer_t *buffer, void *src, uint32_t size, uint32_t offset) {
+  if (!upload || !upload->initialized || !buffer || !buffer->initialized) return false;
+  if ((uint64_t)offset + size > buffer->info.size) return false;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  _purrr_buffer_data_t *buffer_data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(data && buffer_data && renderer_data);
+
+  VkBuffer staging_buffer;
+  VkDeviceSize staging_offset;
+  if (!_purrr_upload_vulkan_stage(renderer_data, data, src, size, &staging_buffer, &staging_offset)) return false;
+
+  // The ownership transfers only cover the written range, the rest of the buffer stays with the graphics family.
+  VkBufferMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .buffer = buffer_data->buffer,
+    .offset = offset,
+    .size = size,
+  };
+
+  // A buffer that's only partly written may be getting the rest of its contents from earlier work on the graphics
+  // family, so that has to let go of it first (the transfer submit waits for it). Whole writes can skip this,
+  // nothing of what was there before is kept.
+  if (data->acquire_cmd_buf && size < buffer->info.size) {
+    barrier.srcQueueFamilyIndex = renderer_data->graphics_family;
+    barrier.dstQueueFamilyIndex = renderer_data->transfer_family;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(data->release_cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, VK_NULL_HANDLE, 1, &barrier, 0, VK_NULL_HANDLE);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(data->cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 1, &barrier, 0, VK_NULL_HANDLE);
+    data->releasing = true;
+  }
+
+  VkBufferCopy copy_region = {
+    .srcOffset = staging_offset,
+    .dstOffset = offset,
+    .size = size,
+  };
+  vkCmdCopyBuffer(data->cmd_buf, staging_buffer, buffer_data->buffer, 1, &copy_region);
+
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+  if (!data->acquire_cmd_buf) {
+    vkCmdPipelineBarrier(data->cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, VK_NULL_HANDLE, 1, &barrier, 0, VK_NULL_HANDLE);
+    return true;
+  }
+
+  // Release on the transfer family, then acquire the same range on the graphics family.
+  barrier.srcQueueFamilyIndex = renderer_data->transfer_family;
+  barrier.dstQueueFamilyIndex = renderer_data->graphics_family;
+  barrier.dstAccessMask = 0;
+  vkCmdPipelineBarrier(data->cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, VK_NULL_HANDLE, 1, &barrier, 0, VK_NULL_HANDLE);
+
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  vkCmdPipelineBarrier(data->acquire_cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, VK_NULL_HANDLE, 1, &barrier, 0, VK_NULL_HANDLE);
+
+  return true;
+}
+
+bool _purrr_upload_vulkan_image(_purrr_upload_t *upload, _purrr_image_t *image, uint8_t *src, uint32_t src_width, uint32_t src_height) {
+  if (!upload || !upload->initialized || !image || !image->initialized) return false;
+  if (image->info.width < src_width || image->info.height < src_height) return false;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  _purrr_image_data_t *image_data = (_purrr_image_data_t*)image->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(data && image_data && renderer_data);
+
+  if (image_data->mapped) {
+    _purrr_image_vulkan_write_linear(renderer_data, image, src, src_width, src_height);
+    return true;
+  }
+  if (!(image_data->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) return false;
+
+  VkBuffer staging_buffer;
+  VkDeviceSize staging_offset;
+  VkDeviceSize size = format_image_size(image->info.format, src_width, src_height);
+  if (!_purrr_upload_vulkan_stage(renderer_data, data, src, size, &staging_buffer, &staging_offset)) return false;
+
+  _purrr_vulkan_cmd_transition_image_layout(data->cmd_buf, image_data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+  _purrr_renderer_vulkan_copy_buffer_to_image(data->cmd_buf, staging_buffer, staging_offset, image_data->image, 0, format_block_extent(image->info.format), src_width, src_height);
+
+  bool mips = image_data->generate_mips;
+  VkAccessFlags access;
+  VkPipelineStageFlags stage;
+  _purrr_image_vulkan_resting_access(image_data->layout, &access, &stage);
+  if (!data->acquire_cmd_buf) {
+    if (mips) _purrr_vulkan_cmd_generate_mips(data->cmd_buf, image_data->image, image->info.width, image->info.height, image_data->mip_levels, image_data->mip_filter);
+    _purrr_vulkan_cmd_transition_image_layout(data->cmd_buf, image_data->image, (mips?VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL), image_data->layout, VK_ACCESS_TRANSFER_WRITE_BIT, access, VK_PIPELINE_STAGE_TRANSFER_BIT, stage);
+    return true;
+  }
+
+  // The layout transition happens once, as part of the ownership transfer.
+  // Transfer queues can't blit, so with mips the image stays in TRANSFER_DST until the graphics side generated them.
+  VkImageMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = 0,
+    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    .newLayout = (mips?VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:image_data->layout),
+    .srcQueueFamilyIndex = renderer_data->transfer_family,
+    .dstQueueFamilyIndex = renderer_data->graphics_family,
+    .image = image_data->image,
+    .subresourceRange = {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = VK_REMAINING_MIP_LEVELS,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+    },
+  };
+  vkCmdPipelineBarrier(data->cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 1, &barrier);
+
+  barrier.srcAccessMask = 0;
+  if (!mips) {
+    barrier.dstAccessMask = access;
+    vkCmdPipelineBarrier(data->acquire_cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stage, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 1, &barrier);
+    return true;
+  }
+
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(data->acquire_cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, 1, &barrier);
+
+  _purrr_vulkan_cmd_generate_mips(data->acquire_cmd_buf, image_data->image, image->info.width, image->info.height, image_data->mip_levels, image_data->mip_filter);
+  _purrr_vulkan_cmd_transition_image_layout(data->acquire_cmd_buf, image_data->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image_data->layout, VK_ACCESS_TRANSFER_WRITE_BIT, access, VK_PIPELINE_STAGE_TRANSFER_BIT, stage);
+
+  return true;
+}
+
+bool _purrr_upload_vulkan_submit(_purrr_upload_t *upload) {
+  if (!upload || !upload->initialized) return false;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (vkEndCommandBuffer(data->cmd_buf) != VK_SUCCESS) return false;
+
+  VkSubmitInfo submit_info = {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &data->cmd_buf,
+  };
+
+  if (!data->acquire_cmd_buf)
+    return vkQueueSubmit(renderer_data->transfer_queue, 1, &submit_info, data->fence) == VK_SUCCESS;
+
+  if (vkEndCommandBuffer(data->acquire_cmd_buf) != VK_SUCCESS) return false;
+
+  VkPipelineStageFlags release_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  if (data->releasing) {
+    if (vkEndCommandBuffer(data->release_cmd_buf) != VK_SUCCESS) return false;
+
+    VkSubmitInfo release_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &data->release_cmd_buf,
+      .signalSemaphoreCount = 1,
+      .pSignalSemaphores = &data->release_semaphore,
+    };
+    if (vkQueueSubmit(renderer_data->graphics_queue, 1, &release_info, VK_NULL_HANDLE) != VK_SUCCESS) return false;
+
+    submit_info.waitSemaphoreCount = 1;
+    submit_info.pWaitSemaphores = &data->release_semaphore;
+    submit_info.pWaitDstStageMask = &release_stage;
+  }
+
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &data->semaphore;
+  if (vkQueueSubmit(renderer_data->transfer_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) return false;
+
+  VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  VkSubmitInfo acquire_info = {
+    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .waitSemaphoreCount = 1,
+    .pWaitSemaphores = &data->semaphore,
+    .pWaitDstStageMask = &wait_stage,
+    .commandBufferCount = 1,
+    .pCommandBuffers = &data->acquire_cmd_buf,
+  };
+  return vkQueueSubmit(renderer_data->graphics_queue, 1, &acquire_info, data->fence) == VK_SUCCESS;
+}
+
+bool _purrr_upload_vulkan_is_done(_purrr_upload_t *upload) {
+  if (!upload || !upload->initialized) return false;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (vkGetFenceStatus(renderer_data->device, data->fence) != VK_SUCCESS) return false;
+  _purrr_upload_vulkan_release_staging(renderer_data, data);
+  return true;
+}
+
+bool _purrr_upload_vulkan_wait(_purrr_upload_t *upload) {
+  if (!upload || !upload->initialized) return false;
+  _purrr_upload_data_t *data = (_purrr_upload_data_t*)upload->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)upload->renderer->data_ptr;
+  assert(data && renderer_data);
+
+  if (vkWaitForFences(renderer_data->device, 1, &data->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) return false;
+  _purrr_upload_vulkan_release_staging(renderer_data, data);
+  return true;
+}
+
+// readback
+
+// The ring is reused after this, so a readback that can't be copied out fails for good.
+static bool _purrr_vulkan_readback_resolve(_purrr_renderer_data_t *data, _purrr_readback_t *readback) {
+  _purrr_readback_data_t *readback_data = (_purrr_readback_data_t*)readback->data_ptr;
+  readback->done = true;
+  readback->data = malloc(readback->size);
+  if (!readback->data) {
+    readback->failed = true;
+    return false;
+  }
+  memcpy(readback->data, data->readback.mapped + readback_data->offset, readback->size);
+  return true;
+}
+
+static void _purrr_vulkan_readback_remove(_purrr_renderer_data_t *data, _purrr_readback_t *readback) {
+  _purrr_vulkan_readbacks_t *pending = &data->readback.pending[((_purrr_readback_data_t*)readback->data_ptr)->frame_index];
+  for (size_t i = 0; i < pending->count; ++i) {
+    if (pending->items[i] != readback) continue;
+    pending->items[i] = pending->items[--pending->count];
+    return;
+  }
+}
+
+// Expects the fence of `frame_index` to be signaled.
+void _purrr_vulkan_readback_reset(_purrr_renderer_data_t *data, uint32_t frame_index) {
+  _purrr_vulkan_readbacks_t *pending = &data->readback.pending[frame_index];
+  for (size_t i = 0; i < pending->count; ++i)
+    _purrr_vulkan_readback_resolve(data, pending->items[i]);
+  pending->count = 0;
+  data->readback.heads[frame_index] = 0;
+}
+
+void _purrr_vulkan_readback_cleanup(_purrr_renderer_data_t *data) {
+  _purrr_vulkan_readback_ring_t *ring = &data->readback;
+  for (uint32_t i = 0; i < 2; ++i) free(ring->pending[i].items);
+  if (ring->buffer) _purrr_renderer_vulkan_destroy_buffer(data, ring->buffer, &ring->allocation);
+  memset(ring, 0, sizeof(*ring));
+}
+
+bool _purrr_readback_vulkan_init(_purrr_readback_t *readback) {
+  if (!readback || !readback->renderer || !readback->renderer->initialized) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)readback->renderer->data_ptr;
+  assert(renderer_data);
+  if (!renderer_data->active_cmd_buf || renderer_data->active_render_target) return false;
+
+  _purrr_vulkan_readback_ring_t *ring = &renderer_data->readback;
+  if (!ring->buffer) {
+    ring->size = (readback->renderer->info.readback_size?readback->renderer->info.readback_size:PURRR_VULKAN_READBACK_SIZE);
+    if (!_purrr_renderer_vulkan_create_buffer(renderer_data, ring->size*2, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &ring->buffer, &ring->allocation)) return false;
+    if (!_purrr_vulkan_map(renderer_data, &ring->allocation, (void**)&ring->mapped)) {
+      _purrr_renderer_vulkan_destroy_buffer(renderer_data, ring->buffer, &ring->allocation);
+      ring->buffer = VK_NULL_HANDLE;
+      return false;
+    }
   }
+
+  VkDeviceSize alignment = 4;
+  if (readback->image) {
+    _purrr_image_data_t *image_data = (_purrr_image_data_t*)readback->image->data_ptr;
+    if (!image_data || !image_data->image) return false; // Evicted
+    if (!(image_data->usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) return false;
+    readback->size = (uint32_t)format_image_size(readback->image->info.format, readback->image->info.width, readback->image->info.height);
+    alignment = format_size(readback->image->info.format)*4;
+  }
+
+  uint32_t frame_index = renderer_data->frame_index;
+  VkDeviceSize offset = _purrr_vulkan_align_up(ring->heads[frame_index], alignment);
+  if (offset + readback->size > ring->size) return false;
+
+  _purrr_vulkan_readbacks_t *pending = &ring->pending[frame_index];
+  if (pending->count >= pending->capacity) {
+    size_t capacity = (pending->capacity?pending->capacity*2:4);
+    _purrr_readback_t **items = (_purrr_readback_t**)realloc(pending->items, sizeof(*items)*capacity);
+    if (!items) return false;
+    pending->items = items;
+    pending->capacity = capacity;
+  }
+
+  _purrr_readback_data_t *data = (_purrr_readback_data_t*)malloc(sizeof(*data));
+  assert(data);
+  memset(data, 0, sizeof(*data));
+  data->frame_index = frame_index;
+  data->frame = renderer_data->frame_counter;
+  data->offset = ring->size*frame_index + offset;
+
+  VkCommandBuffer cmd_buf = renderer_data->active_cmd_buf;
+  if (readback->image) {
+    _purrr_image_data_t *image_data = (_purrr_image_data_t*)readback->image->data_ptr;
+    VkImage image = image_data->image;
+    _purrr_image_vulkan_mark_used(renderer_data, readback->image);
+    _purrr_vulkan_cmd_transition_image_layout(cmd_buf, image, image_data->layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    _purrr_renderer_vulkan_copy_image_to_buffer(cmd_buf, image, 0, ring->buffer, data->offset, format_block_extent(readback->image->info.format), readback->image->info.width, readback->image->info.height);
+    // Whatever reads the image next, could be any shader stage or another transfer
+    _purrr_vulkan_cmd_transition_image_layout(cmd_buf, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image_data->layout, 0, VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  } else {
+    VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+
+    VkBufferCopy region = {
+      .srcOffset = readback->offset,
+      .dstOffset = data->offset,
+      .size = readback->size,
+    };
+    vkCmdCopyBuffer(cmd_buf, ((_purrr_buffer_data_t*)readback->buffer->data_ptr)->buffer, ring->buffer, 1, &region);
+  }
+
+  VkMemoryBarrier host_barrier = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+  };
+  vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &host_barrier, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+
+  ring->heads[frame_index] = offset + readback->size;
+  pending->items[pending->count++] = readback;
+
+  readback->initialized = true;
+  readback->data_ptr = data;
+
+  return true;
+}
+
+void _purrr_readback_vulkan_cleanup(_purrr_readback_t *readback) {
+  if (!readback || !readback->initialized) return;
+  assert(readback->renderer);
+  _purrr_readback_data_t *data = (_purrr_readback_data_t*)readback->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)readback->renderer->data_ptr;
+  assert(data && renderer_data);
+  // The copy may still run, but it only writes into the ring.
+  if (!readback->done) _purrr_vulkan_readback_remove(renderer_data, readback);
+  free(readback->data);
   free(data);
-  pipeline->initialized = false;
 }
 
-// render target
+// A readback that is still pending belongs to the last frame recorded with its fence, unless that frame is still being recorded.
+static bool _purrr_readback_vulkan_submitted(_purrr_renderer_data_t *renderer_data, _purrr_readback_data_t *data) {
+  return !(renderer_data->active_cmd_buf && data->frame == renderer_data->frame_counter);
+}
+
+bool _purrr_readback_vulkan_is_done(_purrr_readback_t *readback) {
+  if (!readback || !readback->initialized) return false;
+  _purrr_readback_data_t *data = (_purrr_readback_data_t*)readback->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)readback->renderer->data_ptr;
+  assert(data && renderer_data);
+  if (!_purrr_readback_vulkan_submitted(renderer_data, data)) return false;
+  if (vkGetFenceStatus(renderer_data->device, renderer_data->flight_fences[data->frame_index]) != VK_SUCCESS) return false;
+
+  _purrr_vulkan_readback_remove(renderer_data, readback);
+  return _purrr_vulkan_readback_resolve(renderer_data, readback);
+}
+
+bool _purrr_readback_vulkan_wait(_purrr_readback_t *readback) {
+  if (!readback || !readback->initialized) return false;
+  _purrr_readback_data_t *data = (_purrr_readback_data_t*)readback->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)readback->renderer->data_ptr;
+  assert(data && renderer_data);
+  if (!_purrr_readback_vulkan_submitted(renderer_data, data)) return false;
+  if (vkWaitForFences(renderer_data->device, 1, &renderer_data->flight_fences[data->frame_index], VK_TRUE, UINT64_MAX) != VK_SUCCESS) return false;
+
+  _purrr_vulkan_readback_remove(renderer_data, readback);
+  return _purrr_vulkan_readback_resolve(renderer_data, readback);
+}
+
+// image loader
+
+#define PURRR_VULKAN_LOADER_STAGING_SIZE (64*1024*1024)
+
+typedef struct _purrr_image_loader_job_s {
+  struct _purrr_image_loader_job_s *next;        // Queue, ready list or batch
+  struct _purrr_image_loader_job_s *staged_next; // Staging order
+  char *filename;
+  purrr_image_loaded_cb callback;
+  void *user_ptr;
+  uint32_t width, height;
+  VkDeviceSize offset, size;
+  bool staged;   // Owns a region of the staging buffer
+  bool released; // The GPU is done with that region
+  bool failed;
+  _purrr_image_t *image;
+  _purrr_texture_t *texture;
+} _purrr_image_loader_job_t;
 
-bool _purrr_render_target_vulkan_init(_purrr_render_target_t *render_target) {
-  if (!render_target || !render_target->renderer || !render_target->renderer->initialized) return false;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)render_target->renderer->data_ptr;
-  _purrr_render_target_data_t *data = (_purrr_render_target_data_t*)malloc(sizeof(*data));
-  assert(data && renderer_data);
-  memset(data, 0, sizeof(*data));
+typedef struct {
+  VkCommandBuffer cmd_buf;
+  VkFence fence;
+  _purrr_image_loader_job_t *jobs;
+} _purrr_image_loader_batch_t;
 
-  _purrr_pipeline_descriptor_t *pipeline_descriptor = (_purrr_pipeline_descriptor_t*)render_target->descriptor;
-  if (!pipeline_descriptor || !pipeline_descriptor->initialized || pipeline_descriptor->info.color_attachment_count == 0 || !pipeline_descriptor->info.color_attachments) return false;
-  _purrr_pipeline_descriptor_data_t *pipeline_descriptor_data = (_purrr_pipeline_descriptor_data_t*)pipeline_descriptor->data_ptr;
-  assert(pipeline_descriptor_data);
+typedef struct {
+  _purrr_image_loader_batch_t *items;
+  size_t capacity;
+  size_t count;
+} _purrr_image_loader_batches_t;
 
-  render_target->image_count = pipeline_descriptor->info.color_attachment_count*(pipeline_descriptor->info.resolve_attachments?2:1)+(pipeline_descriptor->info.depth_attachment?1:0);
+// Everything below the mutex is shared with the threads, batches are only touched by the polling thread.
+typedef struct {
+  thrd_t *threads;
+  uint32_t thread_count;
 
-  VkImageView *views = (VkImageView*)malloc(sizeof(*views)*render_target->image_count);
-  assert(views);
+  mtx_t mutex;
+  cnd_t work_cond;    // A job was queued or the loader is stopping
+  cnd_t staging_cond; // Staging memory was released
+  bool stopping;
+  uint32_t pending;
 
-  if (render_target->info.images) {
-    for (uint32_t i = 0; i < render_target->image_count; ++i) {
-      purrr_image_t *image = render_target->info.images[i];
-      assert(image);
-      views[i] = ((_purrr_image_data_t*)(((_purrr_image_t*)image)->data_ptr))->image_view;
-    }
-  } else {
-    render_target->images = (_purrr_image_t**)malloc(sizeof(render_target->images)*render_target->image_count);
-    assert(render_target->images);
+  _purrr_image_loader_job_t *queue_first, *queue_last;
+  _purrr_image_loader_job_t *ready;
+  _purrr_image_loader_job_t *staged_first, *staged_last;
 
-    uint32_t i = 0;
-    for (; i < pipeline_descriptor->info.color_attachment_count; ++i) {
-      purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.color_attachments[i];
-      purrr_image_info_t info = {
-        .width = render_target->width,
-        .height = render_target->height,
-        .format = attachment_info.format,
-        .sample_count = attachment_info.sample_count,
-      };
+  // Regions are handed out like a ring and come back oldest first
+  VkBuffer staging_buffer;
+  _purrr_vulkan_allocation_t staging_allocation;
+  uint8_t *staging_mapped;
+  VkDeviceSize staging_size;
+  VkDeviceSize staging_head;
+
+  _purrr_image_loader_batches_t batches;
+} _purrr_image_loader_data_t;
+
+static uint8_t *_purrr_vulkan_read_file(const char *filename, size_t *size) {
+  FILE *fd = fopen(filename, "rb");
+  if (!fd) return NULL;
+  fseek(fd, 0, SEEK_END);
+  long length = ftell(fd);
+  fseek(fd, 0, SEEK_SET);
+  uint8_t *buffer = (length > 0)?(uint8_t*)malloc((size_t)length):NULL;
+  if (!buffer || fread(buffer, (size_t)length, 1, fd) != 1) {
+    fclose(fd);
+    free(buffer);
+    return NULL;
+  }
+  fclose(fd);
+  *size = (size_t)length;
+  return buffer;
+}
 
-      _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
-      if (!image) return false;
-      render_target->images[i] = image;
-      views[i] = ((_purrr_image_data_t*)image->data_ptr)->image_view;
-    }
-    if (pipeline_descriptor->info.resolve_attachments) {
-      for (uint32_t j = 0; j < pipeline_descriptor->info.color_attachment_count; ++j, ++i) {
-        purrr_pipeline_descriptor_attachment_info_t attachment_info = pipeline_descriptor->info.resolve_attachments[i];
-        purrr_image_info_t info = {
-          .width = render_target->width,
-          .height = render_target->height,
-          .format = attachment_info.format,
-        };
+// Expects the mutex to be locked.
+static bool _purrr_image_loader_vulkan_fits(_purrr_image_loader_data_t *data, VkDeviceSize size, VkDeviceSize *offset) {
+  if (!data->staged_first) {
+    *offset = 0;
+    return true;
+  }
 
-        _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
-        if (!image) return false;
-        render_target->images[i] = image;
-        views[i] = ((_purrr_image_data_t*)image->data_ptr)->image_view;
-      }
+  // The head never catches up with the tail, head == tail only ever means empty.
+  VkDeviceSize tail = data->staged_first->offset;
+  if (data->staging_head > tail) {
+    if (data->staging_head + size <= data->staging_size) {
+      *offset = data->staging_head;
+      return true;
     }
-    if (i < render_target->image_count) { // depth I think
-      purrr_pipeline_descriptor_attachment_info_t attachment_info = *pipeline_descriptor->info.depth_attachment;
-      purrr_image_info_t info = {
-        .width = render_target->width,
-        .height = render_target->height,
-        .format = attachment_info.format,
-      };
-
-      _purrr_image_t *image = (_purrr_image_t*)purrr_image_create(&info, (purrr_renderer_t*)render_target->renderer);
-      if (!image) return false;
-      render_target->images[i] = image;
-      views[i++] = ((_purrr_image_data_t*)image->data_ptr)->image_view;
+    if (size < tail) {
+      *offset = 0;
+      return true;
     }
-    assert(i == render_target->image_count);
+    return false;
   }
 
-  {
-    VkFramebufferCreateInfo framebuffer_info = {
-      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-      .renderPass = pipeline_descriptor_data->render_pass,
-      .attachmentCount = render_target->image_count,
-      .pAttachments = views,
-      .width = render_target->width,
-      .height = render_target->height,
-      .layers = 1,
-    };
-
-    if (vkCreateFramebuffer(renderer_data->device, &framebuffer_info, VK_NULL_HANDLE, &data->framebuffer) != VK_SUCCESS) return false;
+  if (data->staging_head + size < tail) {
+    *offset = data->staging_head;
+    return true;
   }
+  return false;
+}
 
-  render_target->data_ptr = data;
+// Expects the mutex to be locked.
+static void _purrr_image_loader_vulkan_release(_purrr_image_loader_data_t *data, _purrr_image_loader_job_t *job) {
+  --data->pending;
+  if (!job->staged) {
+    free(job);
+    return;
+  }
 
-  return true;
+  job->released = true;
+  while (data->staged_first && data->staged_first->released) {
+    _purrr_image_loader_job_t *first = data->staged_first;
+    data->staged_first = first->staged_next;
+    free(first);
+  }
+  if (!data->staged_first) {
+    data->staged_last = NULL;
+    data->staging_head = 0;
+  }
+  cnd_broadcast(&data->staging_cond);
 }
 
-void _purrr_render_target_vulkan_cleanup(_purrr_render_target_t *render_target) {
-  _purrr_render_target_data_t *data = (_purrr_render_target_data_t*)render_target->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)render_target->renderer->data_ptr;
-  if (!data || !renderer_data) return;
-  if (render_target->initialized) {
-    vkDestroyFramebuffer(renderer_data->device, data->framebuffer, VK_NULL_HANDLE);
-    for (uint32_t i = 0; i < render_target->image_count && render_target->images; ++i)
-      _purrr_image_free(render_target->images[i]);
+static void _purrr_image_loader_vulkan_finish(_purrr_image_loader_data_t *data, _purrr_image_loader_job_t *jobs) {
+  while (jobs) {
+    _purrr_image_loader_job_t *job = jobs;
+    jobs = job->next;
+    job->callback((purrr_texture_t*)job->texture, (purrr_image_t*)job->image, job->user_ptr);
+
+    mtx_lock(&data->mutex);
+    _purrr_image_loader_vulkan_release(data, job);
+    mtx_unlock(&data->mutex);
   }
-  free(data);
-  render_target->initialized = false;
-  render_target->image_count = 0;
 }
 
-_purrr_image_t *_purrr_render_target_vulkan_get_image(_purrr_render_target_t *render_target, uint32_t image_index) {
-  if (!render_target || !render_target->initialized ||
-      !render_target->images || image_index >= render_target->image_count)
-    return NULL;
-  return render_target->images[image_index];
+static int _purrr_image_loader_vulkan_worker(void *arg) {
+  _purrr_image_loader_t *loader = (_purrr_image_loader_t*)arg;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)loader->data_ptr;
+
+  for (;;) {
+    mtx_lock(&data->mutex);
+    while (!data->queue_first && !data->stopping) cnd_wait(&data->work_cond, &data->mutex);
+    _purrr_image_loader_job_t *job = data->queue_first;
+    if (!job) {
+      mtx_unlock(&data->mutex);
+      return 0;
+    }
+    data->queue_first = job->next;
+    if (!data->queue_first) data->queue_last = NULL;
+    mtx_unlock(&data->mutex);
+
+    size_t file_size = 0;
+    uint8_t *file = _purrr_vulkan_read_file(job->filename, &file_size);
+    purrr_image_decode_t decode = {
+      .loader = loader,
+      .job = job,
+    };
+    job->failed = (!file || !loader->info.decoder(file, file_size, &decode, loader->info.user_ptr) || !job->staged);
+    free(file);
+    free(job->filename);
+    job->filename = NULL;
+
+    mtx_lock(&data->mutex);
+    job->next = data->ready;
+    data->ready = job;
+    mtx_unlock(&data->mutex);
+  }
 }
 
-// buffer
-
-bool _purrr_buffer_vulkan_init(_purrr_buffer_t *buffer) {
-  if (!buffer) return false;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
-  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)malloc(sizeof(*data));
+bool _purrr_image_loader_vulkan_init(_purrr_image_loader_t *loader) {
+  if (!loader || !loader->renderer || !loader->renderer->initialized) return false;
+  if (format_is_compressed(loader->info.format)) return false;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)loader->renderer->data_ptr;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)malloc(sizeof(*data));
   assert(data && renderer_data);
   memset(data, 0, sizeof(*data));
-
-  VkBufferUsageFlagBits usage = 0;
-  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
-  switch (buffer->info.type) {
-  case PURRR_BUFFER_TYPE_UNIFORM:
-    usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    layout = renderer_data->uniform_descriptor_set_layout;
-    break;
-  case PURRR_BUFFER_TYPE_STORAGE:
-    usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    layout = renderer_data->storage_descriptor_set_layout;
-    break;
-  case PURRR_BUFFER_TYPE_VERTEX:
-    usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    break;
-  case PURRR_BUFFER_TYPE_INDEX:
-    usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    break;
-  case COUNT_PURRR_BUFFER_TYPES:
-  default: {
-    assert(0 && "Unreachable");
-    return false;
-  }
+  loader->data_ptr = data;
+
+  data->staging_size = (loader->info.staging_size?loader->info.staging_size:PURRR_VULKAN_LOADER_STAGING_SIZE);
+  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, data->staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, &data->staging_buffer, &data->staging_allocation)) goto error;
+  if (!_purrr_vulkan_map(renderer_data, &data->staging_allocation, (void**)&data->staging_mapped)) goto error;
+
+  if (mtx_init(&data->mutex, mtx_plain) != thrd_success) goto error;
+  cnd_init(&data->work_cond);
+  cnd_init(&data->staging_cond);
+
+  data->thread_count = (loader->info.thread_count?loader->info.thread_count:_purrr_vulkan_cpu_count());
+  data->threads = (thrd_t*)malloc(sizeof(*data->threads)*data->thread_count);
+  assert(data->threads);
+
+  for (uint32_t i = 0; i < data->thread_count; ++i) {
+    if (thrd_create(&data->threads[i], _purrr_image_loader_vulkan_worker, loader) == thrd_success) continue;
+    data->thread_count = i;
+    if (i > 0) break; // Fewer threads are fine
+
+    cnd_destroy(&data->work_cond);
+    cnd_destroy(&data->staging_cond);
+    mtx_destroy(&data->mutex);
+    free(data->threads);
+    goto error;
   }
 
-  purrr_buffer_info_t info = buffer->info;
-  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, info.size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &data->buffer, &data->buffer_memory)) return false;
+  loader->initialized = true;
 
-  if (!layout) goto defer;
+  return true;
+error:
+  if (data->staging_buffer) _purrr_renderer_vulkan_destroy_buffer(renderer_data, data->staging_buffer, &data->staging_allocation);
+  free(data);
+  loader->data_ptr = NULL;
+  return false;
+}
 
-  VkDescriptorSetAllocateInfo alloc_info = {
-    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-    .descriptorPool = renderer_data->descriptor_pool,
-    .descriptorSetCount = 1,
-    .pSetLayouts = &layout,
-  };
+void _purrr_image_loader_vulkan_cleanup(_purrr_image_loader_t *loader) {
+  if (!loader) return;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)loader->data_ptr;
+  if (!data) return;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)loader->renderer->data_ptr;
+  assert(renderer_data);
 
-  if (vkAllocateDescriptorSets(renderer_data->device, &alloc_info, &data->set) != VK_SUCCESS) return false;
+  while (_purrr_image_loader_vulkan_poll(loader) > 0) {
+    if (data->batches.count > 0) vkWaitForFences(renderer_data->device, 1, &data->batches.items[0].fence, VK_TRUE, UINT64_MAX);
+    else thrd_yield();
+  }
 
-  VkDescriptorBufferInfo buffer_info = {
-    .buffer = data->buffer,
-    .offset = 0,
-    .range = buffer->info.size,
-  };
+  mtx_lock(&data->mutex);
+  data->stopping = true;
+  cnd_broadcast(&data->work_cond);
+  mtx_unlock(&data->mutex);
+  for (uint32_t i = 0; i < data->thread_count; ++i) thrd_join(data->threads[i], NULL);
 
-  VkWriteDescriptorSet descriptor_write = {
-    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-    .dstSet = data->set,
-    .dstBinding = 0,
-    .dstArrayElement = 0,
-    .descriptorType = vk_descriptor_type(buffer->info.type),
-    .descriptorCount = 1,
-    .pBufferInfo = &buffer_info,
-  };
+  cnd_destroy(&data->work_cond);
+  cnd_destroy(&data->staging_cond);
+  mtx_destroy(&data->mutex);
+  free(data->threads);
+  free(data->batches.items);
+  _purrr_renderer_vulkan_destroy_buffer(renderer_data, data->staging_buffer, &data->staging_allocation);
 
-  vkUpdateDescriptorSets(renderer_data->device, (uint32_t)1, &descriptor_write, 0, VK_NULL_HANDLE);
+  free(data);
+  loader->data_ptr = NULL;
+  loader->initialized = false;
+}
 
-defer:
-  buffer->data_ptr = data;
+bool _purrr_image_loader_vulkan_load_file(_purrr_image_loader_t *loader, const char *filename, purrr_image_loaded_cb callback, void *user_ptr) {
+  if (!loader || !loader->initialized || !filename || !callback) return false;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)loader->data_ptr;
+  assert(data);
+
+  _purrr_image_loader_job_t *job = (_purrr_image_loader_job_t*)malloc(sizeof(*job));
+  assert(job);
+  memset(job, 0, sizeof(*job));
+  size_t length = strlen(filename);
+  job->filename = (char*)malloc(length+1);
+  assert(job->filename);
+  memcpy(job->filename, filename, length+1);
+  job->callback = callback;
+  job->user_ptr = user_ptr;
+
+  mtx_lock(&data->mutex);
+  if (data->queue_last) data->queue_last->next = job;
+  else data->queue_first = job;
+  data->queue_last = job;
+  ++data->pending;
+  cnd_signal(&data->work_cond);
+  mtx_unlock(&data->mutex);
 
   return true;
 }
 
-void _purrr_buffer_vulkan_cleanup(_purrr_buffer_t *buffer) {
-  if (!buffer) return;
-  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
-  if (!data || !renderer_data) return;
-  if (buffer->initialized) {
-    vkDestroyBuffer(renderer_data->device, data->buffer, VK_NULL_HANDLE);
-    vkFreeMemory(renderer_data->device, data->buffer_memory, VK_NULL_HANDLE);
-  }
-  free(data);
-  buffer->initialized = false;
+uint8_t *_purrr_image_loader_vulkan_alloc(_purrr_image_loader_t *loader, void *job_ptr, uint32_t width, uint32_t height) {
+  if (!loader || !loader->initialized || !job_ptr || width == 0 || height == 0) return NULL;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)loader->data_ptr;
+  _purrr_image_loader_job_t *job = (_purrr_image_loader_job_t*)job_ptr;
+  assert(data);
+  if (job->staged) return NULL;
+
+  // Copies need offsets aligned to the texel size and to 4
+  VkDeviceSize size = _purrr_vulkan_align_up(format_image_size(loader->info.format, width, height), format_size(loader->info.format)*4);
+  if (size >= data->staging_size) return NULL;
+
+  mtx_lock(&data->mutex);
+  VkDeviceSize offset = 0;
+  while (!_purrr_image_loader_vulkan_fits(data, size, &offset)) cnd_wait(&data->staging_cond, &data->mutex);
+
+  job->width = width;
+  job->height = height;
+  job->offset = offset;
+  job->size = size;
+  job->staged = true;
+  if (data->staged_last) data->staged_last->staged_next = job;
+  else data->staged_first = job;
+  data->staged_last = job;
+  data->staging_head = offset+size;
+  mtx_unlock(&data->mutex);
+
+  return data->staging_mapped+offset;
 }
 
-bool _purrr_buffer_vulkan_copy(_purrr_buffer_t *buffer, void *in_data, uint32_t size, uint32_t offset) {
-  if (!buffer || !buffer->initialized || !in_data) return false;
-  assert(size <= buffer->info.size);
-  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
-  if (!data || !renderer_data) return false;
+uint32_t _purrr_image_loader_vulkan_poll(_purrr_image_loader_t *loader) {
+  if (!loader || !loader->initialized) return 0;
+  _purrr_image_loader_data_t *data = (_purrr_image_loader_data_t*)loader->data_ptr;
+  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)loader->renderer->data_ptr;
+  assert(data && renderer_data);
 
-  VkBuffer staging_buffer;
-  VkDeviceMemory staging_buffer_memory;
-  if (!_purrr_renderer_vulkan_create_buffer(renderer_data, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &staging_buffer, &staging_buffer_memory)) return false;
+  for (size_t i = 0; i < data->batches.count;) {
+    _purrr_image_loader_batch_t batch = data->batches.items[i];
+    if (vkGetFenceStatus(renderer_data->device, batch.fence) != VK_SUCCESS) {
+      ++i;
+      continue;
+    }
 
-  void* buffer_data;
-  vkMapMemory(renderer_data->device, staging_buffer_memory, 0, size, 0, &buffer_data);
-    memcpy(buffer_data, in_data, (size_t)size);
-  vkUnmapMemory(renderer_data->device, staging_buffer_memory);
+    vkFreeCommandBuffers(renderer_data->device, renderer_data->command_pool, 1, &batch.cmd_buf);
+    vkDestroyFence(renderer_data->device, batch.fence, VK_NULL_HANDLE);
+    data->batches.items[i] = data->batches.items[--data->batches.count];
+    _purrr_image_loader_vulkan_finish(data, batch.jobs);
+  }
 
-  _purrr_renderer_vulkan_copy_buffer(renderer_data, staging_buffer, data->buffer, size, offset);
+  mtx_lock(&data->mutex);
+  _purrr_image_loader_job_t *ready = data->ready;
+  data->ready = NULL;
+  mtx_unlock(&data->mutex);
+
+  _purrr_image_loader_job_t *jobs = NULL, *failed = NULL;
+  while (ready) {
+    _purrr_image_loader_job_t *job = ready;
+    ready = job->next;
+
+    if (!job->failed) {
+      purrr_image_info_t image_info = {
+        .width = job->width,
+        .height = job->height,
+        .format = loader->info.format,
+        .mip_levels = loader->info.mip_levels,
+      };
+      job->image = (_purrr_image_t*)purrr_image_create(&image_info, (purrr_renderer_t*)loader->renderer);
 
-  vkDestroyBuffer(renderer_data->device, staging_buffer, VK_NULL_HANDLE);
-  vkFreeMemory(renderer_data->device, staging_buffer_memory, VK_NULL_HANDLE);
-  return true;
-}
+      purrr_texture_info_t texture_info = {
+        .image = (purrr_image_t*)job->image,
+        .sampler = loader->info.sampler,
+      };
+      if (job->image) job->texture = (_purrr_texture_t*)purrr_texture_create(&texture_info, (purrr_renderer_t*)loader->renderer);
+    }
 
-bool _purrr_buffer_vulkan_map(_purrr_buffer_t *buffer, void **out_data) {
-  if (!buffer || !buffer->initialized || !out_data) return false;
-  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
-  if (!data || !renderer_data) return false;
+    if (!job->texture) {
+      if (job->image) purrr_image_destroy((purrr_image_t*)job->image);
+      job->image = NULL;
+      job->next = failed;
+      failed = job;
+      continue;
+    }
 
-  return vkMapMemory(renderer_data->device, data->buffer_memory, 0, buffer->info.size, 0, out_data) == VK_SUCCESS;
-}
+    job->next = jobs;
+    jobs = job;
+  }
 
-bool _purrr_buffer_vulkan_unmap(_purrr_buffer_t *buffer) {
-  if (!buffer || !buffer->initialized) return false;
-  _purrr_buffer_data_t *data = (_purrr_buffer_data_t*)buffer->data_ptr;
-  _purrr_renderer_data_t *renderer_data = (_purrr_renderer_data_t*)buffer->renderer->data_ptr;
-  if (!data || !renderer_data) return false;
+  _purrr_image_loader_vulkan_finish(data, failed);
 
-  vkUnmapMemory(renderer_data->device, data->buffer_memory);
+  if (jobs) {
+    _purrr_image_loader_batch_t batch = { .jobs = jobs };
 
-  return true;
+    VkCommandBufferAllocateInfo alloc_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = renderer_data->command_pool,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+    };
+    VkCommandBufferBeginInfo begin_info = {
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkFenceCreateInfo fence_info = {
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    bool result = (vkAllocateCommandBuffers(renderer_data->device, &alloc_info, &batch.cmd_buf) == VK_SUCCESS &&
+                   vkCreateFence(renderer_data->device, &fence_info, VK_NULL_HANDLE, &batch.fence) == VK_SUCCESS &&
+                   vkBeginCommandBuffer(batch.cmd_buf, &begin_info) == VK_SUCCESS);
+
+    for (_purrr_image_loader_job_t *job = jobs; result && job; job = job->next) {
+      _purrr_image_data_t *image_data = (_purrr_image_data_t*)job->image->data_ptr;
+      _purrr_vulkan_cmd_transition_image_layout(batch.cmd_buf, image_data->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+      _purrr_renderer_vulkan_copy_buffer_to_image(batch.cmd_buf, data->staging_buffer, job->offset, image_data->image, 0, 1, job->width, job->height);
+
+      VkImageLayout layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      if (image_data->generate_mips) {
+        _purrr_vulkan_cmd_generate_mips(batch.cmd_buf, image_data->image, job->width, job->height, image_data->mip_levels, image_data->mip_filter);
+        layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      }
+      VkAccessFlags access;
+      VkPipelineStageFlags stage;
+      _purrr_image_vulkan_resting_access(image_data->layout, &access, &stage);
+      _purrr_vulkan_cmd_transition_image_layout(batch.cmd_buf, image_data->image, layout, image_data->layout, VK_ACCESS_TRANSFER_WRITE_BIT, access, VK_PIPELINE_STAGE_TRANSFER_BIT, stage);
+    }
+
+    VkSubmitInfo submit_info = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &batch.cmd_buf,
+    };
+    result = (result &&
+              vkEndCommandBuffer(batch.cmd_buf) == VK_SUCCESS &&
+              vkQueueSubmit(renderer_data->graphics_queue, 1, &submit_info, batch.fence) == VK_SUCCESS);
+
+    if (result) {
+      if (data->batches.count >= data->batches.capacity) {
+        data->batches.capacity = (data->batches.capacity?data->batches.capacity*2:4);
+        data->batches.items = (_purrr_image_loader_batch_t*)realloc(data->batches.items, sizeof(*data->batches.items)*data->batches.capacity);
+        assert(data->batches.items);
+      }
+      data->batches.items[data->batches.count++] = batch;
+    } else {
+      if (batch.cmd_buf) vkFreeCommandBuffers(renderer_data->device, renderer_data->command_pool, 1, &batch.cmd_buf);
+      if (batch.fence) vkDestroyFence(renderer_data->device, batch.fence, VK_NULL_HANDLE);
+      for (_purrr_image_loader_job_t *job = jobs; job; job = job->next) {
+        purrr_texture_destroy((purrr_texture_t*)job->texture);
+        purrr_image_destroy((purrr_image_t*)job->image);
+        job->texture = NULL;
+        job->image = NULL;
+      }
+      _purrr_image_loader_vulkan_finish(data, jobs);
+    }
+  }
+
+  mtx_lock(&data->mutex);
+  uint32_t pending = data->pending;
+  mtx_unlock(&data->mutex);
+  return pending;
 }
 
 // renderer
@@ -1441,10 +5926,20 @@ bool _purrr_renderer_create_swapchain(_purrr_renderer_t *renderer) {
       assert(data->swapchain_image_views);
     }
     for (uint8_t i = 0; i < renderer->info.image_count; i++) {
-      _purrr_vulkan_transition_image_layout(data, data->swapchain_images[i], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
       createInfo.image = data->swapchain_images[i];
       if (vkCreateImageView(data->device, &createInfo, VK_NULL_HANDLE, &data->swapchain_image_views[i]) != VK_SUCCESS) return false;
     }
+
+    // All transitions go into one barrier and one submission.
+    VkImageMemoryBarrier *barriers = (VkImageMemoryBarrier*)malloc(sizeof(*barriers) * renderer->info.image_count);
+    assert(barriers);
+    for (uint32_t i = 0; i < renderer->info.image_count; ++i)
+      barriers[i] = _purrr_vulkan_image_barrier(data->swapchain_images[i], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, VK_ACCESS_MEMORY_READ_BIT);
+
+    VkCommandBuffer cmd_buf = _purrr_vulkan_begin_single_time(data);
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE, renderer->info.image_count, barriers);
+    _purrr_vulkan_end_single_time(data, cmd_buf);
+    free(barriers);
   }
 
   if (renderer->info.swapchain_format) *renderer->info.swapchain_format = purrr_format(data->swapchain_format.format);
@@ -1456,8 +5951,13 @@ bool _purrr_renderer_create_swapchain(_purrr_renderer_t *renderer) {
     for (uint32_t i = 0; i < renderer->info.image_count; ++i) {
       _purrr_image_data_t *internal_image_data = (_purrr_image_data_t*)malloc(sizeof(*internal_image_data));
       assert(internal_image_data);
+      memset(internal_image_data, 0, sizeof(*internal_image_data));
       internal_image_data->image = data->swapchain_images[i];
       internal_image_data->image_view = data->swapchain_image_views[i];
+      internal_image_data->attachment_view = data->swapchain_image_views[i];
+      internal_image_data->usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+      internal_image_data->layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+      internal_image_data->mip_levels = 1;
 
       _purrr_image_t *internal_image = (_purrr_image_t*)malloc(sizeof(_purrr_image_t));
       assert(internal_image);
@@ -1504,17 +6004,208 @@ bool _purrr_renderer_recreate_swapchain(_purrr_renderer_t *renderer) {
     glfwWaitEvents();
   }
 
-  vkDeviceWaitIdle(((_purrr_renderer_data_t*)renderer->data_ptr)->device);
+  vkDeviceWaitIdle(((_purrr_renderer_data_t*)renderer->data_ptr)->device);
+
+  _purrr_renderer_cleanup_swapchain(renderer);
+  if (!_purrr_renderer_create_swapchain(renderer)) return false;
+
+  if (renderer->callbacks.resize) renderer->callbacks.resize((purrr_renderer_t*)renderer);
+
+  return true;
+}
+
+
+
+// Cache data starts with a VkPipelineCacheHeaderVersionOne, anything written by another device or driver is useless.
+static bool _purrr_renderer_vulkan_pipeline_cache_valid(_purrr_renderer_data_t *data, const uint8_t *bytes, size_t size) {
+  VkPipelineCacheHeaderVersionOne header = {0};
+  if (size < sizeof(header)) return false;
+  memcpy(&header, bytes, sizeof(header));
+
+  VkPhysicalDeviceProperties properties = {0};
+  vkGetPhysicalDeviceProperties(data->gpu, &properties);
+
+  return header.headerSize >= sizeof(header) && header.headerSize <= size &&
+         header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+         memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static bool _purrr_renderer_vulkan_create_pipeline_cache(_purrr_renderer_data_t *data, const char *path) {
+  size_t size = 0;
+  uint8_t *initial_data = (path?_purrr_vulkan_read_file(path, &size):NULL);
+  if (initial_data && !_purrr_renderer_vulkan_pipeline_cache_valid(data, initial_data, size)) {
+    free(initial_data);
+    initial_data = NULL;
+    size = 0;
+  }
+
+  VkPipelineCacheCreateInfo cache_info = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .initialDataSize = size,
+    .pInitialData = initial_data,
+  };
+
+  VkResult result = vkCreatePipelineCache(data->device, &cache_info, VK_NULL_HANDLE, &data->pipeline_cache);
+  free(initial_data);
+  return result == VK_SUCCESS;
+}
+
+// Writes into a temporary file first, so a crash halfway through doesn't leave a broken cache behind.
+static void _purrr_renderer_vulkan_save_pipeline_cache(_purrr_renderer_data_t *data, const char *path) {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(data->device, data->pipeline_cache, &size, VK_NULL_HANDLE) != VK_SUCCESS || size == 0) return;
+  uint8_t *bytes = (uint8_t*)malloc(size);
+  if (!bytes) return;
+  if (vkGetPipelineCacheData(data->device, data->pipeline_cache, &size, bytes) != VK_SUCCESS) {
+    free(bytes);
+    return;
+  }
+
+  size_t path_length = strlen(path);
+  char *temp_path = (char*)malloc(path_length+5);
+  assert(temp_path);
+  memcpy(temp_path, path, path_length);
+  memcpy(temp_path+path_length, ".tmp", 5);
+
+  FILE *fd = fopen(temp_path, "wb");
+  bool written = (fd && fwrite(bytes, size, 1, fd) == 1);
+  if (fd && fclose(fd) != 0) written = false;
+  free(bytes);
+
+  if (written) {
+#ifdef _WIN32
+    remove(path); // rename doesn't replace existing files here
+#endif
+    written = (rename(temp_path, path) == 0);
+  }
+  if (!written) remove(temp_path);
+  free(temp_path);
+}
+
+// Checks for the descriptor indexing features bindless textures need and fills in the ones to enable,
+// the array is clamped to what the device allows in a single stage.
+static bool _purrr_renderer_vulkan_bindless_support(_purrr_renderer_data_t *data, uint32_t requested, VkPhysicalDeviceDescriptorIndexingFeatures *enabled) {
+  PFN_vkGetPhysicalDeviceFeatures2 get_features2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(data->instance, "vkGetPhysicalDeviceFeatures2KHR");
+  PFN_vkGetPhysicalDeviceProperties2 get_properties2 = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(data->instance, "vkGetPhysicalDeviceProperties2KHR");
+  if (!get_features2 || !get_properties2) return false;
 
-  _purrr_renderer_cleanup_swapchain(renderer);
-  if (!_purrr_renderer_create_swapchain(renderer)) return false;
+  VkPhysicalDeviceDescriptorIndexingFeatures supported = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+  };
 
-  if (renderer->callbacks.resize) renderer->callbacks.resize((purrr_renderer_t*)renderer);
+  VkPhysicalDeviceFeatures2 features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    .pNext = &supported,
+  };
 
+  get_features2(data->gpu, &features);
+  if (!supported.descriptorBindingPartiallyBound || !supported.descriptorBindingSampledImageUpdateAfterBind ||
+      !supported.descriptorBindingUpdateUnusedWhilePending || !supported.runtimeDescriptorArray) return false;
+
+  VkPhysicalDeviceDescriptorIndexingProperties limits = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+  };
+
+  VkPhysicalDeviceProperties2 properties = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+    .pNext = &limits,
+  };
+
+  get_properties2(data->gpu, &properties);
+  uint32_t count = min(requested, min(limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSamplers));
+  count = min(count, min(limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSamplers));
+  if (count == 0) return false;
+
+  memset(enabled, 0, sizeof(*enabled));
+  enabled->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  enabled->descriptorBindingPartiallyBound = VK_TRUE;
+  enabled->descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  enabled->descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  enabled->runtimeDescriptorArray = VK_TRUE;
+  enabled->shaderSampledImageArrayNonUniformIndexing = supported.shaderSampledImageArrayNonUniformIndexing;
+
+  data->bindless.count = count;
   return true;
 }
 
+typedef struct {
+  VkPhysicalDeviceExtendedDynamicStateFeaturesEXT state1;
+  VkPhysicalDeviceExtendedDynamicState2FeaturesEXT state2;
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT state3;
+} _purrr_vulkan_dynamic_state_features_t;
+
+// Fills in the extended dynamic state features to enable and sets which of the dynamic states the device can set itself,
+// only the extensions in `properties` get queried.
+static void _purrr_renderer_vulkan_dynamic_state_support(_purrr_renderer_data_t *data, const VkExtensionProperties *properties, uint32_t count, _purrr_vulkan_dynamic_state_features_t *enabled) {
+  memset(enabled, 0, sizeof(*enabled));
+  data->native_dynamic_states = 0;
+
+  PFN_vkGetPhysicalDeviceFeatures2 get_features2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(data->instance, "vkGetPhysicalDeviceFeatures2KHR");
+  PFN_vkGetPhysicalDeviceProperties2 get_properties2 = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(data->instance, "vkGetPhysicalDeviceProperties2KHR");
+  if (!get_features2 || !get_properties2) return;
+
+  _purrr_vulkan_dynamic_state_features_t supported = {
+    .state1 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT, },
+    .state2 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT, },
+    .state3 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT, },
+  };
+  VkPhysicalDeviceExtendedDynamicState3PropertiesEXT state3_properties = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_PROPERTIES_EXT,
+  };
+
+  bool has_state1 = _purrr_vulkan_has_extension(properties, count, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+  bool has_state2 = _purrr_vulkan_has_extension(properties, count, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+  bool has_state3 = _purrr_vulkan_has_extension(properties, count, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+  if (!has_state1 && !has_state2 && !has_state3) return;
+
+  VkPhysicalDeviceFeatures2 features = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+  };
+  if (has_state1) {
+    supported.state1.pNext = features.pNext;
+    features.pNext = &supported.state1;
+  }
+  if (has_state2) {
+    supported.state2.pNext = features.pNext;
+    features.pNext = &supported.state2;
+  }
+  if (has_state3) {
+    supported.state3.pNext = features.pNext;
+    features.pNext = &supported.state3;
+
+    VkPhysicalDeviceProperties2 device_properties = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &state3_properties,
+    };
+    get_properties2(data->gpu, &device_properties);
+  }
+  get_features2(data->gpu, &features);
+
+  if (supported.state1.extendedDynamicState) {
+    enabled->state1.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    enabled->state1.extendedDynamicState = VK_TRUE;
+    data->native_dynamic_states |= PURRR_DYNAMIC_STATE_CULL_MODE | PURRR_DYNAMIC_STATE_FRONT_FACE |
+                                   PURRR_DYNAMIC_STATE_DEPTH_TEST | PURRR_DYNAMIC_STATE_DEPTH_WRITE |
+                                   PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP | PURRR_DYNAMIC_STATE_STENCIL_TEST;
+    // Otherwise only topologies of the pipeline's class (points, lines or triangles) could be set
+    if (state3_properties.dynamicPrimitiveTopologyUnrestricted) data->native_dynamic_states |= PURRR_DYNAMIC_STATE_TOPOLOGY;
+  }
+
+  if (supported.state2.extendedDynamicState2) {
+    enabled->state2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+    enabled->state2.extendedDynamicState2 = VK_TRUE;
+    data->native_dynamic_states |= PURRR_DYNAMIC_STATE_DEPTH_BIAS;
+  }
 
+  if (supported.state3.extendedDynamicState3PolygonMode || supported.state3.extendedDynamicState3ColorBlendEnable) {
+    enabled->state3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    enabled->state3.extendedDynamicState3PolygonMode = supported.state3.extendedDynamicState3PolygonMode;
+    enabled->state3.extendedDynamicState3ColorBlendEnable = supported.state3.extendedDynamicState3ColorBlendEnable;
+    if (enabled->state3.extendedDynamicState3PolygonMode) data->native_dynamic_states |= PURRR_DYNAMIC_STATE_POLYGON_MODE;
+    if (enabled->state3.extendedDynamicState3ColorBlendEnable) data->native_dynamic_states |= PURRR_DYNAMIC_STATE_BLEND;
+  }
+}
 
 bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
   if (!renderer || !glfwVulkanSupported()) return false;
@@ -1525,16 +6216,28 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
   {
     strs_t extensions = {0};
     strs_t layers = {0};
+    bool properties2 = false;
 
     { // Load GLFW extensions
       uint32_t count = 0;
       const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&count);
       extensions.count = count;
-      extensions.items = (const char **)malloc(sizeof(*extensions.items)*(extensions.capacity = (count + 1)));
+      extensions.items = (const char **)malloc(sizeof(*extensions.items)*(extensions.capacity = (count + 2)));
       assert(extensions.items);
       memcpy(extensions.items, glfw_extensions, sizeof(*glfw_extensions)*count);
     }
 
+    { // Needed for VK_EXT_memory_budget
+      uint32_t count = 0;
+      vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, VK_NULL_HANDLE);
+      VkExtensionProperties *properties = (VkExtensionProperties*)malloc(sizeof(*properties)*count);
+      assert(properties || count == 0);
+      vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, properties);
+      properties2 = _purrr_vulkan_has_extension(properties, count, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+      if (properties2) extensions.items[extensions.count++] = VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME;
+      free(properties);
+    }
+
     #ifdef PURRR_DEBUG
       extensions.items[extensions.count++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
       layers.items = malloc(sizeof(*layers.items)*8);
@@ -1554,13 +6257,20 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
     if (layers.count > 0) free(layers.items);
 
     if (result != VK_SUCCESS) goto error;
+
+    if (properties2) data->get_memory_properties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(data->instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
   }
 
   {
     if (glfwCreateWindowSurface(data->instance, ((_purrr_window_t*)renderer->info.window)->window, VK_NULL_HANDLE, &data->surface) != VK_SUCCESS) goto error;
   }
 
-  const char *device_extensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+  const char *device_extensions[10] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+  uint32_t device_extension_count = 1;
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {0};
+  _purrr_vulkan_dynamic_state_features_t dynamic_state_features = {0};
+  bool update_templates = false;
+  bool push_descriptors = false;
   {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(data->instance, &deviceCount, VK_NULL_HANDLE);
@@ -1581,14 +6291,46 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
     if (best_score == 0) goto error;
 
     if (!_purrr_renderer_vulkan_find_queue_families(data->surface, data->gpu, &data->graphics_family, &data->present_family)) goto error;
+    data->transfer_family = _purrr_renderer_vulkan_find_transfer_family(data->gpu, data->graphics_family);
+
+    {
+      uint32_t count = 0;
+      vkEnumerateDeviceExtensionProperties(data->gpu, VK_NULL_HANDLE, &count, VK_NULL_HANDLE);
+      VkExtensionProperties *properties = (VkExtensionProperties*)malloc(sizeof(*properties)*count);
+      assert(properties || count == 0);
+      vkEnumerateDeviceExtensionProperties(data->gpu, VK_NULL_HANDLE, &count, properties);
+      if (data->get_memory_properties2) {
+        data->memory_budget = _purrr_vulkan_has_extension(properties, count, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (data->memory_budget) device_extensions[device_extension_count++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        if (renderer->info.bindless_texture_count &&
+            _purrr_vulkan_has_extension(properties, count, VK_KHR_MAINTENANCE3_EXTENSION_NAME) &&
+            _purrr_vulkan_has_extension(properties, count, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+            _purrr_renderer_vulkan_bindless_support(data, renderer->info.bindless_texture_count, &indexing_features)) {
+          device_extensions[device_extension_count++] = VK_KHR_MAINTENANCE3_EXTENSION_NAME;
+          device_extensions[device_extension_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+        }
+        push_descriptors = _purrr_vulkan_has_extension(properties, count, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+        if (push_descriptors) device_extensions[device_extension_count++] = VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME;
+        _purrr_renderer_vulkan_dynamic_state_support(data, properties, count, &dynamic_state_features);
+        if (dynamic_state_features.state1.sType) device_extensions[device_extension_count++] = VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME;
+        if (dynamic_state_features.state2.sType) device_extensions[device_extension_count++] = VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME;
+        if (dynamic_state_features.state3.sType) device_extensions[device_extension_count++] = VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME;
+      }
+      update_templates = _purrr_vulkan_has_extension(properties, count, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+      if (update_templates) device_extensions[device_extension_count++] = VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME;
+      data->creation_feedback = _purrr_vulkan_has_extension(properties, count, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+      if (data->creation_feedback) device_extensions[device_extension_count++] = VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME;
+      free(properties);
+    }
   }
 
   {
     uint32_t unique_count = 1;
-    uint32_t uniques[] = { data->graphics_family, data->present_family };
-    if (data->graphics_family != data->present_family) ++unique_count;
+    uint32_t uniques[3] = { data->graphics_family };
+    if (data->present_family != data->graphics_family) uniques[unique_count++] = data->present_family;
+    if (data->transfer_family != data->graphics_family && data->transfer_family != data->present_family) uniques[unique_count++] = data->transfer_family;
 
-    VkDeviceQueueCreateInfo queueCreateInfos[2] = {0};
+    VkDeviceQueueCreateInfo queueCreateInfos[3] = {0};
 
     float queuePriority = 1.0f;
     for (uint32_t i = 0; i < unique_count; ++i) {
@@ -1598,13 +6340,37 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
       queueCreateInfos[i].pQueuePriorities = &queuePriority;
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures = {0};
+    vkGetPhysicalDeviceFeatures(data->gpu, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {0};
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    deviceFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+    deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+    deviceFeatures.fillModeNonSolid = supportedFeatures.fillModeNonSolid;
+    deviceFeatures.depthBiasClamp = supportedFeatures.depthBiasClamp;
+    deviceFeatures.independentBlend = supportedFeatures.independentBlend;
+    data->features = deviceFeatures;
+
     VkDeviceCreateInfo createInfo = {0};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = (data->bindless.count?&indexing_features:NULL);
+    // Only the features of the extensions being enabled go into the chain
+    void **features_next = (void**)&createInfo.pNext;
+    if (data->bindless.count) features_next = &indexing_features.pNext;
+    if (dynamic_state_features.state1.sType) {
+      *features_next = &dynamic_state_features.state1;
+      features_next = &dynamic_state_features.state1.pNext;
+    }
+    if (dynamic_state_features.state2.sType) {
+      *features_next = &dynamic_state_features.state2;
+      features_next = &dynamic_state_features.state2.pNext;
+    }
+    if (dynamic_state_features.state3.sType) *features_next = &dynamic_state_features.state3;
     createInfo.pQueueCreateInfos = queueCreateInfos;
     createInfo.queueCreateInfoCount = unique_count;
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = sizeof(device_extensions)/sizeof(device_extensions[0]);
+    createInfo.enabledExtensionCount = device_extension_count;
     createInfo.ppEnabledExtensionNames = device_extensions;
     #ifdef PURRR_DEBUG
     createInfo.enabledLayerCount = 1;
@@ -1618,6 +6384,57 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
 
     vkGetDeviceQueue(data->device, data->graphics_family, 0, &data->graphics_queue);
     vkGetDeviceQueue(data->device, data->present_family, 0, &data->present_queue);
+    vkGetDeviceQueue(data->device, data->transfer_family, 0, &data->transfer_queue);
+
+    if (update_templates) {
+      data->create_update_template = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(data->device, "vkCreateDescriptorUpdateTemplateKHR");
+      data->destroy_update_template = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(data->device, "vkDestroyDescriptorUpdateTemplateKHR");
+      data->update_with_template = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(data->device, "vkUpdateDescriptorSetWithTemplateKHR");
+      if (!data->create_update_template || !data->destroy_update_template || !data->update_with_template) data->create_update_template = NULL;
+    }
+    if (push_descriptors) data->cmd_push_descriptor_set = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(data->device, "vkCmdPushDescriptorSetKHR");
+
+    // A state the device was meant to set but has no command for gets baked like on any other device
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_CULL_MODE) {
+      data->cmd_set_cull_mode = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetCullModeEXT");
+      if (!data->cmd_set_cull_mode) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_CULL_MODE;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_FRONT_FACE) {
+      data->cmd_set_front_face = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetFrontFaceEXT");
+      if (!data->cmd_set_front_face) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_FRONT_FACE;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_TOPOLOGY) {
+      data->cmd_set_primitive_topology = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetPrimitiveTopologyEXT");
+      if (!data->cmd_set_primitive_topology) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_TOPOLOGY;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_POLYGON_MODE) {
+      data->cmd_set_polygon_mode = (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetPolygonModeEXT");
+      if (!data->cmd_set_polygon_mode) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_POLYGON_MODE;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_DEPTH_TEST) {
+      data->cmd_set_depth_test_enable = (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetDepthTestEnableEXT");
+      if (!data->cmd_set_depth_test_enable) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_DEPTH_TEST;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_DEPTH_WRITE) {
+      data->cmd_set_depth_write_enable = (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetDepthWriteEnableEXT");
+      if (!data->cmd_set_depth_write_enable) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_DEPTH_WRITE;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP) {
+      data->cmd_set_depth_compare_op = (PFN_vkCmdSetDepthCompareOpEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetDepthCompareOpEXT");
+      if (!data->cmd_set_depth_compare_op) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_DEPTH_BIAS) {
+      data->cmd_set_depth_bias_enable = (PFN_vkCmdSetDepthBiasEnableEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetDepthBiasEnableEXT");
+      if (!data->cmd_set_depth_bias_enable) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_DEPTH_BIAS;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_STENCIL_TEST) {
+      data->cmd_set_stencil_test_enable = (PFN_vkCmdSetStencilTestEnableEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetStencilTestEnableEXT");
+      if (!data->cmd_set_stencil_test_enable) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_STENCIL_TEST;
+    }
+    if (data->native_dynamic_states & PURRR_DYNAMIC_STATE_BLEND) {
+      data->cmd_set_color_blend_enable = (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(data->device, "vkCmdSetColorBlendEnableEXT");
+      if (!data->cmd_set_color_blend_enable) data->native_dynamic_states &= ~PURRR_DYNAMIC_STATE_BLEND;
+    }
   }
 
   {
@@ -1628,8 +6445,15 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
     };
 
     if (vkCreateCommandPool(data->device, &pool_info, VK_NULL_HANDLE, &data->command_pool) != VK_SUCCESS) return false;
+
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = data->transfer_family;
+    if (vkCreateCommandPool(data->device, &pool_info, VK_NULL_HANDLE, &data->transfer_command_pool) != VK_SUCCESS) return false;
   }
 
+  if (!_purrr_vulkan_allocator_init(data)) return false;
+  if (!_purrr_vulkan_staging_init(data)) return false;
+
   data->frame_index = 0;
   data->image_index = 0;
   renderer->data_ptr = data;
@@ -1672,24 +6496,6 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
     }
   }
 
-  {
-    VkDescriptorPoolSize pool_sizes[] = {
-      (VkDescriptorPoolSize){
-        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        .descriptorCount = 2048, // TODO: Customize?
-      },
-    };
-
-    VkDescriptorPoolCreateInfo pool_info = {
-      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-      .poolSizeCount = sizeof(pool_sizes)/sizeof(pool_sizes[0]),
-      .pPoolSizes = pool_sizes,
-      .maxSets = 2048,
-    };
-
-    if (vkCreateDescriptorPool(data->device, &pool_info, VK_NULL_HANDLE, &data->descriptor_pool) != VK_SUCCESS) return false;
-  }
-
   {
     VkDescriptorSetLayoutBinding binding = {
       .binding = 0,
@@ -1710,7 +6516,7 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
   {
     VkDescriptorSetLayoutBinding binding = {
       .binding = 0,
-      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
       .descriptorCount = 1,
       .stageFlags = VK_SHADER_STAGE_ALL,
     };
@@ -1727,7 +6533,7 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
   {
     VkDescriptorSetLayoutBinding binding = {
       .binding = 0,
-      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
       .descriptorCount = 1,
       .stageFlags = VK_SHADER_STAGE_ALL,
     };
@@ -1741,6 +6547,12 @@ bool _purrr_renderer_vulkan_init(_purrr_renderer_t *renderer) {
     if (vkCreateDescriptorSetLayout(data->device, &layout_info, VK_NULL_HANDLE, &data->storage_descriptor_set_layout) != VK_SUCCESS) return false;
   }
 
+  if (!_purrr_vulkan_bindless_init(data)) return false;
+
+  if (!_purrr_renderer_vulkan_create_pipeline_cache(data, renderer->info.pipeline_cache_path)) return false;
+
+  if (!_purrr_vulkan_transient_init(data, renderer->info.transient_size?renderer->info.transient_size:PURRR_VULKAN_TRANSIENT_SIZE)) return false;
+
   renderer->initialized = true;
 
   return true;
@@ -1754,6 +6566,8 @@ void _purrr_renderer_vulkan_cleanup(_purrr_renderer_t *renderer) {
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   if (!data) return;
   if (renderer->initialized) {
+    _purrr_vulkan_compiler_stop(data);
+
     for (uint8_t i = 0; i < 2; ++i) {
       vkDestroySemaphore(data->device, data->render_semaphores[i], VK_NULL_HANDLE);
       vkDestroySemaphore(data->device, data->image_semaphores[i], VK_NULL_HANDLE);
@@ -1763,11 +6577,23 @@ void _purrr_renderer_vulkan_cleanup(_purrr_renderer_t *renderer) {
     vkDestroyDescriptorSetLayout(data->device, data->texture_descriptor_set_layout, VK_NULL_HANDLE);
     vkDestroyDescriptorSetLayout(data->device, data->uniform_descriptor_set_layout, VK_NULL_HANDLE);
     vkDestroyDescriptorSetLayout(data->device, data->storage_descriptor_set_layout, VK_NULL_HANDLE);
-    vkDestroyDescriptorPool(data->device, data->descriptor_pool, VK_NULL_HANDLE);
-
+    _purrr_vulkan_descriptors_cleanup(data);
+    _purrr_vulkan_bindless_cleanup(data);
+    _purrr_vulkan_set_layouts_cleanup(data);
+
+    _purrr_vulkan_staging_cleanup(data);
+    _purrr_vulkan_transient_cleanup(data);
+    _purrr_vulkan_readback_cleanup(data);
+    free(data->streamed_textures.items);
+    free(data->preinitialized.items);
     vkDestroyCommandPool(data->device, data->command_pool, VK_NULL_HANDLE);
+    vkDestroyCommandPool(data->device, data->transfer_command_pool, VK_NULL_HANDLE);
 
     _purrr_renderer_cleanup_swapchain(renderer);
+    _purrr_vulkan_allocator_cleanup(data);
+    if (renderer->info.pipeline_cache_path) _purrr_renderer_vulkan_save_pipeline_cache(data, renderer->info.pipeline_cache_path);
+    vkDestroyPipelineCache(data->device, data->pipeline_cache, VK_NULL_HANDLE);
+    free(data->pipelines.items);
     vkDestroyDevice(data->device, VK_NULL_HANDLE);
     vkDestroySurfaceKHR(data->instance, data->surface, VK_NULL_HANDLE);
     vkDestroyInstance(data->instance, VK_NULL_HANDLE);
@@ -1813,6 +6639,93 @@ uint32_t _purrr_renderer_vulkan_get_sample_counts(_purrr_renderer_t *renderer, p
   return i;
 }
 
+bool _purrr_renderer_vulkan_is_format_supported(_purrr_renderer_t *renderer, purrr_format_t format) {
+  if (!renderer || !renderer->initialized) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+
+  // Compressed families need their device feature, no matter what the format properties say.
+  if (format >= PURRR_FORMAT_BC1U && format <= PURRR_FORMAT_BC7RGB && !data->features.textureCompressionBC) return false;
+  if (format >= PURRR_FORMAT_ETC2RGB8U && format <= PURRR_FORMAT_ETC2RGBA8RGB && !data->features.textureCompressionETC2) return false;
+  if (format >= PURRR_FORMAT_ASTC4x4U && format <= PURRR_FORMAT_ASTC4x4RGB && !data->features.textureCompressionASTC_LDR) return false;
+
+  VkFormat vk = vk_format(data, format);
+  if (vk == VK_FORMAT_UNDEFINED) return false;
+
+  VkFormatProperties props = {0};
+  vkGetPhysicalDeviceFormatProperties(data->gpu, vk, &props);
+  VkFormatFeatureFlags required = (format == PURRR_FORMAT_DEPTH?VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT:VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+  return (props.optimalTilingFeatures & required) == required;
+}
+
+// Bytes the streamed textures may take up: whatever the driver's budget has left over plus what they already hold.
+static VkDeviceSize _purrr_renderer_vulkan_texture_budget(_purrr_renderer_t *renderer) {
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  if (renderer->info.texture_budget) return (VkDeviceSize)renderer->info.texture_budget;
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+  };
+  VkPhysicalDeviceMemoryProperties2 properties = {
+    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+    .pNext = (data->memory_budget?&budget:NULL),
+  };
+  if (data->get_memory_properties2) data->get_memory_properties2(data->gpu, &properties);
+  else vkGetPhysicalDeviceMemoryProperties(data->gpu, &properties.memoryProperties);
+
+  VkDeviceSize total = 0, used = 0;
+  for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; ++i) {
+    if (!(properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+    if (data->memory_budget) {
+      total += budget.heapBudget[i];
+      used += budget.heapUsage[i];
+    } else total += properties.memoryProperties.memoryHeaps[i].size/2;
+  }
+
+  if (!data->memory_budget) return total;
+  used = ((used > data->streamed_size)?used - data->streamed_size:0);
+  return ((total > used)?total - used:0);
+}
+
+static int _purrr_texture_vulkan_compare_last_used(const void *a, const void *b) {
+  uint64_t last_a = ((_purrr_texture_data_t*)(*(_purrr_texture_t**)a)->data_ptr)->last_used;
+  uint64_t last_b = ((_purrr_texture_data_t*)(*(_purrr_texture_t**)b)->data_ptr)->last_used;
+  return (last_a > last_b) - (last_a < last_b);
+}
+
+// Brings back the textures bound while evicted (most recently used first) and evicts in LRU order until
+// everything fits. Only textures no frame in flight was recorded with can go, so this runs after the fence wait.
+static void _purrr_renderer_vulkan_update_residency(_purrr_renderer_t *renderer) {
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  _purrr_vulkan_streamed_textures_t *streamed = &data->streamed_textures;
+  if (streamed->count == 0) return;
+
+  VkDeviceSize budget = _purrr_renderer_vulkan_texture_budget(renderer);
+  qsort(streamed->items, streamed->count, sizeof(*streamed->items), _purrr_texture_vulkan_compare_last_used);
+
+  size_t victim = 0;
+  for (size_t i = streamed->count; i-- > 0;) {
+    _purrr_texture_t *texture = streamed->items[i];
+    _purrr_texture_data_t *texture_data = (_purrr_texture_data_t*)texture->data_ptr;
+    if (!texture_data->requested) continue;
+
+    for (; victim < i && data->streamed_size + texture_data->size > budget; ++victim) {
+      _purrr_texture_data_t *victim_data = (_purrr_texture_data_t*)streamed->items[victim]->data_ptr;
+      if (victim_data->last_used + 2 > data->frame_counter) break;
+      if (victim_data->resident) _purrr_texture_vulkan_evict(data, streamed->items[victim]);
+    }
+    if (data->streamed_size + texture_data->size > budget) break;
+
+    _purrr_texture_vulkan_restore(data, texture);
+  }
+
+  for (; victim < streamed->count && data->streamed_size > budget; ++victim) {
+    _purrr_texture_data_t *victim_data = (_purrr_texture_data_t*)streamed->items[victim]->data_ptr;
+    if (victim_data->last_used + 2 > data->frame_counter) break;
+    if (victim_data->resident) _purrr_texture_vulkan_evict(data, streamed->items[victim]);
+  }
+}
+
 bool _purrr_renderer_vulkan_begin_frame(_purrr_renderer_t *renderer, uint32_t *image_index) {
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   assert(renderer->initialized && data);
@@ -1823,7 +6736,12 @@ bool _purrr_renderer_vulkan_begin_frame(_purrr_renderer_t *renderer, uint32_t *i
   if (result == VK_ERROR_OUT_OF_DATE_KHR) return _purrr_renderer_recreate_swapchain(renderer) && _purrr_renderer_vulkan_begin_frame(renderer, image_index);
   else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) return false;
 
-  vkResetFences(data->device, 1, &data->flight_fences[data->frame_index]);
+  _purrr_vulkan_transient_reset(data, data->frame_index);
+
+  ++data->frame_counter;
+  _purrr_vulkan_readback_reset(data, data->frame_index);
+  _purrr_vulkan_descriptor_collect(data);
+  _purrr_renderer_vulkan_update_residency(renderer);
 
   data->active_cmd_buf = data->render_cmd_bufs[data->frame_index];
 
@@ -1834,33 +6752,37 @@ bool _purrr_renderer_vulkan_begin_frame(_purrr_renderer_t *renderer, uint32_t *i
   };
 
   if (vkBeginCommandBuffer(data->active_cmd_buf, &begin_info) != VK_SUCCESS) return false;
+  _purrr_vulkan_cmd_transition_preinitialized(data, data->active_cmd_buf);
 
   return true;
 }
 
-bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _purrr_render_target_t *render_target) {
+bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _purrr_render_target_t *render_target, const purrr_clear_value_t *clear_values, uint32_t clear_value_count) {
   if (!renderer || !render_target || !renderer->initialized || !render_target->initialized) return false;
 
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
-  _purrr_pipeline_descriptor_data_t *pipeline_descriptor_data = (_purrr_pipeline_descriptor_data_t*)render_target->descriptor->data_ptr;
   _purrr_render_target_data_t *render_target_data = (_purrr_render_target_data_t*)render_target->data_ptr;
 
-  VkRenderPass render_pass = pipeline_descriptor_data->render_pass;
+  VkRenderPass render_pass = render_target_data->render_pass;
   VkFramebuffer framebuffer = render_target_data->framebuffer;
-
-  uint32_t color_count = render_target->descriptor->info.color_attachment_count;
-  uint32_t clear_value_count = color_count*(render_target->descriptor->info.resolve_attachments?2:1)+(render_target->descriptor->info.depth_attachment?1:0);
-  VkClearValue *clear_values = malloc(sizeof(*clear_values)*clear_value_count);
-  assert(clear_values);
-
-  VkClearColorValue clear_color = {
-    .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } // TODO: Let user decide
-  };
-  VkClearDepthStencilValue clear_depth = { 1.0f, 0 };
-
-  uint32_t i = 0;
-  for (; i < color_count; ++i) clear_values[i] = (VkClearValue){ clear_color };
-  if (i < clear_value_count) clear_values[i] = (VkClearValue){ .depthStencil = clear_depth };
+  for (uint32_t i = 0; i < render_target->image_count; ++i)
+    _purrr_image_vulkan_mark_used(data, (render_target->info.images?(_purrr_image_t*)render_target->info.images[i]:render_target->images[i]));
+
+  // Attachment indices match the render target's images, so resolves get a (unused) value as well.
+  VkClearValue vk_clear_values[PURRR_MAX_COLOR_ATTACHMENTS*2+1];
+  uint32_t color_count = render_target->descriptor->info.color_attachment_count*(render_target->descriptor->info.resolve_attachments?2:1);
+  uint32_t attachment_count = color_count+(render_target->descriptor->info.depth_attachment?1:0);
+  assert(attachment_count <= sizeof(vk_clear_values)/sizeof(vk_clear_values[0]));
+
+  for (uint32_t i = 0; i < attachment_count; ++i) {
+    if (i < color_count) {
+      vk_clear_values[i].color = (VkClearColorValue){ .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } };
+      if (i < clear_value_count) memcpy(vk_clear_values[i].color.float32, clear_values[i].color, sizeof(clear_values[i].color));
+    } else {
+      vk_clear_values[i].depthStencil = (VkClearDepthStencilValue){ 1.0f, 0 };
+      if (i < clear_value_count) vk_clear_values[i].depthStencil = (VkClearDepthStencilValue){ clear_values[i].depth_stencil.depth, clear_values[i].depth_stencil.stencil };
+    }
+  }
 
   VkRect2D area = (VkRect2D){
     .offset = (VkOffset2D){0},
@@ -1872,8 +6794,8 @@ bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _pu
     render_pass,
     framebuffer,
     area,
-    clear_value_count,
-    clear_values,
+    attachment_count,
+    vk_clear_values,
   };
 
   vkCmdBeginRenderPass(data->active_cmd_buf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
@@ -1891,8 +6813,6 @@ bool _purrr_renderer_vulkan_begin_render_target(_purrr_renderer_t *renderer, _pu
   vkCmdSetScissor(data->active_cmd_buf, 0, 1, &area);
   data->active_render_target = render_target;
 
-  free(clear_values);
-
   return true;
 }
 
@@ -1903,9 +6823,29 @@ bool _purrr_renderer_vulkan_bind_pipeline(_purrr_renderer_t *renderer, _purrr_pi
   assert(data && pipeline_data);
   if (!data->active_cmd_buf || !data->active_render_target) return false;
 
-  vkCmdBindPipeline(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline);
+  // Until it's compiled, the fallback is bound instead or the draws are skipped.
+  bool ready = _purrr_pipeline_vulkan_ready(data, pipeline_data);
+  _purrr_pipeline_t *fallback = (_purrr_pipeline_t*)pipeline->info.fallback;
+  if (!ready && fallback && fallback->initialized && _purrr_pipeline_vulkan_ready(data, (_purrr_pipeline_data_t*)fallback->data_ptr)) {
+    pipeline = fallback;
+    pipeline_data = (_purrr_pipeline_data_t*)fallback->data_ptr;
+    ready = true;
+  }
+
+  if (ready) vkCmdBindPipeline(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline);
+
+  // The dynamic states start out as the pipeline's state block says, every one of them is set before the next draw.
+  data->bound_pipeline = (ready?pipeline_data->pipeline:VK_NULL_HANDLE);
+  data->dynamic_values = pipeline_data->values;
+  data->dynamic_dirty = PURRR_VULKAN_DYNAMIC_STATES;
+
+  // There's only the one texture array, so it goes into every slot that takes it right away.
+  for (uint32_t i = 0; pipeline_data->texture_array_slots >> i; ++i)
+    if ((pipeline_data->texture_array_slots >> i) & 1)
+      vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, i, 1, &data->bindless.set, 0, VK_NULL_HANDLE);
 
   data->active_pipeline = pipeline;
+  data->skip_draws = !ready;
 
   return true;
 }
@@ -1918,18 +6858,86 @@ bool _purrr_renderer_vulkan_bind_texture(_purrr_renderer_t *renderer, _purrr_tex
   if (!data->active_cmd_buf || !data->active_render_target || !data->active_render_target->initialized || !data->active_pipeline || !data->active_pipeline->initialized || slot_index >= data->active_pipeline->info.descriptor_slot_count) return false;
   _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
   assert(pipeline_data);
+  if (slot_index < 32 && (((pipeline_data->texture_array_slots | pipeline_data->push_slots) >> slot_index) & 1)) return false;
+
+  VkDescriptorSet set = texture_data->descriptor_set.set;
+  _purrr_image_vulkan_mark_used(data, (_purrr_image_t*)texture->info.image);
+  if (texture_data->placeholder) {
+    texture_data->last_used = data->frame_counter;
+    if (!texture_data->resident) {
+      texture_data->requested = true;
+      set = texture_data->placeholder_set.set;
+    }
+  }
 
-  vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &texture_data->descriptor_set, 0, NULL);
+  vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &set, 0, NULL);
 
   return true;
 }
 
+static VkDescriptorSet _purrr_buffer_vulkan_get_range_set(_purrr_renderer_data_t *data, _purrr_buffer_t *buffer, VkDeviceSize offset, VkDeviceSize size) {
+  _purrr_buffer_data_t *buffer_data = (_purrr_buffer_data_t*)buffer->data_ptr;
+  if (size == buffer->info.size) return buffer_data->set.set;
+
+  // A bigger range is fine as long as every dynamic offset it's bound at keeps it inside the buffer and the limit.
+  VkDeviceSize max_range = (buffer->info.type == PURRR_BUFFER_TYPE_UNIFORM)?data->uniform_max_range:data->storage_max_range;
+  VkDeviceSize range = 1;
+  while (range < size) range <<= 1;
+  if (offset + range > buffer->info.size || range > max_range) range = size;
+
+  _purrr_buffer_range_sets_t *sets = &buffer_data->range_sets;
+  for (size_t i = 0; i < sets->count; ++i)
+    if (sets->items[i].range == range) return sets->items[i].set.set;
+
+  VkDescriptorSetLayout layout = (buffer->info.type == PURRR_BUFFER_TYPE_UNIFORM)?data->uniform_descriptor_set_layout:data->storage_descriptor_set_layout;
+  VkDescriptorBufferInfo buffer_info = {
+    .buffer = buffer_data->buffer,
+    .offset = 0,
+    .range = range,
+  };
+
+  if (sets->count >= PURRR_VULKAN_RANGE_SET_MAX) {
+    VkDescriptorSet set;
+    if (!_purrr_vulkan_transient_allocate_set(data, layout, &set)) return VK_NULL_HANDLE;
+    VkWriteDescriptorSet write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = set,
+      .dstBinding = 0,
+      .descriptorCount = 1,
+      .descriptorType = vk_descriptor_type(buffer->info.type),
+      .pBufferInfo = &buffer_info,
+    };
+    vkUpdateDescriptorSets(data->device, 1, &write, 0, NULL);
+    return set;
+  }
+
+  if (sets->count >= sets->capacity) {
+    size_t capacity = (sets->capacity?sets->capacity*2:4);
+    _purrr_buffer_range_set_t *items = (_purrr_buffer_range_set_t*)realloc(sets->items, sizeof(*items)*capacity);
+    if (!items) return VK_NULL_HANDLE;
+    sets->items = items;
+    sets->capacity = capacity;
+  }
+
+  _purrr_buffer_range_set_t *range_set = &sets->items[sets->count];
+  range_set->range = range;
+  if (!_purrr_vulkan_descriptor_acquire(data, layout, vk_descriptor_type(buffer->info.type), NULL, &buffer_info, &range_set->set)) return VK_NULL_HANDLE;
+  ++sets->count;
+  return range_set->set.set;
+}
+
 bool _purrr_renderer_vulkan_bind_buffer(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index) {
+  if (!buffer) return false;
+  return _purrr_renderer_vulkan_bind_buffer_range(renderer, buffer, slot_index, 0, buffer->info.size);
+}
+
+bool _purrr_renderer_vulkan_bind_buffer_range(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size) {
   if (!renderer || !renderer->initialized || !buffer || !buffer->initialized) return false;
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   _purrr_buffer_data_t *buffer_data = (_purrr_buffer_data_t*)buffer->data_ptr;
   assert(data && buffer_data);
   assert(buffer->info.type < COUNT_PURRR_BUFFER_TYPES);
+  if (!size || (uint64_t)offset + size > buffer->info.size) return false;
 
   if (!data->active_cmd_buf || !data->active_render_target || !data->active_render_target->initialized || !data->active_pipeline || !data->active_pipeline->initialized) return false;
 
@@ -1937,24 +6945,205 @@ bool _purrr_renderer_vulkan_bind_buffer(_purrr_renderer_t *renderer, _purrr_buff
   case PURRR_BUFFER_TYPE_UNIFORM:
   case PURRR_BUFFER_TYPE_STORAGE: {
     if (slot_index >= data->active_pipeline->info.descriptor_slot_count) return false;
+    VkDeviceSize alignment = (buffer->info.type == PURRR_BUFFER_TYPE_UNIFORM)?data->uniform_offset_alignment:data->storage_offset_alignment;
+    VkDeviceSize max_range = (buffer->info.type == PURRR_BUFFER_TYPE_UNIFORM)?data->uniform_max_range:data->storage_max_range;
+    if (offset % alignment || size > max_range) return false;
+    _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
+    assert(pipeline_data);
+    if (slot_index < 32 && ((pipeline_data->push_slots >> slot_index) & 1)) return false;
+
+    VkDescriptorSet set = _purrr_buffer_vulkan_get_range_set(data, buffer, offset, size);
+    if (!set) return false;
+
+    vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &set, 1, &offset);
+  } break;
+  case PURRR_BUFFER_TYPE_VERTEX: {
+    if (slot_index != 0) return false;
+    VkDeviceSize vertex_offset = offset;
+    vkCmdBindVertexBuffers(data->active_cmd_buf, slot_index, 1, &buffer_data->buffer, &vertex_offset);
+  } break;
+  case PURRR_BUFFER_TYPE_INDEX: {
+    if (offset % sizeof(uint32_t)) return false; // A multiple of the index size
+    vkCmdBindIndexBuffer(data->active_cmd_buf, buffer_data->buffer, offset, VK_INDEX_TYPE_UINT32);
+  } break;
+  case COUNT_PURRR_BUFFER_TYPES:
+  default: return false;
+  }
+
+  return true;
+}
+
+bool _purrr_renderer_vulkan_bind_descriptor_set(_purrr_renderer_t *renderer, _purrr_descriptor_set_t *set, uint32_t slot_index) {
+  if (!renderer || !renderer->initialized || !set || !set->initialized) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  _purrr_descriptor_set_data_t *set_data = (_purrr_descriptor_set_data_t*)set->data_ptr;
+  assert(data && set_data);
+  if (!data->active_cmd_buf || !data->active_render_target || !data->active_pipeline || !data->active_pipeline->initialized || !set_data->set) return false;
+  _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
+  assert(pipeline_data);
+  if (slot_index >= pipeline_data->set_layout_count || pipeline_data->set_layouts[slot_index] != set_data->layout->layout) return false;
+
+  vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &set_data->set, 0, VK_NULL_HANDLE);
+
+  set_data->bound = true;
+  set_data->last_bound = data->frame_counter;
+
+  return true;
+}
+
+bool _purrr_renderer_vulkan_alloc_transient(_purrr_renderer_t *renderer, uint32_t size, uint32_t align, void **ptr, purrr_transient_binding_t *binding) {
+  if (!renderer || !renderer->initialized || !ptr || !binding || !size) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+  if (!data->active_cmd_buf) return false;
+
+  // Offsets have to work for any kind of binding, so `align` is combined with the dynamic offset alignment.
+  VkDeviceSize alignment = data->transient_alignment;
+  if (align > 1) alignment = alignment / _purrr_vulkan_gcd(alignment, align) * align;
+
+  _purrr_vulkan_transient_t *transient = &data->transients[data->frame_index];
+  VkDeviceSize offset = _purrr_vulkan_align_up(transient->head, alignment);
+  if (offset + size > transient->size) return false;
+  transient->head = offset + size;
+
+  *ptr = transient->mapped + offset;
+  binding->buffer = transient;
+  binding->offset = (uint32_t)offset;
+  binding->size = size;
+  return true;
+}
+
+bool _purrr_renderer_vulkan_transfer_image(_purrr_renderer_t *renderer, const purrr_image_transfer_info_t *info) {
+  if (!renderer || !renderer->initialized || !info) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+  if (!data->active_cmd_buf || data->active_render_target) return false;
+  if (!info->dst || ((_purrr_image_t*)info->dst)->renderer != renderer) return false;
+  if (!_purrr_vulkan_cmd_transfer_image(data->active_cmd_buf, info)) return false;
+  _purrr_image_vulkan_mark_used(data, (_purrr_image_t*)info->dst);
+  if (info->src) _purrr_image_vulkan_mark_used(data, (_purrr_image_t*)info->src);
+  return true;
+}
+
+bool _purrr_renderer_vulkan_bind_transient(_purrr_renderer_t *renderer, const purrr_transient_binding_t *binding, purrr_buffer_type_t type, uint32_t slot_index) {
+  if (!renderer || !renderer->initialized || !binding || !binding->buffer) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+  _purrr_vulkan_transient_t *transient = (_purrr_vulkan_transient_t*)binding->buffer;
+  if (transient != &data->transients[data->frame_index]) return false; // Allocated in another frame
+
+  if (!data->active_cmd_buf || !data->active_render_target || !data->active_render_target->initialized || !data->active_pipeline || !data->active_pipeline->initialized) return false;
+
+  switch (type) {
+  case PURRR_BUFFER_TYPE_UNIFORM:
+  case PURRR_BUFFER_TYPE_STORAGE: {
+    if (slot_index >= data->active_pipeline->info.descriptor_slot_count || binding->size > data->transient_range) return false;
     _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
     assert(pipeline_data);
+    if (slot_index < 32 && ((pipeline_data->push_slots >> slot_index) & 1)) return false;
 
-    vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &buffer_data->set, 0, NULL);
+    VkDescriptorSet set = (type == PURRR_BUFFER_TYPE_UNIFORM)?transient->uniform_set:transient->storage_set;
+    vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &set, 1, &binding->offset);
   } break;
   case PURRR_BUFFER_TYPE_VERTEX: {
     if (slot_index != 0) return false;
-    VkDeviceSize offset = 0;
-    vkCmdBindVertexBuffers(data->active_cmd_buf, slot_index, 1, &buffer_data->buffer, &offset);
+    VkDeviceSize offset = binding->offset;
+    vkCmdBindVertexBuffers(data->active_cmd_buf, slot_index, 1, &transient->buffer, &offset);
   } break;
   case PURRR_BUFFER_TYPE_INDEX: {
-    vkCmdBindIndexBuffer(data->active_cmd_buf, buffer_data->buffer, 0, VK_INDEX_TYPE_UINT32);
+    if (binding->offset % sizeof(uint32_t)) return false;
+    vkCmdBindIndexBuffer(data->active_cmd_buf, transient->buffer, binding->offset, VK_INDEX_TYPE_UINT32);
   } break;
+  case COUNT_PURRR_BUFFER_TYPES:
+  default: return false;
+  }
+
+  return true;
+}
+
+// Pushes `info` with VK_KHR_push_descriptor if the slot uses it, otherwise writes it into a set that lives for the frame.
+static bool _purrr_renderer_vulkan_push_descriptor(_purrr_renderer_data_t *data, uint32_t slot_index, purrr_descriptor_type_t type, const _purrr_vulkan_descriptor_info_t *info) {
+  if (!data->active_cmd_buf || !data->active_render_target || !data->active_pipeline || !data->active_pipeline->initialized) return false;
+  _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
+  assert(pipeline_data);
+  if (slot_index >= 32 || !((pipeline_data->push_slots >> slot_index) & 1)) return false;
+
+  bool push = (slot_index == pipeline_data->push_set);
+  const _purrr_vulkan_set_layout_t *layout = _purrr_vulkan_set_layout_get(data, &type, 1, push);
+  if (!layout || layout->layout != pipeline_data->set_layouts[slot_index]) return false;
+
+  if (push) {
+    VkWriteDescriptorSet descriptor_write = {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstBinding = 0,
+      .dstArrayElement = 0,
+      .descriptorType = vk_set_descriptor_type(type),
+      .descriptorCount = 1,
+      .pImageInfo = &info->image,
+      .pBufferInfo = &info->buffer,
+    };
+
+    data->cmd_push_descriptor_set(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &descriptor_write);
+    return true;
   }
 
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  if (!_purrr_vulkan_transient_allocate_set(data, layout->layout, &set)) return false;
+  _purrr_vulkan_set_layout_update(data, layout, set, info);
+  vkCmdBindDescriptorSets(data->active_cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_data->pipeline_layout, slot_index, 1, &set, 0, VK_NULL_HANDLE);
+
   return true;
 }
 
+bool _purrr_renderer_vulkan_push_texture(_purrr_renderer_t *renderer, _purrr_texture_t *texture, uint32_t slot_index) {
+  if (!renderer || !renderer->initialized || !texture || !texture->initialized) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  _purrr_texture_data_t *texture_data = (_purrr_texture_data_t*)texture->data_ptr;
+  assert(data && texture_data);
+
+  _purrr_image_t *image = (_purrr_image_t*)texture->info.image;
+  if (texture_data->placeholder) {
+    texture_data->last_used = data->frame_counter;
+    if (!texture_data->resident) {
+      texture_data->requested = true;
+      image = (_purrr_image_t*)texture_data->placeholder;
+    }
+  }
+
+  _purrr_image_vulkan_mark_used(data, image);
+  _purrr_image_data_t *image_data = (_purrr_image_data_t*)image->data_ptr;
+  _purrr_vulkan_descriptor_info_t info = {
+    .image = {
+      .sampler = ((_purrr_sampler_data_t*)((_purrr_sampler_t*)texture->info.sampler)->data_ptr)->sampler,
+      .imageView = image_data->image_view,
+      .imageLayout = image_data->layout,
+    },
+  };
+
+  return _purrr_renderer_vulkan_push_descriptor(data, slot_index, PURRR_DESCRIPTOR_TYPE_TEXTURE, &info);
+}
+
+bool _purrr_renderer_vulkan_push_buffer(_purrr_renderer_t *renderer, _purrr_buffer_t *buffer, uint32_t slot_index, uint32_t offset, uint32_t size) {
+  if (!renderer || !renderer->initialized || !buffer || !buffer->initialized) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+
+  purrr_descriptor_type_t type = PURRR_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  if (buffer->info.type == PURRR_BUFFER_TYPE_STORAGE) type = PURRR_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  else if (buffer->info.type != PURRR_BUFFER_TYPE_UNIFORM) return false;
+
+  purrr_descriptor_write_t write = {
+    .buffer = (purrr_buffer_t*)buffer,
+    .offset = offset,
+    .size = size,
+  };
+
+  _purrr_vulkan_descriptor_info_t info = {0};
+  if (!_purrr_descriptor_set_vulkan_fill(data, type, &write, &info)) return false;
+
+  return _purrr_renderer_vulkan_push_descriptor(data, slot_index, type, &info);
+}
+
 bool _purrr_renderer_vulkan_push_constant(_purrr_renderer_t *renderer, uint32_t offset, uint32_t size, const void *value) {
   if (!renderer || !renderer->initialized || !value || !size) return false;
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
@@ -1969,11 +7158,114 @@ bool _purrr_renderer_vulkan_push_constant(_purrr_renderer_t *renderer, uint32_t
   return true;
 }
 
+// Only recorded here, the commands (or the variant) go out with the next draw.
+bool _purrr_renderer_vulkan_set_dynamic_state(_purrr_renderer_t *renderer, purrr_dynamic_state_t state, uint32_t index, uint32_t value) {
+  if (!renderer || !renderer->initialized) return false;
+  _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
+  assert(data);
+  if (!data->active_cmd_buf || !data->active_render_target || !data->active_pipeline || !data->active_pipeline->initialized) return false;
+
+  _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
+  assert(pipeline_data);
+  if (!(pipeline_data->dynamic_states & state)) return false;
+
+  _purrr_vulkan_dynamic_values_t *values = &data->dynamic_values;
+  switch (state) {
+  case PURRR_DYNAMIC_STATE_CULL_MODE: {
+    if (value >= COUNT_PURRR_CULL_MODES) return false;
+    values->cull_mode = vk_cull_mode((purrr_cull_mode_t)value);
+  } break;
+  case PURRR_DYNAMIC_STATE_FRONT_FACE: {
+    if (value >= COUNT_PURRR_FRONT_FACES) return false;
+    values->front_face = vk_front_face((purrr_front_face_t)value);
+  } break;
+  case PURRR_DYNAMIC_STATE_TOPOLOGY: {
+    if (value >= COUNT_PURRR_PRIMITIVE_TOPOLOGIES) return false;
+    values->topology = vk_primitive_topology((purrr_primitive_topology_t)value);
+  } break;
+  case PURRR_DYNAMIC_STATE_POLYGON_MODE: {
+    if (value >= COUNT_PURRR_POLYGON_MODES) return false;
+    if (value != PURRR_POLYGON_MODE_FILL && !data->features.fillModeNonSolid) return false;
+    values->polygon_mode = vk_polygon_mode((purrr_polygon_mode_t)value);
+  } break;
+  case PURRR_DYNAMIC_STATE_DEPTH_TEST: values->depth_test = (value != 0); break;
+  case PURRR_DYNAMIC_STATE_DEPTH_WRITE: values->depth_write = (value != 0); break;
+  case PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP: {
+    if (value >= COUNT_PURRR_COMPARE_OPS) return false;
+    values->depth_compare_op = vk_compare_op((purrr_compare_op_t)value);
+  } break;
+  case PURRR_DYNAMIC_STATE_DEPTH_BIAS: values->depth_bias = (value != 0); break;
+  case PURRR_DYNAMIC_STATE_STENCIL_TEST: values->stencil_test = (value != 0); break;
+  case PURRR_DYNAMIC_STATE_BLEND: {
+    if (index >= pipeline_data->color_attachment_count || index >= 32) return false;
+    if (!((pipeline_data->blend_attachments >> index) & 1)) return false; // It would blend with zeroed factors
+    // Without independent blending all the attachments have to blend alike
+    uint32_t bits = (data->features.independentBlend?(1u << index):UINT32_MAX);
+    if (value) values->blend_enables |= bits;
+    else values->blend_enables &= ~bits;
+  } break;
+  default: return false;
+  }
+
+  data->dynamic_dirty |= state;
+
+  return true;
+}
+
+// Brings the command buffer up to date with the dynamic state before a draw. `ready` is set to false if the
+// variant for the baked states is still compiling, the state stays dirty so the next draw tries again.
+static bool _purrr_renderer_vulkan_flush_dynamic_state(_purrr_renderer_data_t *data, bool *ready) {
+  _purrr_pipeline_data_t *pipeline_data = (_purrr_pipeline_data_t*)data->active_pipeline->data_ptr;
+  assert(pipeline_data);
+  purrr_dynamic_state_t dirty = data->dynamic_dirty & pipeline_data->dynamic_states;
+  if (!dirty) return true;
+
+  const _purrr_vulkan_dynamic_values_t *values = &data->dynamic_values;
+  VkCommandBuffer cmd_buf = data->active_cmd_buf;
+  purrr_dynamic_state_t native = dirty & data->native_dynamic_states;
+  if (native & PURRR_DYNAMIC_STATE_CULL_MODE)        data->cmd_set_cull_mode(cmd_buf, values->cull_mode);
+  if (native & PURRR_DYNAMIC_STATE_FRONT_FACE)       data->cmd_set_front_face(cmd_buf, values->front_face);
+  if (native & PURRR_DYNAMIC_STATE_TOPOLOGY)         data->cmd_set_primitive_topology(cmd_buf, values->topology);
+  if (native & PURRR_DYNAMIC_STATE_POLYGON_MODE)     data->cmd_set_polygon_mode(cmd_buf, values->polygon_mode);
+  if (native & PURRR_DYNAMIC_STATE_DEPTH_TEST)       data->cmd_set_depth_test_enable(cmd_buf, values->depth_test);
+  if (native & PURRR_DYNAMIC_STATE_DEPTH_WRITE)      data->cmd_set_depth_write_enable(cmd_buf, values->depth_write);
+  if (native & PURRR_DYNAMIC_STATE_DEPTH_COMPARE_OP) data->cmd_set_depth_compare_op(cmd_buf, values->depth_compare_op);
+  if (native & PURRR_DYNAMIC_STATE_DEPTH_BIAS)       data->cmd_set_depth_bias_enable(cmd_buf, values->depth_bias);
+  if (native & PURRR_DYNAMIC_STATE_STENCIL_TEST)     data->cmd_set_stencil_test_enable(cmd_buf, values->stencil_test);
+  if ((native & PURRR_DYNAMIC_STATE_BLEND) && pipeline_data->color_attachment_count > 0) {
+    VkBool32 enables[32] = {0};
+    uint32_t count = min(pipeline_data->color_attachment_count, 32);
+    for (uint32_t i = 0; i < count; ++i) enables[i] = (values->blend_enables >> i) & 1;
+    data->cmd_set_color_blend_enable(cmd_buf, 0, count, enables);
+  }
+
+  if (dirty & pipeline_data->baked_states) {
+    VkPipeline variant;
+    if (!_purrr_pipeline_vulkan_variant(data, pipeline_data, values, &variant)) return false;
+    if (!variant) {
+      *ready = false;
+      return true;
+    }
+    if (variant != data->bound_pipeline) {
+      vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, variant);
+      data->bound_pipeline = variant;
+    }
+  }
+
+  data->dynamic_dirty = 0;
+
+  return true;
+}
+
 bool _purrr_renderer_vulkan_draw(_purrr_renderer_t *renderer, uint32_t instance_count, uint32_t first_instance, uint32_t vertex_count, uint32_t first_vertex) {
   if (!renderer || !renderer->initialized) return false;
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   assert(data);
   if (!data->active_cmd_buf || !data->active_render_target || !data->active_pipeline || !data->active_pipeline->initialized) return false;
+  if (data->skip_draws) return true;
+  bool ready = true;
+  if (!_purrr_renderer_vulkan_flush_dynamic_state(data, &ready)) return false;
+  if (!ready) return true; // Skipped like draws with a pipeline that is still compiling
   vkCmdDraw(data->active_cmd_buf, vertex_count, instance_count, first_vertex, first_instance);
   return true;
 }
@@ -1983,6 +7275,10 @@ bool _purrr_renderer_vulkan_draw_indexed(_purrr_renderer_t *renderer, uint32_t i
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   assert(data);
   if (!data->active_cmd_buf || !data->active_render_target || !data->active_pipeline || !data->active_pipeline->initialized) return false;
+  if (data->skip_draws) return true;
+  bool ready = true;
+  if (!_purrr_renderer_vulkan_flush_dynamic_state(data, &ready)) return false;
+  if (!ready) return true; // Skipped like draws with a pipeline that is still compiling
   vkCmdDrawIndexed(data->active_cmd_buf, index_count, instance_count, first_index, first_instance, vertex_offset);
   return true;
 }
@@ -2025,6 +7321,8 @@ bool _purrr_renderer_vulkan_end_frame(_purrr_renderer_t *renderer) {
       .pSignalSemaphores = signal_semaphores,
     };
 
+    // Only reset here, so the fence of the frame being recorded stays signaled and can be waited on.
+    vkResetFences(data->device, 1, &data->flight_fences[data->frame_index]);
     if (vkQueueSubmit(data->graphics_queue, 1, &submit_info, data->flight_fences[data->frame_index]) != VK_SUCCESS) return false;
 
     VkPresentInfoKHR present_info = {
@@ -2053,6 +7351,7 @@ bool _purrr_renderer_vulkan_wait(_purrr_renderer_t *renderer) {
   _purrr_renderer_data_t *data = (_purrr_renderer_data_t*)renderer->data_ptr;
   assert(data);
   vkDeviceWaitIdle(data->device);
+  _purrr_vulkan_staging_reclaim(data, false);
   return true;
 }
 